@@ -30,10 +30,97 @@
 //#else
 #include "Features/IModularFeatures.h"
 //#endif
+#include "ProfilingDebugging/CsvProfiler.h"
 
 DEFINE_LOG_CATEGORY(LogVRMotionController);
 //For UE4 Profiler ~ Stat
 DECLARE_CYCLE_STAT(TEXT("TickGrip ~ TickingGrip"), STAT_TickGrip, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ SubmitAsyncSweeps"), STAT_SubmitAsyncGripSweeps, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ ApplyKinematicTargets"), STAT_ApplyKinematicTargets, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ GetGripWorldTransform"), STAT_GetGripWorldTransform, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ SecondaryGripTransform"), STAT_SecondaryGripTransform, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ GripSweeps"), STAT_GripSweeps, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ UpdatePhysicsHandles"), STAT_UpdatePhysicsHandles, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ SetUpPhysicsHandle"), STAT_SetUpPhysicsHandle, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ InterfaceTickGrip"), STAT_GripInterfaceTick, STATGROUP_TickGrip);
+DECLARE_CYCLE_STAT(TEXT("TickGrip ~ GatherLateUpdatePrimitives"), STAT_GatherLateUpdatePrimitives, STATGROUP_TickGrip);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grips ~ Physics"), STAT_PhysicsGrips, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grips ~ Sweep"), STAT_SweepGrips, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grips ~ PhysicsOnly / SweepWithPhysics"), STAT_PhysicsOnlyGrips, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grips ~ Manipulation"), STAT_ManipulationGrips, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grips ~ Attachment"), STAT_AttachmentGrips, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Grips ~ Custom"), STAT_CustomGrips, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sweeps ~ Issued"), STAT_GripSweepsIssued, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sweeps ~ Hits"), STAT_GripSweepHits, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PhysicsHandles ~ Created"), STAT_PhysicsHandlesCreated, STATGROUP_TickGrip);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PhysicsHandles ~ Destroyed"), STAT_PhysicsHandlesDestroyed, STATGROUP_TickGrip);
+
+// Everything in the grip stat group also goes out to the csv profiler under VRGrip so grip cost can be tracked per map in csv captures
+CSV_DEFINE_CATEGORY(VRGrip, true);
+
+#define VRGRIP_SCOPED_TIMING(StatName) \
+	SCOPE_CYCLE_COUNTER(STAT_##StatName); \
+	CSV_SCOPED_TIMING_STAT(VRGrip, StatName)
+
+#define VRGRIP_INC_COUNTER(StatName, Amount) \
+	INC_DWORD_STAT_BY(STAT_##StatName, Amount); \
+	CSV_CUSTOM_STAT(VRGrip, StatName, (int32)(Amount), ECsvCustomStatOp::Accumulate)
+
+// Counts a grip collision sweep and returns whether it hit, so it can wrap the call
+static inline bool CountGripSweep(bool bHit)
+{
+	VRGRIP_INC_COUNTER(GripSweepsIssued, 1);
+
+	if (bHit)
+	{
+		VRGRIP_INC_COUNTER(GripSweepHits, 1);
+	}
+
+	return bHit;
+}
+
+static inline void CountGripType(EGripCollisionType GripCollisionType)
+{
+	switch (GripCollisionType)
+	{
+	case EGripCollisionType::InteractiveCollisionWithPhysics:
+	case EGripCollisionType::InteractiveHybridCollisionWithPhysics:
+	{
+		VRGRIP_INC_COUNTER(PhysicsGrips, 1);
+	}break;
+	case EGripCollisionType::InteractiveCollisionWithSweep:
+	case EGripCollisionType::InteractiveHybridCollisionWithSweep:
+	{
+		VRGRIP_INC_COUNTER(SweepGrips, 1);
+	}break;
+	case EGripCollisionType::SweepWithPhysics:
+	case EGripCollisionType::PhysicsOnly:
+	{
+		VRGRIP_INC_COUNTER(PhysicsOnlyGrips, 1);
+	}break;
+	case EGripCollisionType::ManipulationGrip:
+	case EGripCollisionType::ManipulationGripWithWristTwist:
+	{
+		VRGRIP_INC_COUNTER(ManipulationGrips, 1);
+	}break;
+	case EGripCollisionType::AttachmentGrip:
+	{
+		VRGRIP_INC_COUNTER(AttachmentGrips, 1);
+	}break;
+	case EGripCollisionType::CustomGrip:
+	default:
+	{
+		VRGRIP_INC_COUNTER(CustomGrips, 1);
+	}break;
+	}
+}
+
+// Async results are only trusted for a frame, anything older is from a sweep that didn't get resubmitted
+static inline bool IsAsyncGripSweepFresh(const FGripAsyncSweep & Sweep)
+{
+	return Sweep.bHasResult && (GFrameCounter - Sweep.ResultFrame) <= 1;
+}
 
 // MAGIC NUMBERS
 // Constraint multipliers for angular, to avoid having to have two sets of stiffness/damping variables
@@ -62,6 +149,186 @@ namespace GripMotionControllerCvars
 		ECVF_Default);
 }
 
+#if WITH_PHYSX
+// World level batch for physics grip kinematic targets. Controllers queue their targets while ticking in PrePhysics and a tick function that the
+// worlds StartPhysics tick depends on applies all of them right before the simulation starts, taking each scenes write lock once instead of per grip.
+class FVRGripPhysicsBatch
+{
+	struct FPendingKinematicTarget
+	{
+		int32 SceneIndex;
+		PxRigidDynamic * KinActor;
+		PxTransform Target;
+	};
+
+	struct FBatchTickFunction : public FTickFunction
+	{
+		TWeakObjectPtr<UWorld> World;
+
+		virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override
+		{
+			if (UWorld * MyWorld = World.Get())
+				FVRGripPhysicsBatch::Flush(MyWorld);
+		}
+
+		virtual FString DiagnosticMessage() override
+		{
+			return TEXT("FVRGripPhysicsBatch::FBatchTickFunction");
+		}
+	};
+
+	struct FWorldBatch
+	{
+		TUniquePtr<FBatchTickFunction> TickFunction;
+		TArray<FPendingKinematicTarget> Targets;
+		TMap<PxRigidDynamic *, int32> TargetIndex;
+		uint64 RegisteredFrame;
+
+		FWorldBatch() :
+			RegisteredFrame(0)
+		{}
+	};
+
+	static TMap<TWeakObjectPtr<UWorld>, FWorldBatch> WorldBatches;
+	static FDelegateHandle WorldCleanupHandle;
+
+public:
+
+	// Returns false if the target can't be batched and should be applied immediately instead
+	static bool QueueKinematicTarget(UWorld * World, int32 SceneIndex, PxRigidDynamic * KinActor, const PxTransform & Target)
+	{
+		// Only batch while the world is ticking ahead of physics, paused grips and blueprint calls outside of the tick apply immediately
+		if (!World || !World->bInTick || World->TickGroup >= TG_StartPhysics || !World->PersistentLevel)
+			return false;
+
+		FWorldBatch * Batch = WorldBatches.Find(World);
+		if (!Batch)
+		{
+			if (!WorldCleanupHandle.IsValid())
+				WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddStatic(&FVRGripPhysicsBatch::OnWorldCleanup);
+
+			Batch = &WorldBatches.Add(World);
+			Batch->TickFunction = MakeUnique<FBatchTickFunction>();
+			Batch->RegisteredFrame = GFrameCounter;
+
+			FBatchTickFunction & TickFunction = *Batch->TickFunction;
+			TickFunction.World = World;
+			TickFunction.bCanEverTick = true;
+			TickFunction.bTickEvenWhenPaused = true;
+			TickFunction.bHighPriority = true;
+			TickFunction.TickGroup = TG_StartPhysics;
+			TickFunction.RegisterTickFunction(World->PersistentLevel);
+			World->StartPhysicsTickFunction.AddPrerequisite(World, TickFunction);
+		}
+
+		// A tick function registered mid frame isn't guaranteed to run before physics this frame
+		if (Batch->RegisteredFrame == GFrameCounter)
+			return false;
+
+		// Last target wins if a handle gets moved more than once in a frame
+		if (int32 * Existing = Batch->TargetIndex.Find(KinActor))
+		{
+			Batch->Targets[*Existing].Target = Target;
+			return true;
+		}
+
+		Batch->TargetIndex.Add(KinActor, Batch->Targets.Num());
+		FPendingKinematicTarget & Pending = Batch->Targets[Batch->Targets.AddUninitialized()];
+		Pending.SceneIndex = SceneIndex;
+		Pending.KinActor = KinActor;
+		Pending.Target = Target;
+		return true;
+	}
+
+	// Drops a queued target, needs to be called before a kinematic actor is released or its pose is set directly
+	static void RemoveKinematicTarget(UWorld * World, PxRigidDynamic * KinActor)
+	{
+		FWorldBatch * Batch = World ? WorldBatches.Find(World) : nullptr;
+		if (!Batch)
+			return;
+
+		int32 Index = INDEX_NONE;
+		if (Batch->TargetIndex.RemoveAndCopyValue(KinActor, Index))
+			Batch->Targets[Index].KinActor = nullptr;
+	}
+
+	// Caller needs to hold the scene write lock
+	static void ApplyKinematicTarget(PxRigidDynamic * KinActor, const PxTransform & Target)
+	{
+		const PxTransform CurrentPose = KinActor->getGlobalPose();
+
+		// Don't call moveKinematic if it hasn't changed - that will stop bodies from going to sleep.
+		const bool bChangedPosition = (Target.p - CurrentPose.p).magnitudeSquared() > 0.01f*0.01f;
+		const bool bChangedRotation = FMath::Abs(Target.q.dot(CurrentPose.q)) <= (1.f - SMALL_NUMBER);
+
+		if (bChangedPosition || bChangedRotation)
+			KinActor->setKinematicTarget(Target);
+	}
+
+private:
+
+	static void Flush(UWorld * World)
+	{
+		FWorldBatch * Batch = WorldBatches.Find(World);
+		if (!Batch || !Batch->Targets.Num())
+			return;
+
+		VRGRIP_SCOPED_TIMING(ApplyKinematicTargets);
+
+		TArray<FPendingKinematicTarget> & Targets = Batch->Targets;
+
+		// Group by scene so that each one is only locked once
+		Targets.Sort([](const FPendingKinematicTarget & A, const FPendingKinematicTarget & B)
+		{
+			return A.SceneIndex < B.SceneIndex;
+		});
+
+		int32 SceneStart = 0;
+		while (SceneStart < Targets.Num())
+		{
+			const int32 SceneIndex = Targets[SceneStart].SceneIndex;
+			int32 SceneEnd = SceneStart;
+			while (SceneEnd < Targets.Num() && Targets[SceneEnd].SceneIndex == SceneIndex)
+				++SceneEnd;
+
+			if (PxScene * PScene = GetPhysXSceneFromIndex(SceneIndex))
+			{
+				SCOPED_SCENE_WRITE_LOCK(PScene);
+				for (int32 i = SceneStart; i < SceneEnd; ++i)
+				{
+					if (Targets[i].KinActor)
+						ApplyKinematicTarget(Targets[i].KinActor, Targets[i].Target);
+				}
+			}
+
+			SceneStart = SceneEnd;
+		}
+
+		Targets.Reset();
+		Batch->TargetIndex.Reset();
+	}
+
+	static void OnWorldCleanup(UWorld * World, bool bSessionEnded, bool bCleanupResources)
+	{
+		if (FWorldBatch * Batch = WorldBatches.Find(World))
+		{
+			World->StartPhysicsTickFunction.RemovePrerequisite(World, *Batch->TickFunction);
+			Batch->TickFunction->UnRegisterTickFunction();
+			WorldBatches.Remove(World);
+		}
+
+		if (!WorldBatches.Num() && WorldCleanupHandle.IsValid())
+		{
+			FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+			WorldCleanupHandle.Reset();
+		}
+	}
+};
+
+TMap<TWeakObjectPtr<UWorld>, FVRGripPhysicsBatch::FWorldBatch> FVRGripPhysicsBatch::WorldBatches;
+FDelegateHandle FVRGripPhysicsBatch::WorldCleanupHandle;
+#endif // WITH_PHYSX
+
   //=============================================================================
 UGripMotionControllerComponent::UGripMotionControllerComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -78,6 +345,7 @@ UGripMotionControllerComponent::UGripMotionControllerComponent(const FObjectInit
 	bHasAuthority = false;
 	bUseWithoutTracking = false;
 	bAlwaysSendTickGrip = false;
+	bUseAsyncGripSweeps = false;
 	bAutoActivate = true;
 
 	this->SetIsReplicated(true);
@@ -90,11 +358,23 @@ UGripMotionControllerComponent::UGripMotionControllerComponent(const FObjectInit
 	bLerpingPosition = false;
 	bSmoothReplicatedMotion = false;
 	bReppedOnce = false;
+	LastRemoteUpdateTime = 0.0;
+	RemoteLerpDuration = 0.0f;
 	bOffsetByHMD = false;
 	bIsPostTeleport = false;
 
 	GripIDIncrementer = 0;
 
+	bUseFastArrayGripReplication = false;
+	FastGrippedObjects.OwningController = this;
+	FastLocallyGrippedObjects.OwningController = this;
+
+	bGripIndexDirty = true;
+	bPhysicsGripIndexDirty = true;
+	IndexedGripCount = 0;
+	IndexedLocalGripCount = 0;
+	IndexedPhysicsGripCount = 0;
+
 	bOffsetByControllerProfile = true;
 	GripRenderThreadProfileTransform = FTransform::Identity;
 	CurrentControllerProfileTransform = FTransform::Identity;
@@ -176,6 +456,7 @@ void UGripMotionControllerComponent::OnUnregister()
 		//DropObject(GrippedObjects[i].GrippedObject, false);	
 	}
 	GrippedObjects.Empty();
+	MarkGripIndexDirty();
 
 	for (int i = 0; i < LocallyGrippedObjects.Num(); i++)
 	{
@@ -184,12 +465,16 @@ void UGripMotionControllerComponent::OnUnregister()
 		//DropObject(LocallyGrippedObjects[i].GrippedObject, false);
 	}
 	LocallyGrippedObjects.Empty();
+	MarkGripIndexDirty();
 
 	for (int i = 0; i < PhysicsGrips.Num(); i++)
 	{
 		DestroyPhysicsHandle(PhysicsGrips[i].SceneIndex, &PhysicsGrips[i].HandleData, &PhysicsGrips[i].KinActorData);
 	}
 	PhysicsGrips.Empty();
+	MarkPhysicsGripIndexDirty();
+
+	AsyncGripSweeps.Empty();
 
 	Super::OnUnregister();
 }
@@ -233,21 +518,184 @@ void UGripMotionControllerComponent::SendRenderTransform_Concurrent()
 	Super::SendRenderTransform_Concurrent();
 }
 
+void FBPActorGripInformation::PreReplicatedRemove(const FBPActorGripArray & InArraySerializer)
+{
+	if (InArraySerializer.OwningController)
+		InArraySerializer.OwningController->OnFastGripReplicatedRemove(InArraySerializer, *this);
+}
+
+void FBPActorGripInformation::PostReplicatedAdd(const FBPActorGripArray & InArraySerializer)
+{
+	if (InArraySerializer.OwningController)
+		InArraySerializer.OwningController->OnFastGripReplicated(InArraySerializer, *this);
+}
+
+void FBPActorGripInformation::PostReplicatedChange(const FBPActorGripArray & InArraySerializer)
+{
+	if (InArraySerializer.OwningController)
+		InArraySerializer.OwningController->OnFastGripReplicated(InArraySerializer, *this);
+}
+
+void UGripMotionControllerComponent::SyncFastGripArray(const TArray<FBPActorGripInformation> & SourceArray, FBPActorGripArray & FastArray)
+{
+	// Remove dropped grips
+	for (int32 i = FastArray.Items.Num() - 1; i >= 0; --i)
+	{
+		if (!SourceArray.Contains(FastArray.Items[i]))
+		{
+			FastArray.Items.RemoveAt(i);
+			FastArray.MarkArrayDirty();
+		}
+	}
+
+	UScriptStruct * GripStruct = FBPActorGripInformation::StaticStruct();
+
+	for (const FBPActorGripInformation & Grip : SourceArray)
+	{
+		FBPActorGripInformation * FastGrip = FastArray.Items.FindByKey(Grip);
+		if (!FastGrip)
+		{
+			FastGrip = &FastArray.Items[FastArray.Items.AddDefaulted()];
+			FastGrip->RepCopy(Grip);
+			FastArray.MarkItemDirty(*FastGrip);
+			continue;
+		}
+
+		// Compare the replicated values only, anything that was edited in place gets caught here without needing to be flagged
+		FBPActorGripInformation RepGrip = *FastGrip;
+		RepGrip.RepCopy(Grip);
+
+		if (!GripStruct->CompareScriptStruct(&RepGrip, FastGrip, PPF_None))
+		{
+			FastGrip->RepCopy(Grip);
+			FastArray.MarkItemDirty(*FastGrip);
+		}
+	}
+}
+
+void UGripMotionControllerComponent::RebuildGripIndex()
+{
+	GripIDIndex.Reset();
+	GrippedObjectIndex.Reset();
+
+	// Walk backwards with locals first so that the first match in GrippedObjects is the one left in the index, same as FindByKey
+	for (int i = LocallyGrippedObjects.Num() - 1; i >= 0; --i)
+	{
+		GripIDIndex.Add(LocallyGrippedObjects[i].GripID, ~i);
+		if (LocallyGrippedObjects[i].GrippedObject)
+			GrippedObjectIndex.Add(LocallyGrippedObjects[i].GrippedObject, ~i);
+	}
+
+	for (int i = GrippedObjects.Num() - 1; i >= 0; --i)
+	{
+		GripIDIndex.Add(GrippedObjects[i].GripID, i);
+		if (GrippedObjects[i].GrippedObject)
+			GrippedObjectIndex.Add(GrippedObjects[i].GrippedObject, i);
+	}
+
+	IndexedGripCount = GrippedObjects.Num();
+	IndexedLocalGripCount = LocallyGrippedObjects.Num();
+	bGripIndexDirty = false;
+}
+
+void UGripMotionControllerComponent::RebuildPhysicsGripIndex()
+{
+	PhysicsGripIDIndex.Reset();
+
+	for (int i = PhysicsGrips.Num() - 1; i >= 0; --i)
+	{
+		PhysicsGripIDIndex.Add(PhysicsGrips[i].GripID, i);
+	}
+
+	IndexedPhysicsGripCount = PhysicsGrips.Num();
+	bPhysicsGripIndexDirty = false;
+}
+
+FBPActorGripInformation * UGripMotionControllerComponent::FindGripByID(uint8 GripID)
+{
+	if (bGripIndexDirty || IndexedGripCount != GrippedObjects.Num() || IndexedLocalGripCount != LocallyGrippedObjects.Num())
+		RebuildGripIndex();
+
+	if (const int32 * Slot = GripIDIndex.Find(GripID))
+	{
+		FBPActorGripInformation * Grip = (*Slot >= 0) ? &GrippedObjects[*Slot] : &LocallyGrippedObjects[~(*Slot)];
+		if (Grip->GripID == GripID)
+			return Grip;
+	}
+
+	// Missed or stale, the arrays were changed somewhere that didn't mark the index. They are the source of truth so search them,
+	// and have the index rebuilt on the next lookup if they turn out to have the grip.
+	FBPActorGripInformation * Grip = GrippedObjects.FindByKey(GripID);
+	if (!Grip)
+		Grip = LocallyGrippedObjects.FindByKey(GripID);
+
+	if (Grip)
+		MarkGripIndexDirty();
+
+	return Grip;
+}
+
+FBPActorGripInformation * UGripMotionControllerComponent::FindGripByObject(const UObject * Object)
+{
+	if (!Object)
+		return nullptr;
+
+	if (bGripIndexDirty || IndexedGripCount != GrippedObjects.Num() || IndexedLocalGripCount != LocallyGrippedObjects.Num())
+		RebuildGripIndex();
+
+	if (const int32 * Slot = GrippedObjectIndex.Find(Object))
+	{
+		FBPActorGripInformation * Grip = (*Slot >= 0) ? &GrippedObjects[*Slot] : &LocallyGrippedObjects[~(*Slot)];
+		if (Grip->GrippedObject == Object)
+			return Grip;
+	}
+
+	// Same fallback as FindGripByID
+	FBPActorGripInformation * Grip = GrippedObjects.FindByKey(Object);
+	if (!Grip)
+		Grip = LocallyGrippedObjects.FindByKey(Object);
+
+	if (Grip)
+		MarkGripIndexDirty();
+
+	return Grip;
+}
+
 FBPActorPhysicsHandleInformation * UGripMotionControllerComponent::GetPhysicsGrip(const FBPActorGripInformation & GripInfo)
 {
-	return PhysicsGrips.FindByKey(GripInfo);
+	int index;
+	return GetPhysicsGripIndex(GripInfo, index) ? &PhysicsGrips[index] : nullptr;
 }
 
 
 bool UGripMotionControllerComponent::GetPhysicsGripIndex(const FBPActorGripInformation & GripInfo, int & index)
 {
-	index = PhysicsGrips.IndexOfByKey(GripInfo);
-	return index != INDEX_NONE;
+	index = INDEX_NONE;
+
+	for (int Pass = 0; Pass < 2; ++Pass)
+	{
+		if (bPhysicsGripIndexDirty || IndexedPhysicsGripCount != PhysicsGrips.Num())
+			RebuildPhysicsGripIndex();
+
+		const int32 * Slot = PhysicsGripIDIndex.Find(GripInfo.GripID);
+		if (!Slot)
+			return false;
+
+		if (PhysicsGrips[*Slot] == GripInfo)
+		{
+			index = *Slot;
+			return true;
+		}
+
+		MarkPhysicsGripIndexDirty();
+	}
+
+	return false;
 }
 
 FBPActorPhysicsHandleInformation * UGripMotionControllerComponent::CreatePhysicsGrip(const FBPActorGripInformation & GripInfo)
 {
-	FBPActorPhysicsHandleInformation * HandleInfo = PhysicsGrips.FindByKey(GripInfo);
+	FBPActorPhysicsHandleInformation * HandleInfo = GetPhysicsGrip(GripInfo);
 
 	if (HandleInfo)
 	{
@@ -260,6 +708,7 @@ FBPActorPhysicsHandleInformation * UGripMotionControllerComponent::CreatePhysics
 	NewInfo.GripID = GripInfo.GripID;
 
 	int index = PhysicsGrips.Add(NewInfo);
+	MarkPhysicsGripIndexDirty();
 
 	return &PhysicsGrips[index];
 }
@@ -276,6 +725,9 @@ void UGripMotionControllerComponent::GetLifetimeReplicatedProps(TArray< class FL
 	DOREPLIFETIME(UGripMotionControllerComponent, ControllerNetUpdateRate);
 
 	DOREPLIFETIME_CONDITION(UGripMotionControllerComponent, LocallyGrippedObjects, COND_SkipOwner);
+
+	DOREPLIFETIME(UGripMotionControllerComponent, FastGrippedObjects);
+	DOREPLIFETIME_CONDITION(UGripMotionControllerComponent, FastLocallyGrippedObjects, COND_SkipOwner);
 //	DOREPLIFETIME(UGripMotionControllerComponent, bReplicateControllerTransform);
 }
 
@@ -287,10 +739,26 @@ void UGripMotionControllerComponent::PreReplication(IRepChangedPropertyTracker &
 	DOREPLIFETIME_ACTIVE_OVERRIDE(USceneComponent, RelativeLocation, false);
 	DOREPLIFETIME_ACTIVE_OVERRIDE(USceneComponent, RelativeRotation, false);
 	DOREPLIFETIME_ACTIVE_OVERRIDE(USceneComponent, RelativeScale3D, false);
+
+	// Only one set of grip arrays goes over the wire
+	DOREPLIFETIME_ACTIVE_OVERRIDE(UGripMotionControllerComponent, GrippedObjects, !bUseFastArrayGripReplication);
+	DOREPLIFETIME_ACTIVE_OVERRIDE(UGripMotionControllerComponent, LocallyGrippedObjects, !bUseFastArrayGripReplication);
+	DOREPLIFETIME_ACTIVE_OVERRIDE(UGripMotionControllerComponent, FastGrippedObjects, bUseFastArrayGripReplication);
+	DOREPLIFETIME_ACTIVE_OVERRIDE(UGripMotionControllerComponent, FastLocallyGrippedObjects, bUseFastArrayGripReplication);
+
+	if (bUseFastArrayGripReplication)
+	{
+		SyncFastGripArray(GrippedObjects, FastGrippedObjects);
+		SyncFastGripArray(LocallyGrippedObjects, FastLocallyGrippedObjects);
+	}
 }
 
 void UGripMotionControllerComponent::Server_SendControllerTransform_Implementation(FBPVRComponentPosRep NewTransform)
 {
+	// Delta based on a keyframe we never got, wait for the next one
+	if (!NewTransform.ResolveDelta(PosRepDeltaState))
+		return;
+
 	// Store new transform and trigger OnRep_Function
 	ReplicatedControllerTransform = NewTransform;
 
@@ -343,9 +811,7 @@ void UGripMotionControllerComponent::GetGripByActor(FBPActorGripInformation &Gri
 		return;
 	}
 
-	FBPActorGripInformation * GripInfo = GrippedObjects.FindByKey(ActorToLookForGrip);
-	if(!GripInfo)
-		GripInfo = LocallyGrippedObjects.FindByKey(ActorToLookForGrip);
+	FBPActorGripInformation * GripInfo = FindGripByObject(ActorToLookForGrip);
 	
 	if (GripInfo)
 	{
@@ -365,9 +831,7 @@ void UGripMotionControllerComponent::GetGripByComponent(FBPActorGripInformation
 		return;
 	}
 
-	FBPActorGripInformation * GripInfo = GrippedObjects.FindByKey(ComponentToLookForGrip);
-	if(!GripInfo)
-		GripInfo = LocallyGrippedObjects.FindByKey(ComponentToLookForGrip);
+	FBPActorGripInformation * GripInfo = FindGripByObject(ComponentToLookForGrip);
 
 	if (GripInfo)
 	{
@@ -387,9 +851,7 @@ void UGripMotionControllerComponent::GetGripByObject(FBPActorGripInformation &Gr
 		return;
 	}
 
-	FBPActorGripInformation * GripInfo = GrippedObjects.FindByKey(ObjectToLookForGrip);
-	if(!GripInfo)
-		GripInfo = LocallyGrippedObjects.FindByKey(ObjectToLookForGrip);
+	FBPActorGripInformation * GripInfo = FindGripByObject(ObjectToLookForGrip);
 
 	if (GripInfo)
 	{
@@ -403,9 +865,7 @@ void UGripMotionControllerComponent::GetGripByObject(FBPActorGripInformation &Gr
 
 void UGripMotionControllerComponent::GetGripByID(FBPActorGripInformation &Grip, uint8 IDToLookForGrip, EBPVRResultSwitch &Result)
 {
-	FBPActorGripInformation * GripInfo = GrippedObjects.FindByKey(IDToLookForGrip);
-	if (!GripInfo)
-		GripInfo = LocallyGrippedObjects.FindByKey(IDToLookForGrip);
+	FBPActorGripInformation * GripInfo = FindGripByID(IDToLookForGrip);
 
 	if (GripInfo)
 	{
@@ -1062,12 +1522,14 @@ bool UGripMotionControllerComponent::GripActor(
 	if (!bIsLocalGrip)
 	{
 		int32 Index = GrippedObjects.Add(newActorGrip);
+		MarkGripIndexDirty();
 		if(Index != INDEX_NONE)
 			NotifyGrip(GrippedObjects[Index]);
 	}
 	else
 	{
 		int32 Index = LocallyGrippedObjects.Add(newActorGrip);
+		MarkGripIndexDirty();
 
 		if(GetNetMode() == ENetMode::NM_Client && !IsTornOff() && newActorGrip.GripMovementReplicationSetting == EGripMovementReplicationSettings::ClientSide_Authoritive)
 			Server_NotifyLocalGripAddedOrChanged(newActorGrip);
@@ -1263,12 +1725,14 @@ bool UGripMotionControllerComponent::GripComponent(
 	if (!bIsLocalGrip)
 	{
 		int32 Index = GrippedObjects.Add(newActorGrip);
+		MarkGripIndexDirty();
 		if (Index != INDEX_NONE)
 			NotifyGrip(GrippedObjects[Index]);
 	}
 	else
 	{
 		int32 Index = LocallyGrippedObjects.Add(newActorGrip);
+		MarkGripIndexDirty();
 
 		if (GetNetMode() == ENetMode::NM_Client && !IsTornOff() && newActorGrip.GripMovementReplicationSetting == EGripMovementReplicationSettings::ClientSide_Authoritive)
 			Server_NotifyLocalGripAddedOrChanged(newActorGrip);
@@ -1716,6 +2180,7 @@ void UGripMotionControllerComponent::DropAndSocket_Implementation(const FBPActor
 		if (HasGripAuthority(NewDrop) || GetNetMode() < ENetMode::NM_Client)
 		{
 			LocallyGrippedObjects.RemoveAt(fIndex);
+			MarkGripIndexDirty();
 		}
 		else
 			LocallyGrippedObjects[fIndex].bIsPaused = true; // Pause it instead of dropping, dropping can corrupt the array in rare cases
@@ -1728,6 +2193,7 @@ void UGripMotionControllerComponent::DropAndSocket_Implementation(const FBPActor
 			if (HasGripAuthority(NewDrop) || GetNetMode() < ENetMode::NM_Client)
 			{
 				GrippedObjects.RemoveAt(fIndex);
+				MarkGripIndexDirty();
 			}
 			else
 				GrippedObjects[fIndex].bIsPaused = true; // Pause it instead of dropping, dropping can corrupt the array in rare cases
@@ -1745,6 +2211,9 @@ bool UGripMotionControllerComponent::NotifyGrip(FBPActorGripInformation &NewGrip
 	UPrimitiveComponent *root = NULL;
 	AActor *pActor = NULL;
 
+	// Resolved again on the next tick
+	NewGrip.TargetCache = FBPActorGripInformation::FGripTargetCache();
+
 	switch (NewGrip.GripTargetType)
 	{
 	case EGripTargetType::ActorGrip:
@@ -2172,6 +2641,7 @@ void UGripMotionControllerComponent::Drop_Implementation(const FBPActorGripInfor
 		if (HasGripAuthority(NewDrop) || GetNetMode() < ENetMode::NM_Client)
 		{
 			LocallyGrippedObjects.RemoveAt(fIndex);
+			MarkGripIndexDirty();
 		}
 		else
 			LocallyGrippedObjects[fIndex].bIsPaused = true; // Pause it instead of dropping, dropping can corrupt the array in rare cases
@@ -2184,6 +2654,7 @@ void UGripMotionControllerComponent::Drop_Implementation(const FBPActorGripInfor
 			if (HasGripAuthority(NewDrop) || GetNetMode() < ENetMode::NM_Client)
 			{
 				GrippedObjects.RemoveAt(fIndex);
+				MarkGripIndexDirty();
 			}
 			else
 				GrippedObjects[fIndex].bIsPaused = true; // Pause it instead of dropping, dropping can corrupt the array in rare cases
@@ -2648,6 +3119,8 @@ bool UGripMotionControllerComponent::TeleportMoveGrip_Impl(FBPActorGripInformati
 
 #if WITH_PHYSX
 		{
+			FVRGripPhysicsBatch::RemoveKinematicTarget(GetWorld(), Handle->KinActorData);
+
 			PxScene* PScene = GetPhysXSceneFromIndex(Handle->SceneIndex);
 			if (PScene)
 			{
@@ -2759,23 +3232,37 @@ void UGripMotionControllerComponent::TickComponent(float DeltaTime, enum ELevelT
 		// Don't bother with any of this if not replicating transform
 		if (bReplicates && (bTracked || bReplicateWithoutTracking))
 		{
+			AVRBaseCharacter * BundlingChar = (GetNetMode() == NM_Client) ? Cast<AVRBaseCharacter>(GetOwner()) : nullptr;
+
+			// The character samples all of its devices on the same frame and handles the rate and change checks for the bundle
+			if (BundlingChar && BundlingChar->IsTrackedDeviceBundled(this))
+			{
+				ReplicatedControllerTransform.Position = this->RelativeLocation;
+				ReplicatedControllerTransform.Rotation = this->RelativeRotation;
+				ReplicatedControllerTransform.SetTimeStamp(bSmoothReplicatedMotion, FPlatformTime::Seconds());
+				BundlingChar->ReportTrackedDevice(this, ReplicatedControllerTransform);
+			}
 			// Don't rep if no changes
-			if (!this->RelativeLocation.Equals(ReplicatedControllerTransform.Position) || !this->RelativeRotation.Equals(ReplicatedControllerTransform.Rotation))
+			else if (!this->RelativeLocation.Equals(ReplicatedControllerTransform.Position) || !this->RelativeRotation.Equals(ReplicatedControllerTransform.Rotation))
 			{
 				ControllerNetUpdateCount += DeltaTime;
-				if (ControllerNetUpdateCount >= (1.0f / ControllerNetUpdateRate))
+				const float SendRate = AdaptiveNetUpdateRate.GetNetUpdateRate(ReplicatedControllerTransform, this->RelativeLocation, this->RelativeRotation, ControllerNetUpdateCount, ControllerNetUpdateRate);
+				if (ControllerNetUpdateCount >= (1.0f / SendRate))
 				{
 					ControllerNetUpdateCount = 0.0f;
 
 					// Tracked doesn't matter, already set the relative location above in that case
 					ReplicatedControllerTransform.Position = this->RelativeLocation;
 					ReplicatedControllerTransform.Rotation = this->RelativeRotation;
+					ReplicatedControllerTransform.SetTimeStamp(bSmoothReplicatedMotion, FPlatformTime::Seconds());
 
 					// I would keep the torn off check here, except this can be checked on tick if they
 					// Set 100 htz updates, and in the TornOff case, it actually can't hurt any besides some small
 					// Perf difference.
 					if (GetNetMode() == NM_Client/* && !IsTornOff()*/)
 					{		
+						ReplicatedControllerTransform.PrepareDeltaSend(PosRepDeltaState);
+
 						AVRBaseCharacter * OwningChar = Cast<AVRBaseCharacter>(GetOwner());
 						if (OverrideSendTransform != nullptr && OwningChar != nullptr)
 						{
@@ -2790,10 +3277,18 @@ void UGripMotionControllerComponent::TickComponent(float DeltaTime, enum ELevelT
 	}
 	else
 	{
-		if (bLerpingPosition)
+		FVector BufferedPosition;
+		FRotator BufferedRotation;
+
+		if (bSmoothReplicatedMotion && RemotePoseBuffer.HasSamples())
+		{
+			if (RemotePoseBuffer.Sample(FPlatformTime::Seconds(), BufferedPosition, BufferedRotation))
+				SetRelativeLocationAndRotation(BufferedPosition, BufferedRotation);
+		}
+		else if (bLerpingPosition)
 		{
 			ControllerNetUpdateCount += DeltaTime;
-			float LerpVal = FMath::Clamp(ControllerNetUpdateCount / (1.0f / ControllerNetUpdateRate), 0.0f, 1.0f);
+			float LerpVal = RemoteLerpDuration > 0.0f ? FMath::Clamp(ControllerNetUpdateCount / RemoteLerpDuration, 0.0f, 1.0f) : 1.0f;
 
 			if (LerpVal >= 1.0f)
 			{
@@ -2825,6 +3320,7 @@ void UGripMotionControllerComponent::TickComponent(float DeltaTime, enum ELevelT
 
 void UGripMotionControllerComponent::GetGripWorldTransform(float DeltaTime, FTransform & WorldTransform, const FTransform &ParentTransform, FBPActorGripInformation &Grip, AActor * actor, UPrimitiveComponent * root, bool bRootHasInterface, bool bActorHasInterface/*, bool & bRescalePhysicsGrips*/)
 {
+	VRGRIP_SCOPED_TIMING(GetGripWorldTransform);
 
 	// Removed in 4.20
 	// Check for interaction interface and modify transform by it
@@ -2875,6 +3371,8 @@ void UGripMotionControllerComponent::GetGripWorldTransform(float DeltaTime, FTra
 	// Handle the interp and multi grip situations, re-checking the grip situation here as it may have changed in the switch above.
 	if ((Grip.SecondaryGripInfo.bHasSecondaryAttachment && Grip.SecondaryGripInfo.SecondaryAttachment) || Grip.SecondaryGripInfo.GripLerpState == EGripLerpState::EndLerp)
 	{
+		VRGRIP_SCOPED_TIMING(SecondaryGripTransform);
+
 		FTransform SecondaryTransform = Grip.RelativeTransform * ParentTransform;
 
 		// Checking secondary grip type for the scaling setting
@@ -3083,7 +3581,7 @@ FTransform UGripMotionControllerComponent::HandleInteractionSettings(float Delta
 
 void UGripMotionControllerComponent::TickGrip(float DeltaTime)
 {
-	SCOPE_CYCLE_COUNTER(STAT_TickGrip);
+	VRGRIP_SCOPED_TIMING(TickGrip);
 
 	// Debug test that we aren't floating physics handles
 	if (PhysicsGrips.Num() > (GrippedObjects.Num() + LocallyGrippedObjects.Num()))
@@ -3103,6 +3601,60 @@ void UGripMotionControllerComponent::TickGrip(float DeltaTime)
 	bIsPostTeleport = false;
 }
 
+bool UGripMotionControllerComponent::GetCachedGripTargets(FBPActorGripInformation &Grip, UPrimitiveComponent *& root, AActor *& actor, bool & bRootHasInterface, bool & bActorHasInterface)
+{
+	FBPActorGripInformation::FGripTargetCache & Cache = Grip.TargetCache;
+
+	// Getting the correct variables depending on the grip target type
+	switch (Grip.GripTargetType)
+	{
+	case EGripTargetType::ActorGrip:
+		//case EGripTargetType::InteractibleActorGrip:
+	{
+		actor = (Cache.CachedGrippedObject == Grip.GrippedObject) ? Cache.Actor : Grip.GetGrippedActor();
+
+		USceneComponent * ActorRoot = actor ? actor->GetRootComponent() : nullptr;
+		root = (ActorRoot && ActorRoot == Cache.Root) ? Cache.Root : Cast<UPrimitiveComponent>(ActorRoot);
+	}break;
+
+	case EGripTargetType::ComponentGrip:
+		//case EGripTargetType::InteractibleComponentGrip :
+	{
+		root = (Cache.CachedGrippedObject == Grip.GrippedObject) ? Cache.Root : Grip.GetGrippedComponent();
+		actor = root ? root->GetOwner() : nullptr;
+	}break;
+
+	default:
+	{
+		root = nullptr;
+		actor = nullptr;
+	}break;
+	}
+
+	if (!root || !actor)
+	{
+		Cache = FBPActorGripInformation::FGripTargetCache();
+		return false;
+	}
+
+	// Re-gripped, re-parented or the class changed out from under us, look the flags back up
+	if (Cache.CachedGrippedObject != Grip.GrippedObject || Cache.Root != root || Cache.Actor != actor ||
+		Cache.RootClass != root->GetClass() || Cache.ActorClass != actor->GetClass())
+	{
+		Cache.CachedGrippedObject = Grip.GrippedObject;
+		Cache.Root = root;
+		Cache.Actor = actor;
+		Cache.RootClass = root->GetClass();
+		Cache.ActorClass = actor->GetClass();
+		Cache.bRootHasInterface = FVRGripInterfaceClassCache::ImplementsGripInterface(Cache.RootClass);
+		Cache.bActorHasInterface = FVRGripInterfaceClassCache::ImplementsGripInterface(Cache.ActorClass);
+	}
+
+	bRootHasInterface = Cache.bRootHasInterface;
+	bActorHasInterface = Cache.bActorHasInterface;
+	return true;
+}
+
 void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformation> &GrippedObjectsArray, const FTransform & ParentTransform, float DeltaTime, bool bReplicatedArray)
 {
 	if (GrippedObjectsArray.Num())
@@ -3133,48 +3685,20 @@ void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformat
 				UPrimitiveComponent *root = NULL;
 				AActor *actor = NULL;
 
-				// Getting the correct variables depending on the grip target type
-				switch (Grip->GripTargetType)
-				{
-					case EGripTargetType::ActorGrip:
-					//case EGripTargetType::InteractibleActorGrip:
-					{
-						actor = Grip->GetGrippedActor();
-						if(actor)
-							root = Cast<UPrimitiveComponent>(actor->GetRootComponent());
-					}break;
-
-					case EGripTargetType::ComponentGrip:
-					//case EGripTargetType::InteractibleComponentGrip :
-					{
-						root = Grip->GetGrippedComponent();
-						if(root)
-							actor = root->GetOwner();
-					}break;
-
-				default:break;
-				}
+				// Check if either implements the interface
+				bool bRootHasInterface = false;
+				bool bActorHasInterface = false;
 
 				// Last check to make sure the variables are valid
-				if (!root || !actor)
+				if (!GetCachedGripTargets(*Grip, root, actor, bRootHasInterface, bActorHasInterface))
 					continue;
 
-				// Check if either implements the interface
-				bool bRootHasInterface = false;
-				bool bActorHasInterface = false;
-				
-				if (root->GetClass()->ImplementsInterface(UVRGripInterface::StaticClass()))
-				{
-					bRootHasInterface = true;
-				}
-				if (actor->GetClass()->ImplementsInterface(UVRGripInterface::StaticClass()))
-				{
-					// Actor grip interface is checked after component
-					bActorHasInterface = true;
-				}
+				CountGripType(Grip->GripCollisionType);
 
 				if (Grip->GripCollisionType == EGripCollisionType::CustomGrip)
 				{
+					VRGRIP_SCOPED_TIMING(GripInterfaceTick);
+
 					// Don't perform logic on the movement for this object, just pass in the GripTick() event with the controller difference instead
 					if(bRootHasInterface)
 						IVRGripInterface::Execute_TickGrip(root, this, *Grip, DeltaTime);
@@ -3313,7 +3837,13 @@ void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformat
 							Params.AddIgnoredActors(root->MoveIgnoreActors);
 
 							FHitResult Hit;
-							if(GetWorld()->SweepSingleByChannel(Hit, root->GetComponentLocation(), WorldTransform.GetLocation(), WorldTransform.GetRotation(), root->GetCollisionObjectType(), root->GetCollisionShape(),Params))
+							bool bSweepHit = false;
+							{
+								VRGRIP_SCOPED_TIMING(GripSweeps);
+								bSweepHit = CountGripSweep(GetWorld()->SweepSingleByChannel(Hit, root->GetComponentLocation(), WorldTransform.GetLocation(), WorldTransform.GetRotation(), root->GetCollisionObjectType(), root->GetCollisionShape(), Params));
+							}
+
+							if (bSweepHit)
 							{
 								Grip->bColliding = true;
 							}
@@ -3336,12 +3866,43 @@ void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformat
 						if (Grip->bIsLocked)
 							WorldTransform.SetRotation(Grip->LastLockedRotation);
 
-						FHitResult OutHit;
-						// Need to use without teleport so that the physics velocity is updated for when the actor is released to throw
+						bool bHadBlockingHit = false;
 
-						root->SetWorldTransform(WorldTransform, true, &OutHit);
+						if (bUseAsyncGripSweeps)
+						{
+							FGripAsyncSweep & Sweep = GetAsyncGripSweep(*Grip, root);
+							bHadBlockingHit = IsAsyncGripSweepFresh(Sweep) && Sweep.bBlockingHit;
 
-						if (OutHit.bBlockingHit)
+							// Last frames sweep ran into something, keep the target on the open side of the surface it hit
+							if (bHadBlockingHit)
+							{
+								const FVector & HitNormal = Sweep.BlockingHit.Normal;
+								const float Penetration = (WorldTransform.GetTranslation() - Sweep.BlockingHit.Location) | HitNormal;
+								if (Penetration < 0.f)
+									WorldTransform.SetTranslation(WorldTransform.GetTranslation() - (HitNormal * Penetration));
+							}
+
+							// Need to use without teleport so that the physics velocity is updated for when the actor is released to throw
+							root->SetWorldTransform(WorldTransform, false);
+
+							// Sweep towards where the hand wants it plus one more frame of motion, the result clamps the next frames move
+							const FVector PredictedPosition = NewPosition + (root->ComponentVelocity * DeltaTime);
+							if ((PredictedPosition - WorldTransform.GetTranslation()).SizeSquared() > FMath::Square(4.f*KINDA_SMALL_NUMBER))
+								QueueAsyncGripSweep(Sweep, root, PredictedPosition, WorldTransform.GetRotation());
+						}
+						else
+						{
+							FHitResult OutHit;
+							// Need to use without teleport so that the physics velocity is updated for when the actor is released to throw
+
+							{
+								VRGRIP_SCOPED_TIMING(GripSweeps);
+								root->SetWorldTransform(WorldTransform, true, &OutHit);
+							}
+							bHadBlockingHit = CountGripSweep(OutHit.bBlockingHit);
+						}
+
+						if (bHadBlockingHit)
 						{
 							Grip->bColliding = true;
 
@@ -3375,8 +3936,14 @@ void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformat
 						Params.AddIgnoredActors(root->MoveIgnoreActors);
 
 						FHitResult Hit;
+						bool bSweepHit = false;
+						{
+							VRGRIP_SCOPED_TIMING(GripSweeps);
+							bSweepHit = CountGripSweep(GetWorld()->SweepSingleByChannel(Hit, root->GetComponentLocation(), WorldTransform.GetLocation(), WorldTransform.GetRotation(), root->GetCollisionObjectType(), root->GetCollisionShape(), Params));
+						}
+
 						// Checking both current and next position for overlap using this grip type #TODO: Do this for normal interactive physics as well?
-						if (GetWorld()->SweepSingleByChannel(Hit, root->GetComponentLocation(), WorldTransform.GetLocation(), WorldTransform.GetRotation(), root->GetCollisionObjectType(), root->GetCollisionShape(), Params))
+						if (bSweepHit)
 						/*if (GetWorld()->ComponentOverlapMultiByChannel(Hits, root, root->GetComponentLocation(), root->GetComponentQuat(), root->GetCollisionObjectType(), Params) ||
 							GetWorld()->ComponentOverlapMultiByChannel(Hits, root, WorldTransform.GetLocation(), WorldTransform.GetRotation(), root->GetCollisionObjectType(), Params)
 							)*/
@@ -3479,9 +4046,12 @@ void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformat
 							FTransform OrigTransform = root->GetComponentTransform();
 
 							FHitResult OutHit;
-							root->SetWorldTransform(WorldTransform, true, &OutHit);
+							{
+								VRGRIP_SCOPED_TIMING(GripSweeps);
+								root->SetWorldTransform(WorldTransform, true, &OutHit);
+							}
 
-							if (OutHit.bBlockingHit)
+							if (CountGripSweep(OutHit.bBlockingHit))
 							{
 								Grip->bColliding = true;
 								root->SetWorldTransform(OrigTransform, false);
@@ -3538,7 +4108,16 @@ void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformat
 							// ComponentSweepMulti does nothing if moving < KINDA_SMALL_NUMBER in distance, so it's important to not try to sweep distances smaller than that. 
 							const float MinMovementDistSq = (FMath::Square(4.f*KINDA_SMALL_NUMBER));
 
-							if (bUseWithoutTracking || move.SizeSquared() > MinMovementDistSq || NewOrientation != OriginalOrientation)
+							if (bUseAsyncGripSweeps)
+							{
+								// Children are not swept in async mode, they only dispatched their own hit events
+								FGripAsyncSweep & Sweep = GetAsyncGripSweep(*Grip, root);
+								Grip->bColliding = IsAsyncGripSweepFresh(Sweep) && Sweep.bBlockingHit;
+
+								if (bUseWithoutTracking || move.SizeSquared() > MinMovementDistSq || NewOrientation != OriginalOrientation)
+									QueueAsyncGripSweep(Sweep, root, NewPosition, OriginalOrientation.Quaternion());
+							}
+							else if (bUseWithoutTracking || move.SizeSquared() > MinMovementDistSq || NewOrientation != OriginalOrientation)
 							{
 								if (CheckComponentWithSweep(root, move, OriginalOrientation, false))
 								{
@@ -3597,6 +4176,8 @@ void UGripMotionControllerComponent::HandleGripArray(TArray<FBPActorGripInformat
 				// We only do this if specifically requested, it has a slight perf hit and isn't normally needed for non Custom Grip types
 				if (bAlwaysSendTickGrip)
 				{
+					VRGRIP_SCOPED_TIMING(GripInterfaceTick);
+
 					// All non custom grips tick after translation, this is still pre physics so interactive grips location will be wrong, but others will be correct
 					if (bRootHasInterface)
 					{
@@ -3632,6 +4213,7 @@ void UGripMotionControllerComponent::CleanUpBadGrip(TArray<FBPActorGripInformati
 				// Need to delete it from the physics thread
 				DestroyPhysicsHandle(PhysicsGrips[g].SceneIndex, &PhysicsGrips[g].HandleData, &PhysicsGrips[g].KinActorData);
 				PhysicsGrips.RemoveAt(g);
+				MarkPhysicsGripIndexDirty();
 			}
 		}
 	}
@@ -3652,15 +4234,14 @@ void UGripMotionControllerComponent::CleanUpBadPhysicsHandles()
 	// Clean up tailing physics handles with null objects
 	for (int g = PhysicsGrips.Num() - 1; g >= 0; --g)
 	{
-		FBPActorGripInformation * GripInfo = LocallyGrippedObjects.FindByKey(PhysicsGrips[g].GripID);
-		if(!GripInfo)
-			GrippedObjects.FindByKey(PhysicsGrips[g].GripID);
+		FBPActorGripInformation * GripInfo = FindGripByID(PhysicsGrips[g].GripID);
 
 		if (!GripInfo)
 		{
 			// Need to delete it from the physics thread
 			DestroyPhysicsHandle(PhysicsGrips[g].SceneIndex, &PhysicsGrips[g].HandleData, &PhysicsGrips[g].KinActorData);
 			PhysicsGrips.RemoveAt(g);
+			MarkPhysicsGripIndexDirty();
 		}
 	}
 }
@@ -3672,6 +4253,8 @@ bool UGripMotionControllerComponent::DestroyPhysicsHandle(int32 SceneIndex, phys
 		{
 			check(*KinActorData);
 
+			FVRGripPhysicsBatch::RemoveKinematicTarget(GetWorld(), *KinActorData);
+
 			// use correct scene
 			PxScene* PScene = GetPhysXSceneFromIndex(SceneIndex);
 			if (PScene)
@@ -3683,6 +4266,8 @@ bool UGripMotionControllerComponent::DestroyPhysicsHandle(int32 SceneIndex, phys
 				// Destroy temporary actor.
 				(*KinActorData)->release();
 
+				VRGRIP_INC_COUNTER(PhysicsHandlesDestroyed, 1);
+
 			}
 			*KinActorData = NULL;
 			*HandleData = NULL;
@@ -3725,13 +4310,18 @@ bool UGripMotionControllerComponent::DestroyPhysicsHandle(const FBPActorGripInfo
 
 	int index;
 	if (GetPhysicsGripIndex(Grip, index))
+	{
 		PhysicsGrips.RemoveAt(index);
+		MarkPhysicsGripIndexDirty();
+	}
 
 	return true;
 }
 
 bool UGripMotionControllerComponent::SetUpPhysicsHandle(const FBPActorGripInformation &NewGrip)
 {
+	VRGRIP_SCOPED_TIMING(SetUpPhysicsHandle);
+
 	UPrimitiveComponent *root = NewGrip.GetGrippedComponent();
 	AActor * pActor = NewGrip.GetGrippedActor();
 
@@ -3871,6 +4461,8 @@ bool UGripMotionControllerComponent::SetUpPhysicsHandle(const FBPActorGripInform
 				NewJoint->userData = NULL;
 				HandleInfo->HandleData = NewJoint;
 
+				VRGRIP_INC_COUNTER(PhysicsHandlesCreated, 1);
+
 				// Remember the scene index that the handle joint/actor are in.
 				FPhysScene* RBScene = FPhysxUserData::Get<FPhysScene>(Scene->userData);
 				const uint32 SceneType = rBodyInstance->UseAsyncScene(RBScene) ? PST_Async : PST_Sync;
@@ -4105,6 +4697,8 @@ bool UGripMotionControllerComponent::GetPhysicsJointLength(const FBPActorGripInf
 
 void UGripMotionControllerComponent::UpdatePhysicsHandleTransform(const FBPActorGripInformation &GrippedActor, const FTransform& NewTransform)
 {
+	VRGRIP_SCOPED_TIMING(UpdatePhysicsHandles);
+
 	if (!GrippedActor.GrippedObject)
 		return;
 
@@ -4114,48 +4708,26 @@ void UGripMotionControllerComponent::UpdatePhysicsHandleTransform(const FBPActor
 		return;
 
 #if WITH_PHYSX
-	bool bChangedPosition = true;
-	bool bChangedRotation = true;
-
 	PxRigidDynamic* KinActor = HandleInfo->KinActorData;
-	PxScene* PScene = GetPhysXSceneFromIndex(HandleInfo->SceneIndex);
-	SCOPED_SCENE_WRITE_LOCK(PScene);
-	
-	// Check if the new location is worthy of change
-	PxVec3 PNewLocation = U2PVector(NewTransform.GetTranslation());
-	PxVec3 PCurrentLocation = KinActor->getGlobalPose().p;
-	if ((PNewLocation - PCurrentLocation).magnitudeSquared() <= 0.01f*0.01f)
-	{
-		PNewLocation = PCurrentLocation;
-		bChangedPosition = false;
-	}
+	const PxTransform KinematicTarget = U2PTransform(HandleInfo->RootBoneRotation * NewTransform) * HandleInfo->COMPosition;
 
-	// Check if the new rotation is worthy of change
-	PxQuat PNewOrientation = U2PQuat(NewTransform.GetRotation());
-	PxQuat PCurrentOrientation = KinActor->getGlobalPose().q;
-	if ((FMath::Abs(PNewOrientation.dot(PCurrentOrientation)) > (1.f - SMALL_NUMBER)))
+	// Debug draw for COM movement with physics grips
+#if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+	if (GripMotionControllerCvars::DrawDebugGripCOM)
 	{
-		PNewOrientation = PCurrentOrientation;
-		bChangedRotation = false;
+		UPrimitiveComponent * me = Cast<UPrimitiveComponent>(GrippedActor.GripTargetType == EGripTargetType::ActorGrip ? GrippedActor.GetGrippedActor()->GetRootComponent() : GrippedActor.GetGrippedComponent());
+		FVector curCOMPosition = me->GetBodyInstance(GrippedActor.GrippedBoneName)->GetCOMPosition();//rBodyInstance->GetUnrealWorldTransform().InverseTransformPosition(rBodyInstance->GetCOMPosition());
+		DrawDebugSphere(GetWorld(), curCOMPosition, 4, 32, FColor::Red, false);
+		DrawDebugSphere(GetWorld(), P2UTransform(KinematicTarget).GetLocation(), 4, 32, FColor::Cyan, false);
 	}
-	
-	// Don't call moveKinematic if it hasn't changed - that will stop bodies from going to sleep.
-	if (bChangedPosition || bChangedRotation)
-	{
-		FTransform terns = NewTransform;
-
-		// Debug draw for COM movement with physics grips
-#if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
-		if (GripMotionControllerCvars::DrawDebugGripCOM)
-		{
-			UPrimitiveComponent * me = Cast<UPrimitiveComponent>(GrippedActor.GripTargetType == EGripTargetType::ActorGrip ? GrippedActor.GetGrippedActor()->GetRootComponent() : GrippedActor.GetGrippedComponent());
-			FVector curCOMPosition = me->GetBodyInstance(GrippedActor.GrippedBoneName)->GetCOMPosition();//rBodyInstance->GetUnrealWorldTransform().InverseTransformPosition(rBodyInstance->GetCOMPosition());
-			DrawDebugSphere(GetWorld(), curCOMPosition, 4, 32, FColor::Red, false);
-			DrawDebugSphere(GetWorld(), P2UTransform(U2PTransform(HandleInfo->RootBoneRotation * terns) * HandleInfo->COMPosition).GetLocation(), 4, 32, FColor::Cyan, false);
-			//DrawDebugSphere(GetWorld(), terns.GetLocation(), 4, 32, FColor::Cyan, false);
-		}
 #endif
-		KinActor->setKinematicTarget(U2PTransform(HandleInfo->RootBoneRotation * terns) * HandleInfo->COMPosition);
+
+	// Applied with every other physics grip in the world right before physics starts, or immediately if we aren't ticking ahead of physics
+	if (!FVRGripPhysicsBatch::QueueKinematicTarget(GetWorld(), HandleInfo->SceneIndex, KinActor, KinematicTarget))
+	{
+		PxScene* PScene = GetPhysXSceneFromIndex(HandleInfo->SceneIndex);
+		SCOPED_SCENE_WRITE_LOCK(PScene);
+		FVRGripPhysicsBatch::ApplyKinematicTarget(KinActor, KinematicTarget);
 	}
 #endif // WITH_PHYSX
 }
@@ -4203,7 +4775,12 @@ bool UGripMotionControllerComponent::CheckComponentWithSweep(UPrimitiveComponent
 		root->InitSweepCollisionParams(Params, ResponseParam);
 
 		FVector end = start + Move;
-		bool const bHadBlockingHit = MyWorld->ComponentSweepMulti(Hits, root, start, end, newOrientation.Quaternion(), Params);
+		bool bSweepHit = false;
+		{
+			VRGRIP_SCOPED_TIMING(GripSweeps);
+			bSweepHit = CountGripSweep(MyWorld->ComponentSweepMulti(Hits, root, start, end, newOrientation.Quaternion(), Params));
+		}
+		bool const bHadBlockingHit = bSweepHit;
 
 		if (Hits.Num() > 0)
 		{
@@ -4288,6 +4865,174 @@ bool UGripMotionControllerComponent::CheckComponentWithSweep(UPrimitiveComponent
 	return false;
 }
 
+// World level batch for async grip sweeps. Controllers register when they queue a sweep during TickGrip and once the world
+// has finished ticking actors every registered controller submits, so all grip sweeps in the world go out together.
+class FVRGripAsyncSweepBatch
+{
+public:
+
+	static void Register(UGripMotionControllerComponent * Controller)
+	{
+		UWorld * World = Controller->GetWorld();
+		if (!World)
+			return;
+
+		if (!PostActorTickHandle.IsValid())
+		{
+			PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddStatic(&FVRGripAsyncSweepBatch::Flush);
+			WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddStatic(&FVRGripAsyncSweepBatch::OnWorldCleanup);
+		}
+
+		PendingControllers.FindOrAdd(World).AddUnique(Controller);
+	}
+
+private:
+
+	// Unbinds once the last world using the batch is gone, the next Register binds again
+	static void OnWorldCleanup(UWorld * World, bool bSessionEnded, bool bCleanupResources)
+	{
+		PendingControllers.Remove(World);
+
+		for (auto It = PendingControllers.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+				It.RemoveCurrent();
+		}
+
+		if (!PendingControllers.Num())
+		{
+			FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+			FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+			PostActorTickHandle.Reset();
+			WorldCleanupHandle.Reset();
+		}
+	}
+
+	static void Flush(UWorld * World, ELevelTick TickType, float DeltaSeconds)
+	{
+		TArray<TWeakObjectPtr<UGripMotionControllerComponent>> Controllers;
+		if (!PendingControllers.RemoveAndCopyValue(World, Controllers))
+			return;
+
+		VRGRIP_SCOPED_TIMING(SubmitAsyncGripSweeps);
+
+		for (TWeakObjectPtr<UGripMotionControllerComponent> & Controller : Controllers)
+		{
+			if (Controller.IsValid())
+				Controller->SubmitAsyncGripSweeps();
+		}
+
+		// Worlds that were torn down with sweeps still pending never flush
+		for (auto It = PendingControllers.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+				It.RemoveCurrent();
+		}
+	}
+
+	static TMap<TWeakObjectPtr<UWorld>, TArray<TWeakObjectPtr<UGripMotionControllerComponent>>> PendingControllers;
+	static FDelegateHandle PostActorTickHandle;
+	static FDelegateHandle WorldCleanupHandle;
+};
+
+TMap<TWeakObjectPtr<UWorld>, TArray<TWeakObjectPtr<UGripMotionControllerComponent>>> FVRGripAsyncSweepBatch::PendingControllers;
+FDelegateHandle FVRGripAsyncSweepBatch::PostActorTickHandle;
+FDelegateHandle FVRGripAsyncSweepBatch::WorldCleanupHandle;
+
+FGripAsyncSweep & UGripMotionControllerComponent::GetAsyncGripSweep(const FBPActorGripInformation & Grip, UPrimitiveComponent * root)
+{
+	FGripAsyncSweep & Sweep = AsyncGripSweeps.FindOrAdd(Grip.GripID);
+
+	// Grip IDs get reused, don't apply a result from a different object
+	if (Sweep.Component.Get() != root)
+	{
+		Sweep = FGripAsyncSweep();
+		Sweep.Component = root;
+	}
+
+	return Sweep;
+}
+
+void UGripMotionControllerComponent::QueueAsyncGripSweep(FGripAsyncSweep & Sweep, UPrimitiveComponent * root, const FVector & Target, const FQuat & Rotation)
+{
+	if (!root || !root->IsQueryCollisionEnabled())
+		return;
+
+	Sweep.Start = root->GetComponentLocation();
+	Sweep.End = Target;
+	Sweep.Rotation = Rotation;
+
+	if (!Sweep.bQueued)
+	{
+		Sweep.bQueued = true;
+		FVRGripAsyncSweepBatch::Register(this);
+	}
+}
+
+void UGripMotionControllerComponent::SubmitAsyncGripSweeps()
+{
+	UWorld * MyWorld = GetWorld();
+	if (!MyWorld)
+		return;
+
+	FTraceDelegate SweepDelegate = FTraceDelegate::CreateUObject(this, &UGripMotionControllerComponent::OnAsyncGripSweepComplete);
+
+	for (auto It = AsyncGripSweeps.CreateIterator(); It; ++It)
+	{
+		FGripAsyncSweep & Sweep = It.Value();
+		UPrimitiveComponent * root = Sweep.Component.Get();
+
+		// Dropped or destroyed since it was last swept
+		if (!root || root->IsPendingKill() || !FindGripByID(It.Key()))
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		if (!Sweep.bQueued)
+			continue;
+
+		Sweep.bQueued = false;
+
+		FComponentQueryParams Params(TEXT("async_grip_sweep"), root->GetOwner());
+		FCollisionResponseParams ResponseParam;
+		root->InitSweepCollisionParams(Params, ResponseParam);
+		Params.AddIgnoredActor(this->GetOwner());
+
+		VRGRIP_INC_COUNTER(GripSweepsIssued, 1);
+		Sweep.Handle = MyWorld->AsyncSweepByChannel(EAsyncTraceType::Single, Sweep.Start, Sweep.End, Sweep.Rotation, root->GetCollisionObjectType(), root->GetCollisionShape(), Params, ResponseParam, &SweepDelegate, It.Key());
+	}
+}
+
+void UGripMotionControllerComponent::OnAsyncGripSweepComplete(const FTraceHandle & Handle, FTraceDatum & Datum)
+{
+	FGripAsyncSweep * Sweep = AsyncGripSweeps.Find((uint8)Datum.UserData);
+
+	// Grip is gone or a newer sweep has already been submitted
+	if (!Sweep || !(Sweep->Handle == Handle))
+		return;
+
+	Sweep->bHasResult = true;
+	Sweep->bBlockingHit = false;
+	Sweep->ResultFrame = GFrameCounter;
+
+	for (const FHitResult & Hit : Datum.OutHits)
+	{
+		if (Hit.bBlockingHit && Hit.IsValidBlockingHit())
+		{
+			VRGRIP_INC_COUNTER(GripSweepHits, 1);
+			Sweep->bBlockingHit = true;
+			Sweep->BlockingHit = Hit;
+			break;
+		}
+	}
+
+	// Same notification the blocking sweep would have sent
+	UPrimitiveComponent * root = Sweep->Component.Get();
+	if (Sweep->bBlockingHit && root && !root->IsPendingKill() && root->GetOwner())
+		root->DispatchBlockingHit(*root->GetOwner(), Sweep->BlockingHit);
+}
+
 //=============================================================================
 bool UGripMotionControllerComponent::GripPollControllerState(FVector& Position, FRotator& Orientation , float WorldToMetersScale)
 {
@@ -4541,6 +5286,7 @@ void UGripMotionControllerComponent::Server_NotifyLocalGripAddedOrChanged_Implem
 	if (!LocallyGrippedObjects.Contains(newGrip))
 	{
 		LocallyGrippedObjects.Add(newGrip);
+		MarkGripIndexDirty();
 
 		// Initialize the differences, clients will do this themselves on the rep back, this sets up the cache
 		//HandleGripReplication(LocallyGrippedObjects[LocallyGrippedObjects.Num() - 1]);
@@ -4686,24 +5432,71 @@ void FExpandedLateUpdateManager::Setup(const FTransform& ParentToWorld, UGripMot
 
 	check(IsInGameThread());
 
+	VRGRIP_SCOPED_TIMING(GatherLateUpdatePrimitives);
+
 	LateUpdateParentToWorld[LateUpdateGameWriteIndex] = ParentToWorld;
-	LateUpdatePrimitives[LateUpdateGameWriteIndex].Reset();
-	GatherLateUpdatePrimitives(Component);
 	SkipLateUpdate[LateUpdateGameWriteIndex] = bSkipLateUpdate;
 
+	FrameRoots.Reset();
+	FrameRoots.Add(Component);
+
 	//Add additional late updates registered to this controller that aren't children and aren't gripped
 	//This array is editable in blueprint and can be used for things like arms or the like.
 
 	for (UPrimitiveComponent* primComp : Component->AdditionalLateUpdateComponents)
 	{
 		if (primComp)
-			GatherLateUpdatePrimitives(primComp);
+			FrameRoots.Add(primComp);
 	}
 
-
 	ProcessGripArrayLateUpdatePrimitives(Component, Component->LocallyGrippedObjects);
 	ProcessGripArrayLateUpdatePrimitives(Component, Component->GrippedObjects);
 
+	// Grips, drops and grips toggling their late updates change the roots, everything else is caught by revalidating the cached hierarchies
+	bool bSnapshotValid = CurrentSnapshot.IsValid() && FrameRoots == SnapshotRoots;
+
+	for (USceneComponent* Root : FrameRoots)
+	{
+		FLateUpdateHierarchy * Hierarchy = CachedHierarchies.Find(Root);
+		if (!Hierarchy || !IsLateUpdateHierarchyValid(*Hierarchy))
+		{
+			if (!Hierarchy)
+				Hierarchy = &CachedHierarchies.Add(Root);
+
+			Hierarchy->Components.Reset();
+			Hierarchy->ChildCounts.Reset();
+			Hierarchy->Children.Reset();
+			Hierarchy->Primitives.Reset();
+			GatherLateUpdateHierarchy(Root, *Hierarchy);
+			bSnapshotValid = false;
+		}
+	}
+
+	if (!bSnapshotValid)
+	{
+		// Drop hierarchies that aren't late updating anymore
+		for (auto It = CachedHierarchies.CreateIterator(); It; ++It)
+		{
+			if (!FrameRoots.Contains(It.Key()))
+				It.RemoveCurrent();
+		}
+
+		// Build a new snapshot, the render thread may still be reading the old one so it is never modified in place
+		TArray<LateUpdatePrimitiveInfo> * NewPrimitives = new TArray<LateUpdatePrimitiveInfo>();
+		for (USceneComponent* Root : FrameRoots)
+		{
+			for (const FLateUpdateCachedPrimitive & CachedPrimitive : CachedHierarchies.FindChecked(Root).Primitives)
+			{
+				if (CachedPrimitive.Info.SceneInfo)
+					NewPrimitives->Add(CachedPrimitive.Info);
+			}
+		}
+
+		CurrentSnapshot = FLateUpdateSnapshot(NewPrimitives);
+		SnapshotRoots = FrameRoots;
+	}
+
+	LateUpdatePrimitives[LateUpdateGameWriteIndex] = CurrentSnapshot;
 	LateUpdateGameWriteIndex = (LateUpdateGameWriteIndex + 1) % 2;
 }
 
@@ -4717,7 +5510,9 @@ void FExpandedLateUpdateManager::Apply_RenderThread(FSceneInterface* Scene, cons
 {
 	check(IsInRenderingThread());
 
-	if (!LateUpdatePrimitives[LateUpdateRenderReadIndex].Num())
+	// Hold onto the snapshot while we use it
+	FLateUpdateSnapshot Primitives = LateUpdatePrimitives[LateUpdateRenderReadIndex];
+	if (!Primitives.IsValid() || !Primitives->Num())
 	{
 		return;
 	}
@@ -4732,7 +5527,7 @@ void FExpandedLateUpdateManager::Apply_RenderThread(FSceneInterface* Scene, cons
 	const FMatrix LateUpdateTransform = (OldTransform.Inverse() * NewTransform).ToMatrixWithScale();
 
 	// Apply delta to the affected scene proxies
-	for (auto PrimitiveInfo : LateUpdatePrimitives[LateUpdateRenderReadIndex])
+	for (const LateUpdatePrimitiveInfo & PrimitiveInfo : *Primitives)
 	{
 		FPrimitiveSceneInfo* RetrievedSceneInfo = Scene->GetPrimitiveSceneInfo(*PrimitiveInfo.IndexAddress);
 		FPrimitiveSceneInfo* CachedSceneInfo = PrimitiveInfo.SceneInfo;
@@ -4746,44 +5541,73 @@ void FExpandedLateUpdateManager::Apply_RenderThread(FSceneInterface* Scene, cons
 
 void FExpandedLateUpdateManager::PostRender_RenderThread()
 {
+	// Only releases our reference, the game thread can still be sharing the snapshot
 	LateUpdatePrimitives[LateUpdateRenderReadIndex].Reset();
 	SkipLateUpdate[LateUpdateRenderReadIndex] = false;
 	LateUpdateRenderReadIndex = (LateUpdateRenderReadIndex + 1) % 2;
 }
 
-void FExpandedLateUpdateManager::CacheSceneInfo(USceneComponent* Component)
+void FExpandedLateUpdateManager::GatherLateUpdateHierarchy(USceneComponent* ParentComponent, FLateUpdateHierarchy & Hierarchy)
 {
-	// If a scene proxy is present, cache it
-	UPrimitiveComponent* PrimitiveComponent = dynamic_cast<UPrimitiveComponent*>(Component);
-	if (PrimitiveComponent && PrimitiveComponent->SceneProxy)
+	const TArray<USceneComponent*> & Children = ParentComponent->GetAttachChildren();
+
+	Hierarchy.Components.Add(ParentComponent);
+	Hierarchy.ChildCounts.Add(Children.Num());
+	Hierarchy.Children.Append(Children);
+
+	// If a scene proxy is present, cache it. Primitives without one are still tracked so that we notice when they get one.
+	if (UPrimitiveComponent* PrimitiveComponent = Cast<UPrimitiveComponent>(ParentComponent))
 	{
-		FPrimitiveSceneInfo* PrimitiveSceneInfo = PrimitiveComponent->SceneProxy->GetPrimitiveSceneInfo();
-		if (PrimitiveSceneInfo)
-		{
-			LateUpdatePrimitiveInfo PrimitiveInfo;
-			PrimitiveInfo.IndexAddress = PrimitiveSceneInfo->GetIndexAddress();
-			PrimitiveInfo.SceneInfo = PrimitiveSceneInfo;
-			LateUpdatePrimitives[LateUpdateGameWriteIndex].Add(PrimitiveInfo);
-		}
+		FLateUpdateCachedPrimitive & CachedPrimitive = Hierarchy.Primitives[Hierarchy.Primitives.AddDefaulted()];
+		CachedPrimitive.Component = PrimitiveComponent;
+		CachedPrimitive.Info.IndexAddress = nullptr;
+		CachedPrimitive.Info.SceneInfo = PrimitiveComponent->SceneProxy ? PrimitiveComponent->SceneProxy->GetPrimitiveSceneInfo() : nullptr;
+
+		if (CachedPrimitive.Info.SceneInfo)
+			CachedPrimitive.Info.IndexAddress = CachedPrimitive.Info.SceneInfo->GetIndexAddress();
+	}
+
+	for (USceneComponent* Component : Children)
+	{
+		if (Component != nullptr)
+			GatherLateUpdateHierarchy(Component, Hierarchy);
 	}
 }
 
-void FExpandedLateUpdateManager::GatherLateUpdatePrimitives(USceneComponent* ParentComponent)
+bool FExpandedLateUpdateManager::IsLateUpdateHierarchyValid(const FLateUpdateHierarchy & Hierarchy) const
 {
-	CacheSceneInfo(ParentComponent);
+	// Same count isn't enough, a detach and an attach in the same frame would keep it
+	int32 ChildOffset = 0;
+	for (int32 i = 0; i < Hierarchy.Components.Num(); ++i)
+	{
+		USceneComponent* Component = Hierarchy.Components[i].Get();
+		if (!Component)
+			return false;
 
-	TArray<USceneComponent*> Components;
-	ParentComponent->GetChildrenComponents(true, Components);
-	for (USceneComponent* Component : Components)
-	{	
-		if (Component != nullptr)
-			CacheSceneInfo(Component);
+		const TArray<USceneComponent*> & Children = Component->GetAttachChildren();
+		if (Children.Num() != Hierarchy.ChildCounts[i] || FMemory::Memcmp(Children.GetData(), Hierarchy.Children.GetData() + ChildOffset, Children.Num() * sizeof(USceneComponent*)) != 0)
+			return false;
+
+		ChildOffset += Children.Num();
 	}
+
+	for (const FLateUpdateCachedPrimitive & CachedPrimitive : Hierarchy.Primitives)
+	{
+		UPrimitiveComponent* PrimitiveComponent = CachedPrimitive.Component.Get();
+		if (!PrimitiveComponent)
+			return false;
+
+		FPrimitiveSceneInfo* SceneInfo = PrimitiveComponent->SceneProxy ? PrimitiveComponent->SceneProxy->GetPrimitiveSceneInfo() : nullptr;
+		if (SceneInfo != CachedPrimitive.Info.SceneInfo)
+			return false;
+	}
+
+	return true;
 }
 
-void FExpandedLateUpdateManager::ProcessGripArrayLateUpdatePrimitives(UGripMotionControllerComponent * MotionControllerComponent, TArray<FBPActorGripInformation> & GripArray)
+void FExpandedLateUpdateManager::ProcessGripArrayLateUpdatePrimitives(UGripMotionControllerComponent * MotionControllerComponent, const TArray<FBPActorGripInformation> & GripArray)
 {
-	for (FBPActorGripInformation actor : GripArray)
+	for (const FBPActorGripInformation & actor : GripArray)
 	{
 		// Skip actors that are colliding if turning off late updates during collision.
 		// Also skip turning off late updates for SweepWithPhysics, as it should always be locked to the hand
@@ -4843,7 +5667,7 @@ void FExpandedLateUpdateManager::ProcessGripArrayLateUpdatePrimitives(UGripMotio
 			{
 				if (USceneComponent * rootComponent = pActor->GetRootComponent())
 				{
-					GatherLateUpdatePrimitives(rootComponent);
+					FrameRoots.Add(rootComponent);
 				}
 			}
 
@@ -4855,7 +5679,7 @@ void FExpandedLateUpdateManager::ProcessGripArrayLateUpdatePrimitives(UGripMotio
 			UPrimitiveComponent * cPrimComp = actor.GetGrippedComponent();
 			if (cPrimComp)
 			{
-				GatherLateUpdatePrimitives(cPrimComp);
+				FrameRoots.Add(cPrimComp);
 			}
 		}break;
 		}
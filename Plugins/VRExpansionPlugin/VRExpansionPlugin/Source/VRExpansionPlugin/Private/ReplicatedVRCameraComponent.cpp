@@ -31,6 +31,8 @@ UReplicatedVRCameraComponent::UReplicatedVRCameraComponent(const FObjectInitiali
 	bSmoothReplicatedMotion = false;
 	bLerpingPosition = false;
 	bReppedOnce = false;
+	LastRemoteUpdateTime = 0.0;
+	RemoteLerpDuration = 0.0f;
 
 	OverrideSendTransform = nullptr;
 
@@ -68,6 +70,10 @@ void UReplicatedVRCameraComponent::GetLifetimeReplicatedProps(TArray< class FLif
 
 void UReplicatedVRCameraComponent::Server_SendCameraTransform_Implementation(FBPVRComponentPosRep NewTransform)
 {
+	// Delta based on a keyframe we never got, wait for the next one
+	if (!NewTransform.ResolveDelta(PosRepDeltaState))
+		return;
+
 	// Store new transform and trigger OnRep_Function
 	ReplicatedCameraTransform = NewTransform;
 
@@ -135,20 +141,34 @@ void UReplicatedVRCameraComponent::TickComponent(float DeltaTime, enum ELevelTic
 		// Send changes
 		if (bReplicates)
 		{
+			AVRBaseCharacter * BundlingChar = (GetNetMode() == NM_Client) ? Cast<AVRBaseCharacter>(GetOwner()) : nullptr;
+
+			// The character samples all of its devices on the same frame and handles the rate and change checks for the bundle
+			if (BundlingChar && BundlingChar->IsTrackedDeviceBundled(this))
+			{
+				ReplicatedCameraTransform.Position = this->RelativeLocation;
+				ReplicatedCameraTransform.Rotation = this->RelativeRotation;
+				ReplicatedCameraTransform.SetTimeStamp(bSmoothReplicatedMotion, FPlatformTime::Seconds());
+				BundlingChar->ReportTrackedDevice(this, ReplicatedCameraTransform);
+			}
 			// Don't rep if no changes
-			if (!this->RelativeLocation.Equals(ReplicatedCameraTransform.Position) ||  !this->RelativeRotation.Equals(ReplicatedCameraTransform.Rotation))
+			else if (!this->RelativeLocation.Equals(ReplicatedCameraTransform.Position) ||  !this->RelativeRotation.Equals(ReplicatedCameraTransform.Rotation))
 			{
 				NetUpdateCount += DeltaTime;
+				const float SendRate = AdaptiveNetUpdateRate.GetNetUpdateRate(ReplicatedCameraTransform, this->RelativeLocation, this->RelativeRotation, NetUpdateCount, NetUpdateRate);
 
-				if (NetUpdateCount >= (1.0f / NetUpdateRate))
+				if (NetUpdateCount >= (1.0f / SendRate))
 				{
 					NetUpdateCount = 0.0f;
 					ReplicatedCameraTransform.Position = this->RelativeLocation;
 					ReplicatedCameraTransform.Rotation = this->RelativeRotation;
+					ReplicatedCameraTransform.SetTimeStamp(bSmoothReplicatedMotion, FPlatformTime::Seconds());
 
 
 					if (GetNetMode() == NM_Client)
 					{
+						ReplicatedCameraTransform.PrepareDeltaSend(PosRepDeltaState);
+
 						AVRBaseCharacter * OwningChar = Cast<AVRBaseCharacter>(GetOwner());
 						if (OverrideSendTransform != nullptr && OwningChar != nullptr)
 						{
@@ -167,10 +187,18 @@ void UReplicatedVRCameraComponent::TickComponent(float DeltaTime, enum ELevelTic
 	}
 	else
 	{
-		if (bLerpingPosition)
+		FVector BufferedPosition;
+		FRotator BufferedRotation;
+
+		if (bSmoothReplicatedMotion && RemotePoseBuffer.HasSamples())
+		{
+			if (RemotePoseBuffer.Sample(FPlatformTime::Seconds(), BufferedPosition, BufferedRotation))
+				SetRelativeLocationAndRotation(BufferedPosition, BufferedRotation);
+		}
+		else if (bLerpingPosition)
 		{
 			NetUpdateCount += DeltaTime;
-			float LerpVal = FMath::Clamp(NetUpdateCount / (1.0f / NetUpdateRate), 0.0f, 1.0f);
+			float LerpVal = RemoteLerpDuration > 0.0f ? FMath::Clamp(NetUpdateCount / RemoteLerpDuration, 0.0f, 1.0f) : 1.0f;
 
 			if (LerpVal >= 1.0f)
 			{
@@ -1,6 +1,8 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "VRBPDataTypes.h"
+#include "UObject/CoreNet.h"
+#include "VRGestureComponent.h" // for UGesturesDatabase in the pos rep encoding benchmark
 
 namespace VRDataTypeCVARs
 {
@@ -89,4 +91,461 @@ bool FTransform_NetQuantize::NetSerialize(FArchive& Ar, class UPackageMap* Map,
 	}
 
 	return bOutSuccess;
-}
\ No newline at end of file
+}
+
+namespace VRPosRepDelta
+{
+	static const int32 KeyframeIDBits = 3;
+	static const uint8 KeyframeIDMask = (1 << KeyframeIDBits) - 1;
+
+	// Deltas are sent at two decimal places, anything needing more than this many bits per axis goes out as a keyframe instead.
+	// The range check keeps two bits of headroom, so a delta can be up to 2^22 / 100 = ~41943 units (~419m) from its keyframe.
+	static const uint32 MaxDeltaBits = 24;
+	static const float MaxDeltaRange = (float)(1 << (MaxDeltaBits - 2)) / 100.f;
+
+	// Smallest three components are in [-1/sqrt(2), 1/sqrt(2)]
+	static const float Sqrt2 = 1.41421356f;
+	static const uint32 SmallestThreeBits = 14;
+	static const uint32 SmallestThreeMax = (1 << SmallestThreeBits) - 1;
+
+	inline uint32 ZigZag(int32 Value)
+	{
+		return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+	}
+
+	inline int32 UnZigZag(uint32 Value)
+	{
+		return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+	}
+
+	inline FVector QuantizeKeyframe(const FVector & Position)
+	{
+		// Same rounding SerializePackedVector<100, 30> does so the senders baseline matches what the receiver decodes
+		return FVector(FMath::RoundToInt(Position.X * 100.f), FMath::RoundToInt(Position.Y * 100.f), FMath::RoundToInt(Position.Z * 100.f)) / 100.f;
+	}
+}
+
+void FBPVRComponentPosRep::PrepareDeltaSend(FVRPosRepDeltaState & State, int32 KeyframeInterval)
+{
+	if (QuantizationLevel != EVRVectorQuantization::DeltaSmallestThree)
+		return;
+
+	const bool bOutOfRange = State.bHasKeyframe && (Position - State.KeyframePosition).GetAbsMax() >= VRPosRepDelta::MaxDeltaRange;
+
+	if (!State.bHasKeyframe || bOutOfRange || ++State.UpdatesSinceKeyframe >= KeyframeInterval)
+	{
+		State.KeyframeID = (State.KeyframeID + 1) & VRPosRepDelta::KeyframeIDMask;
+		State.KeyframePosition = VRPosRepDelta::QuantizeKeyframe(Position);
+		State.bHasKeyframe = true;
+		State.UpdatesSinceKeyframe = 0;
+		bIsDelta = false;
+	}
+	else
+	{
+		bIsDelta = true;
+		DeltaBaseline = State.KeyframePosition;
+	}
+
+	KeyframeID = State.KeyframeID;
+}
+
+bool FBPVRComponentPosRep::ResolveDelta(FVRPosRepDeltaState & State)
+{
+	if (QuantizationLevel != EVRVectorQuantization::DeltaSmallestThree)
+		return true;
+
+	if (!bIsDelta)
+	{
+		State.KeyframePosition = Position;
+		State.KeyframeID = KeyframeID;
+		State.bHasKeyframe = true;
+		return true;
+	}
+
+	// The keyframe this is based on was lost, wait for the next one
+	if (!State.bHasKeyframe || State.KeyframeID != KeyframeID)
+		return false;
+
+	Position += State.KeyframePosition;
+	bIsDelta = false;
+	return true;
+}
+
+bool FBPVRComponentPosRep::NetSerializeDeltaSmallestThree(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar.SerializeBits(&bIsDelta, 1);
+	Ar.SerializeBits(&KeyframeID, VRPosRepDelta::KeyframeIDBits);
+
+	if (!bIsDelta)
+	{
+		bOutSuccess &= SerializePackedVector<100, 30>(Position, Ar);
+	}
+	else
+	{
+		// Adaptive width, one bit count for all three axis and then each axis zigzag encoded at that width
+		uint32 Deltas[3] = { 0, 0, 0 };
+		uint32 NumBits = 0;
+
+		if (Ar.IsSaving())
+		{
+			const FVector Delta = (Position - DeltaBaseline) * 100.f;
+			Deltas[0] = VRPosRepDelta::ZigZag(FMath::RoundToInt(Delta.X));
+			Deltas[1] = VRPosRepDelta::ZigZag(FMath::RoundToInt(Delta.Y));
+			Deltas[2] = VRPosRepDelta::ZigZag(FMath::RoundToInt(Delta.Z));
+
+			const uint32 MaxValue = FMath::Max3(Deltas[0], Deltas[1], Deltas[2]);
+			NumBits = MaxValue ? FMath::FloorLog2(MaxValue) + 1 : 0;
+		}
+
+		Ar.SerializeBits(&NumBits, 5);
+
+		if (NumBits > VRPosRepDelta::MaxDeltaBits)
+		{
+			bOutSuccess = false;
+			return false;
+		}
+
+		for (int32 i = 0; i < 3; ++i)
+		{
+			Ar.SerializeBits(&Deltas[i], NumBits);
+		}
+
+		if (Ar.IsLoading())
+		{
+			// Still relative to the keyframe, ResolveDelta() adds it back in
+			Position = FVector(VRPosRepDelta::UnZigZag(Deltas[0]), VRPosRepDelta::UnZigZag(Deltas[1]), VRPosRepDelta::UnZigZag(Deltas[2])) / 100.f;
+		}
+	}
+
+	// Smallest three, the largest component is dropped and rebuilt from the unit length
+	uint32 LargestIndex = 0;
+	uint32 Components[3] = { 0, 0, 0 };
+
+	if (Ar.IsSaving())
+	{
+		FQuat Quat = Rotation.Quaternion();
+		Quat.Normalize();
+
+		float Values[4] = { Quat.X, Quat.Y, Quat.Z, Quat.W };
+		for (uint32 i = 1; i < 4; ++i)
+		{
+			if (FMath::Abs(Values[i]) > FMath::Abs(Values[LargestIndex]))
+				LargestIndex = i;
+		}
+
+		// q and -q are the same rotation, keep the dropped one positive
+		const float Sign = Values[LargestIndex] < 0.f ? -1.f : 1.f;
+
+		for (uint32 i = 0, c = 0; i < 4; ++i)
+		{
+			if (i == LargestIndex)
+				continue;
+
+			const float Normalized = FMath::Clamp((Values[i] * Sign * VRPosRepDelta::Sqrt2 + 1.f) * 0.5f, 0.f, 1.f);
+			Components[c++] = (uint32)FMath::RoundToInt(Normalized * VRPosRepDelta::SmallestThreeMax);
+		}
+	}
+
+	Ar.SerializeBits(&LargestIndex, 2);
+	for (int32 i = 0; i < 3; ++i)
+	{
+		Ar.SerializeBits(&Components[i], VRPosRepDelta::SmallestThreeBits);
+	}
+
+	if (Ar.IsLoading())
+	{
+		float Values[4];
+		float SumSquared = 0.f;
+
+		for (uint32 i = 0, c = 0; i < 4; ++i)
+		{
+			if (i == LargestIndex)
+				continue;
+
+			Values[i] = (((float)Components[c++] / VRPosRepDelta::SmallestThreeMax) * 2.f - 1.f) / VRPosRepDelta::Sqrt2;
+			SumSquared += FMath::Square(Values[i]);
+		}
+
+		Values[LargestIndex] = FMath::Sqrt(FMath::Max(0.f, 1.f - SumSquared));
+
+		FQuat Quat(Values[0], Values[1], Values[2], Values[3]);
+		Quat.Normalize();
+		Rotation = Quat.Rotator();
+	}
+
+	return bOutSuccess;
+}
+
+const float FVRReplicatedPoseBuffer::MaxExtrapolationTime = 0.1f;
+const float FVRReplicatedPoseBuffer::MaxPlaybackDelay = 0.25f;
+const double FVRReplicatedPoseBuffer::MaxArrivalGap = 30.0;
+
+void FVRReplicatedPoseBuffer::AddSample(const FBPVRComponentPosRep & PosRep, double LocalTime)
+{
+	// After a long pause (relevancy, dormancy, a hitch) the stamp may have wrapped past what we can unwrap, start over
+	if (bHasClock && LocalTime - LastArrivalTime > MaxArrivalGap)
+		Reset();
+
+	// Unwrap the 16 bit millisecond stamp against the newest one we have seen
+	int64 TimeStampMS = PosRep.TimeStamp;
+	if (bHasClock)
+		TimeStampMS = LastTimeStampMS + (int16)(PosRep.TimeStamp - (uint16)(LastTimeStampMS & 0xFFFF));
+
+	const double SenderTime = TimeStampMS / 1000.0;
+
+	// Out of order or duplicate, playback has already been given something newer
+	if (Samples.Num() && SenderTime <= Samples.Last().SenderTime)
+	{
+		// A run of them means the unwrap went the wrong way, resync on this sample instead of freezing
+		if (++RejectedSamples < MaxRejectedSamples)
+			return;
+
+		Reset();
+		AddSample(PosRep, LocalTime);
+		return;
+	}
+
+	RejectedSamples = 0;
+
+	const double Offset = LocalTime - SenderTime;
+
+	if (!bHasClock)
+	{
+		ClockOffset = Offset;
+		bHasClock = true;
+	}
+	else
+	{
+		// The floor creeps up slowly so clock drift or a route change doesn't leave it pinned to an old low
+		ClockOffset = FMath::Min(Offset, ClockOffset + (LocalTime - LastArrivalTime) * 0.01);
+		Jitter = FMath::Lerp(Jitter, (float)(Offset - ClockOffset), 0.1f);
+
+		if (Samples.Num())
+			SendInterval = FMath::Lerp(SendInterval, (float)(SenderTime - Samples.Last().SenderTime), 0.1f);
+	}
+
+	LastTimeStampMS = TimeStampMS;
+	LastArrivalTime = LocalTime;
+
+	FPoseSample & NewSample = Samples[Samples.AddUninitialized()];
+	NewSample.SenderTime = SenderTime;
+	NewSample.Position = PosRep.Position;
+	NewSample.Rotation = PosRep.Rotation.Quaternion();
+
+	if (Samples.Num() > MaxSamples)
+		Samples.RemoveAt(0, Samples.Num() - MaxSamples, false);
+}
+
+bool FVRReplicatedPoseBuffer::Sample(double LocalTime, FVector & OutPosition, FRotator & OutRotation)
+{
+	if (!Samples.Num())
+		return false;
+
+	// Far enough behind the newest update to cover one send interval plus the jitter we have been seeing, eased so playback doesn't jump
+	const float TargetDelay = FMath::Clamp(SendInterval + (Jitter * 2.0f), 0.0f, MaxPlaybackDelay);
+	PlaybackDelay = FMath::Lerp(PlaybackDelay, TargetDelay, 0.05f);
+
+	const double PlaybackTime = LocalTime - ClockOffset - PlaybackDelay;
+
+	// Drop what playback has passed, keeping one sample behind the current segment for its tangent
+	int32 NumPassed = 0;
+	while (NumPassed + 2 < Samples.Num() && Samples[NumPassed + 2].SenderTime <= PlaybackTime)
+		++NumPassed;
+	if (NumPassed > 0)
+		Samples.RemoveAt(0, NumPassed, false);
+
+	const int32 LastIndex = Samples.Num() - 1;
+
+	if (LastIndex == 0 || PlaybackTime <= Samples[0].SenderTime)
+	{
+		OutPosition = Samples[0].Position;
+		OutRotation = Samples[0].Rotation.Rotator();
+		return true;
+	}
+
+	// Past the newest update, carry on along its velocity for a bounded time and then hold
+	if (PlaybackTime >= Samples[LastIndex].SenderTime)
+	{
+		const FPoseSample & Prev = Samples[LastIndex - 1];
+		const FPoseSample & Last = Samples[LastIndex];
+		const double SegmentTime = FMath::Max(Last.SenderTime - Prev.SenderTime, 0.001);
+		const float Extrapolation = (float)(FMath::Min(PlaybackTime - Last.SenderTime, (double)MaxExtrapolationTime) / SegmentTime);
+
+		OutPosition = Last.Position + (Last.Position - Prev.Position) * Extrapolation;
+
+		FVector Axis;
+		float Angle;
+		(Last.Rotation * Prev.Rotation.Inverse()).GetNormalized().ToAxisAndAngle(Axis, Angle);
+		Angle = FMath::UnwindRadians(Angle);
+		OutRotation = (FQuat(Axis, Angle * Extrapolation) * Last.Rotation).Rotator();
+		return true;
+	}
+
+	int32 Index = 0;
+	while (Index < LastIndex - 1 && Samples[Index + 1].SenderTime <= PlaybackTime)
+		++Index;
+
+	const FPoseSample & P0 = Samples[Index];
+	const FPoseSample & P1 = Samples[Index + 1];
+	const double SegmentTime = FMath::Max(P1.SenderTime - P0.SenderTime, 0.001);
+	const float Alpha = (float)((PlaybackTime - P0.SenderTime) / SegmentTime);
+
+	// Catmull-Rom style velocities from the neighbours, one sided at the ends of the buffer
+	const FPoseSample & Before = Samples[FMath::Max(Index - 1, 0)];
+	const FPoseSample & After = Samples[FMath::Min(Index + 2, LastIndex)];
+	const FVector Velocity0 = (P1.Position - Before.Position) / (float)FMath::Max(P1.SenderTime - Before.SenderTime, 0.001);
+	const FVector Velocity1 = (After.Position - P0.Position) / (float)FMath::Max(After.SenderTime - P0.SenderTime, 0.001);
+
+	OutPosition = FMath::CubicInterp(P0.Position, Velocity0 * (float)SegmentTime, P1.Position, Velocity1 * (float)SegmentTime, Alpha);
+	OutRotation = FQuat::Slerp(P0.Rotation, P1.Rotation, Alpha).Rotator();
+	return true;
+}
+
+namespace VRPosRepBenchmark
+{
+	struct FEncoderResult
+	{
+		int64 TotalBits;
+		int32 Updates;
+		int32 Dropped;
+		float MaxPositionError;
+		float MaxAngleError;
+
+		FEncoderResult() :
+			TotalBits(0),
+			Updates(0),
+			Dropped(0),
+			MaxPositionError(0.f),
+			MaxAngleError(0.f)
+		{}
+	};
+
+	// Sends every sample through NetSerialize on both ends like the rpc would, dropping LossPercent of the packets on the way
+	static FEncoderResult RunEncoder(const TArray<FTransform> & Motion, EVRVectorQuantization Level, float LossPercent, FRandomStream & RandStream)
+	{
+		FEncoderResult Result;
+		FVRPosRepDeltaState SendState;
+		FVRPosRepDeltaState ReceiveState;
+
+		for (const FTransform & Sample : Motion)
+		{
+			FBPVRComponentPosRep Sent;
+			Sent.QuantizationLevel = Level;
+			Sent.Position = Sample.GetTranslation();
+			Sent.Rotation = Sample.Rotator();
+			Sent.PrepareDeltaSend(SendState);
+
+			FNetBitWriter Writer(nullptr, 1024);
+			bool bSuccess = true;
+			Sent.NetSerialize(Writer, nullptr, bSuccess);
+
+			Result.TotalBits += Writer.GetNumBits();
+			Result.Updates++;
+
+			if (RandStream.FRand() * 100.f < LossPercent)
+				continue;
+
+			FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+			FBPVRComponentPosRep Received;
+			Received.NetSerialize(Reader, nullptr, bSuccess);
+
+			if (!bSuccess || !Received.ResolveDelta(ReceiveState))
+			{
+				Result.Dropped++;
+				continue;
+			}
+
+			Result.MaxPositionError = FMath::Max(Result.MaxPositionError, FVector::Dist(Received.Position, Sent.Position));
+			Result.MaxAngleError = FMath::Max(Result.MaxAngleError, FMath::RadiansToDegrees(Received.Rotation.Quaternion().AngularDistance(Sample.GetRotation())));
+		}
+
+		return Result;
+	}
+
+	static void RunPosRepEncodingBenchmark(const TArray<FString> & Args)
+	{
+		const float UpdateRate = 90.f;
+		FRandomStream RandStream(1234);
+		TArray<TArray<FTransform>> Tracks;
+
+		if (Args.Num() > 0)
+		{
+			// Recorded controller motion from a gesture database, those only store position so orientation follows the direction of travel
+			UGesturesDatabase * Database = UGesturesDatabase::LoadCookedGestures(GetTransientPackage(), Args[0]);
+			if (Database == nullptr)
+				return;
+
+			for (const FVRGesture & Gesture : Database->Gestures)
+			{
+				TArray<FTransform> & Track = Tracks[Tracks.AddDefaulted()];
+				FQuat Facing = FQuat::Identity;
+
+				// Samples are stored newest first
+				for (int i = Gesture.Samples.Num() - 1; i >= 0; --i)
+				{
+					if (i < Gesture.Samples.Num() - 1)
+					{
+						const FVector Travel = Gesture.Samples[i] - Gesture.Samples[i + 1];
+						if (!Travel.IsNearlyZero())
+							Facing = FQuat::Slerp(Facing, Travel.ToOrientationQuat(), 0.2f);
+					}
+
+					Track.Add(FTransform(Facing, Gesture.Samples[i]));
+				}
+			}
+		}
+		else
+		{
+			// A minute of generated hand motion, a slow reach around the body with tremor on top
+			TArray<FTransform> & Track = Tracks[Tracks.AddDefaulted()];
+			const FVector Shoulder(0.f, 20.f, 140.f);
+
+			for (int i = 0; i < (int)(UpdateRate * 60.f); ++i)
+			{
+				const float Time = i / UpdateRate;
+				const FVector Reach(
+					40.f + 15.f * FMath::Sin(Time * 1.3f),
+					25.f * FMath::Sin(Time * 0.7f + 1.f),
+					-30.f + 20.f * FMath::Sin(Time * 0.9f + 2.f));
+
+				const FVector Tremor = RandStream.GetUnitVector() * 0.05f;
+				const FRotator Orientation(30.f * FMath::Sin(Time * 1.1f), 60.f * FMath::Sin(Time * 0.5f), 45.f * FMath::Sin(Time * 0.8f + 0.5f));
+
+				Track.Add(FTransform(Orientation, Shoulder + Reach + Tremor));
+			}
+		}
+
+		const float LossPercents[] = { 0.f, 5.f };
+		const EVRVectorQuantization Levels[] = { EVRVectorQuantization::RoundTwoDecimals, EVRVectorQuantization::DeltaSmallestThree };
+
+		for (float LossPercent : LossPercents)
+		{
+			for (EVRVectorQuantization Level : Levels)
+			{
+				FEncoderResult Total;
+
+				for (const TArray<FTransform> & Track : Tracks)
+				{
+					FRandomStream LossStream(4321);
+					FEncoderResult TrackResult = RunEncoder(Track, Level, LossPercent, LossStream);
+					Total.TotalBits += TrackResult.TotalBits;
+					Total.Updates += TrackResult.Updates;
+					Total.Dropped += TrackResult.Dropped;
+					Total.MaxPositionError = FMath::Max(Total.MaxPositionError, TrackResult.MaxPositionError);
+					Total.MaxAngleError = FMath::Max(Total.MaxAngleError, TrackResult.MaxAngleError);
+				}
+
+				const float BitsPerUpdate = Total.Updates > 0 ? (float)Total.TotalBits / Total.Updates : 0.f;
+				UE_LOG(LogTemp, Display, TEXT("PosRep %s, %.0f%% loss: %.1f bits/update, %.0f bits/s at %.0f htz, max error %.3f cm / %.3f deg, %d of %d undecodable after loss"),
+					Level == EVRVectorQuantization::DeltaSmallestThree ? TEXT("DeltaSmallestThree") : TEXT("RoundTwoDecimals"),
+					LossPercent, BitsPerUpdate, BitsPerUpdate * UpdateRate, UpdateRate,
+					Total.MaxPositionError, Total.MaxAngleError, Total.Dropped, Total.Updates);
+			}
+		}
+	}
+
+	FAutoConsoleCommand CmdBenchmarkPosRepEncoding(
+		TEXT("vr.BenchmarkPosRepEncoding"),
+		TEXT("Replays recorded controller motion from a cooked gesture database (optional path argument) or generated hand motion through the RoundTwoDecimals and DeltaSmallestThree pos rep encoders and logs bits per second and error."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunPosRepEncodingBenchmark));
+}
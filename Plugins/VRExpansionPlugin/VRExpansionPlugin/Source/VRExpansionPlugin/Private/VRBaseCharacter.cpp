@@ -96,6 +96,104 @@ AVRBaseCharacter::AVRBaseCharacter(const FObjectInitializer& ObjectInitializer)
 	ReplicatedMovement.RotationQuantizationLevel = ERotatorQuantization::ShortComponents;
 
 	VRReplicateCapsuleHeight = false;
+
+	bBundleTrackedDeviceReplication = false;
+	BundledTrackedDeviceLayoutKey = 0;
+	TrackedDeviceNetUpdateRate = 100.0f; // 100 htz is default, same as the devices
+	ReportedTrackedDeviceMask = 0;
+	SentTrackedDeviceMask = 0;
+	TrackedDeviceReportFrame = 0;
+	LastTrackedDeviceSendTime = 0.0f;
+	LastTrackedDeviceGatherTime = 0.0f;
+	bLoggedTrackedDeviceLayoutMismatch = false;
+	ExpectedTrackedDeviceMask = 0;
+}
+
+void AVRBaseCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (bBundleTrackedDeviceReplication && HasAuthority())
+		GatherBundledTrackedDevices();
+}
+
+void AVRBaseCharacter::GatherBundledTrackedDevices()
+{
+	if (UWorld * MyWorld = GetWorld())
+		LastTrackedDeviceGatherTime = MyWorld->GetTimeSeconds();
+
+	TArray<USceneComponent *> NewTrackedDevices;
+
+	// Non replicating devices never report, leave them out so they don't hold up the bundle
+	if (VRReplicatedCamera && VRReplicatedCamera->GetIsReplicated())
+		NewTrackedDevices.Add(VRReplicatedCamera);
+	if (LeftMotionController && LeftMotionController->GetIsReplicated())
+		NewTrackedDevices.Add(LeftMotionController);
+	if (RightMotionController && RightMotionController->GetIsReplicated())
+		NewTrackedDevices.Add(RightMotionController);
+
+	TArray<UGripMotionControllerComponent*> OtherControllers;
+	GetComponents<UGripMotionControllerComponent>(OtherControllers);
+	OtherControllers.RemoveAll([this](const UGripMotionControllerComponent * MotionController)
+	{
+		return MotionController == LeftMotionController || MotionController == RightMotionController || !MotionController->GetIsReplicated();
+	});
+
+	// Devices that already have a slot keep it, new ones go on the end
+	OtherControllers.Sort([this](const UGripMotionControllerComponent & A, const UGripMotionControllerComponent & B)
+	{
+		const int32 SlotA = BundledTrackedDevices.IndexOfByKey(&A);
+		const int32 SlotB = BundledTrackedDevices.IndexOfByKey(&B);
+		return (SlotA != INDEX_NONE && (SlotB == INDEX_NONE || SlotA < SlotB));
+	});
+
+	for (UGripMotionControllerComponent * MotionController : OtherControllers)
+	{
+		// Past the limit it keeps using its own rpcs
+		if (NewTrackedDevices.Num() >= FBPVRTrackedDevicesRep::MaxDevices)
+			break;
+
+		NewTrackedDevices.Add(MotionController);
+	}
+
+	if (NewTrackedDevices == BundledTrackedDevices)
+		return;
+
+	BundledTrackedDevices = NewTrackedDevices;
+	BundledTrackedDeviceLayoutKey++;
+	bLoggedTrackedDeviceLayoutMismatch = false;
+
+	// Devices lerp remote motion over their own update rate, keep it matched to what the bundle actually sends at
+	for (USceneComponent * Device : BundledTrackedDevices)
+	{
+		if (UGripMotionControllerComponent * MotionController = Cast<UGripMotionControllerComponent>(Device))
+			MotionController->ControllerNetUpdateRate = TrackedDeviceNetUpdateRate;
+		else if (UReplicatedVRCameraComponent * Camera = Cast<UReplicatedVRCameraComponent>(Device))
+			Camera->NetUpdateRate = TrackedDeviceNetUpdateRate;
+	}
+
+	ResetBundledTrackedDeviceSamples();
+}
+
+void AVRBaseCharacter::OnRep_BundledTrackedDevices()
+{
+	ResetBundledTrackedDeviceSamples();
+}
+
+void AVRBaseCharacter::ResetBundledTrackedDeviceSamples()
+{
+	ExpectedTrackedDeviceMask = 0;
+	for (int32 i = 0; i < BundledTrackedDevices.Num(); ++i)
+	{
+		if (BundledTrackedDevices[i])
+			ExpectedTrackedDeviceMask |= (1 << i);
+	}
+
+	SampledTrackedDevices.SetNum(BundledTrackedDevices.Num());
+	LastSentTrackedDevices.SetNum(BundledTrackedDevices.Num());
+	LastSentTrackedDeviceTimes.SetNumZeroed(BundledTrackedDevices.Num());
+	ReportedTrackedDeviceMask = 0;
+	SentTrackedDeviceMask = 0;
 }
 
 void AVRBaseCharacter::OnRep_PlayerState()
@@ -110,6 +208,8 @@ void AVRBaseCharacter::GetLifetimeReplicatedProps(TArray< class FLifetimePropert
 	DOREPLIFETIME_CONDITION(AVRBaseCharacter, SeatInformation, COND_OwnerOnly);
 	DOREPLIFETIME_CONDITION(AVRBaseCharacter, VRReplicateCapsuleHeight, COND_None);
 	DOREPLIFETIME_CONDITION(AVRBaseCharacter, ReplicatedCapsuleHeight, COND_SimulatedOnly);
+	DOREPLIFETIME_CONDITION(AVRBaseCharacter, BundledTrackedDevices, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(AVRBaseCharacter, BundledTrackedDeviceLayoutKey, COND_OwnerOnly);
 }
 
 void AVRBaseCharacter::PreReplication(IRepChangedPropertyTracker & ChangedPropertyTracker)
@@ -119,6 +219,16 @@ void AVRBaseCharacter::PreReplication(IRepChangedPropertyTracker & ChangedProper
 	DOREPLIFETIME_ACTIVE_OVERRIDE(AVRBaseCharacter, ReplicatedCapsuleHeight, VRReplicateCapsuleHeight);
 }
 
+float AVRBaseCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	// Our own connection and anyone viewing through us always get the normal priority, and channels that aren't open yet
+	// are left to the engine so newly relevant characters don't get starved
+	if (!NetPriorityPolicy.bUseNetPriorityPolicy || !InChannel || ViewTarget == this || (Controller && Viewer == Controller))
+		return Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	return NetPriority * Time * NetPriorityPolicy.GetPriorityScale(ViewPos, ViewDir, GetActorLocation(), bLowBandwidth);
+}
+
 USkeletalMeshComponent* AVRBaseCharacter::GetIKMesh_Implementation() const
 {
 	return nullptr;
@@ -204,6 +314,143 @@ bool AVRBaseCharacter::Server_SendTransformRightController_Validate(FBPVRCompone
 	return true;
 	// Optionally check to make sure that player is inside of their bounds and deny it if they aren't?
 }
+
+void AVRBaseCharacter::Server_SendTrackedDevices_Implementation(const FBPVRTrackedDevicesRep & TrackedDevices)
+{
+	// Picks up devices that were added or destroyed at runtime, no more than once a second
+	UWorld * MyWorld = GetWorld();
+	if (MyWorld && (HasStaleBundledTrackedDevice() || MyWorld->GetTimeSeconds() - LastTrackedDeviceGatherTime >= 1.0f))
+		GatherBundledTrackedDevices();
+
+	// The client hasn't gotten the current slot list yet, slots would land on the wrong device
+	if (TrackedDevices.LayoutKey != BundledTrackedDeviceLayoutKey)
+	{
+		if (!bLoggedTrackedDeviceLayoutMismatch)
+		{
+			UE_LOG(LogBaseVRCharacter, Log, TEXT("Dropping tracked device bundles on %s until the client has slot layout %d (sent with %d)"), *GetName(), BundledTrackedDeviceLayoutKey, TrackedDevices.LayoutKey);
+			bLoggedTrackedDeviceLayoutMismatch = true;
+		}
+
+		return;
+	}
+
+	const int32 NumDevices = FMath::Min(TrackedDevices.Devices.Num(), BundledTrackedDevices.Num());
+	for (int32 i = 0; i < NumDevices; ++i)
+	{
+		if (!TrackedDevices.IsDeviceDirty(i) || !BundledTrackedDevices[i])
+			continue;
+
+		if (UGripMotionControllerComponent * MotionController = Cast<UGripMotionControllerComponent>(BundledTrackedDevices[i]))
+			MotionController->Server_SendControllerTransform_Implementation(TrackedDevices.Devices[i]);
+		else if (UReplicatedVRCameraComponent * Camera = Cast<UReplicatedVRCameraComponent>(BundledTrackedDevices[i]))
+			Camera->Server_SendCameraTransform_Implementation(TrackedDevices.Devices[i]);
+	}
+}
+
+bool AVRBaseCharacter::Server_SendTrackedDevices_Validate(const FBPVRTrackedDevicesRep & TrackedDevices)
+{
+	return TrackedDevices.Devices.Num() <= FBPVRTrackedDevicesRep::MaxDevices;
+	// Optionally check to make sure that player is inside of their bounds and deny it if they aren't?
+}
+
+void AVRBaseCharacter::ReportTrackedDevice(USceneComponent * Device, const FBPVRComponentPosRep & NewTransform)
+{
+	// Something didn't report last frame (untracked controller), send what we had rather than holding it forever
+	if (TrackedDeviceReportFrame != GFrameCounter)
+	{
+		SendBundledTrackedDevices();
+		TrackedDeviceReportFrame = GFrameCounter;
+	}
+
+	// Devices check IsTrackedDeviceBundled first, this only misses if the slots replicated in between
+	const int32 Slot = BundledTrackedDevices.IndexOfByKey(Device);
+	if (Slot == INDEX_NONE)
+		return;
+
+	SampledTrackedDevices[Slot] = NewTransform;
+	ReportedTrackedDeviceMask |= (1 << Slot);
+
+	if ((ReportedTrackedDeviceMask & ExpectedTrackedDeviceMask) == ExpectedTrackedDeviceMask)
+		SendBundledTrackedDevices();
+}
+
+void AVRBaseCharacter::SendBundledTrackedDevices()
+{
+	if (!ReportedTrackedDeviceMask)
+		return;
+
+	const uint32 ReportedMask = ReportedTrackedDeviceMask;
+	ReportedTrackedDeviceMask = 0;
+
+	UWorld * MyWorld = GetWorld();
+	if (!MyWorld || TrackedDeviceNetUpdateRate <= 0.0f)
+		return;
+
+	const float CurrentTime = MyWorld->GetTimeSeconds();
+	if (CurrentTime - LastTrackedDeviceSendTime < (1.0f / TrackedDeviceNetUpdateRate))
+		return;
+
+	FBPVRTrackedDevicesRep TrackedDevices;
+	TrackedDevices.LayoutKey = BundledTrackedDeviceLayoutKey;
+	TrackedDevices.Devices.SetNum(BundledTrackedDevices.Num());
+
+	for (int32 i = 0; i < BundledTrackedDevices.Num(); ++i)
+	{
+		if (!(ReportedMask & (1 << i)))
+			continue;
+
+		const FBPVRComponentPosRep & Sample = SampledTrackedDevices[i];
+		const FBPVRComponentPosRep & LastSent = LastSentTrackedDevices[i];
+
+		// Don't rep if no changes
+		if ((SentTrackedDeviceMask & (1 << i)) && Sample.Position.Equals(LastSent.Position) && Sample.Rotation.Equals(LastSent.Rotation))
+			continue;
+
+		UGripMotionControllerComponent * MotionController = Cast<UGripMotionControllerComponent>(BundledTrackedDevices[i]);
+		UReplicatedVRCameraComponent * Camera = MotionController ? nullptr : Cast<UReplicatedVRCameraComponent>(BundledTrackedDevices[i]);
+
+		// Slow moving devices sit out bundles until their own adaptive interval is up
+		const FBPVRAdaptiveNetUpdateRate * AdaptiveRate = MotionController ? &MotionController->AdaptiveNetUpdateRate : (Camera ? &Camera->AdaptiveNetUpdateRate : nullptr);
+		if (AdaptiveRate && (SentTrackedDeviceMask & (1 << i)))
+		{
+			const float Elapsed = CurrentTime - LastSentTrackedDeviceTimes[i];
+			if (Elapsed < (1.0f / AdaptiveRate->GetNetUpdateRate(LastSent, Sample.Position, Sample.Rotation, Elapsed, TrackedDeviceNetUpdateRate)))
+				continue;
+		}
+
+		TrackedDevices.DirtyMask |= (1 << i);
+		TrackedDevices.Devices[i] = Sample;
+		LastSentTrackedDevices[i] = Sample;
+		LastSentTrackedDeviceTimes[i] = CurrentTime;
+		SentTrackedDeviceMask |= (1 << i);
+
+		if (MotionController)
+			TrackedDevices.Devices[i].PrepareDeltaSend(MotionController->PosRepDeltaState);
+		else if (Camera)
+			TrackedDevices.Devices[i].PrepareDeltaSend(Camera->PosRepDeltaState);
+	}
+
+	if (!TrackedDevices.DirtyMask)
+		return;
+
+	// Trailing clean slots don't need to be sent at all
+	while (TrackedDevices.Devices.Num() && !TrackedDevices.IsDeviceDirty(TrackedDevices.Devices.Num() - 1))
+		TrackedDevices.Devices.Pop(false);
+
+	LastTrackedDeviceSendTime = CurrentTime;
+	Server_SendTrackedDevices(TrackedDevices);
+}
+
+bool AVRBaseCharacter::HasStaleBundledTrackedDevice() const
+{
+	for (USceneComponent * Device : BundledTrackedDevices)
+	{
+		if (!Device || Device->IsPendingKill() || !Device->GetIsReplicated())
+			return true;
+	}
+
+	return false;
+}
 FVector AVRBaseCharacter::GetTeleportLocation(FVector OriginalLocation)
 {	
 	return OriginalLocation;
@@ -9,8 +9,14 @@
 #include "VRBPDatatypes.h"
 #include "VRBaseCharacter.h"
 #include "VRRootComponent.h"
+#include "VRCharacterMovementComponent.h"
 #include "VRPlayerController.h"
 #include "GameFramework/PhysicsVolume.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/UObjectIterator.h"
 
 
 UVRBaseCharacterMovementComponent::UVRBaseCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
@@ -55,6 +61,11 @@ UVRBaseCharacterMovementComponent::UVRBaseCharacterMovementComponent(const FObje
 	bIsInPushBack = false;
 
 	bRunControlRotationInMovementComponent = true;
+
+	bUseFloorCache = false;
+	FloorCacheTolerance = 2.0f;
+	FloorCacheRevalidationInterval = 0.0f;
+	SceneQueryCounter = 0;
 }
 
 void UVRBaseCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
@@ -226,7 +237,324 @@ bool UVRBaseCharacterMovementComponent::FloorSweepTest(
 	return bBlockingHit;
 }*/
 
+namespace VRServerMoveBatch
+{
+	// Matches the rounding that WritePackedVector does, so deltas are taken against what the server will actually read
+	static FVector QuantizeVector(const FVector& Value, float Scale)
+	{
+		return FVector(
+			(float)FMath::RoundToInt(Value.X * Scale) / Scale,
+			(float)FMath::RoundToInt(Value.Y * Scale) / Scale,
+			(float)FMath::RoundToInt(Value.Z * Scale) / Scale);
+	}
+
+	template<int32 ScaleFactor, int32 MaxBitsPerComponent>
+	static bool SerializeDeltaVector(FVector& Value, const FVector& BaseValue, FArchive& Ar)
+	{
+		FVector Delta = Ar.IsSaving() ? (Value - BaseValue) : FVector::ZeroVector;
+		const bool bSuccess = SerializePackedVector<ScaleFactor, MaxBitsPerComponent>(Delta, Ar);
+
+		if (Ar.IsLoading())
+			Value = BaseValue + Delta;
+
+		return bSuccess;
+	}
+
+	// Shortest signed distance between two compressed axis values, zig zag encoded so small turns either way stay small
+	static void SerializeDeltaAxis(uint16& Value, uint16 BaseValue, FArchive& Ar)
+	{
+		const int32 Delta = (int16)(Value - BaseValue);
+		uint32 ZigZag = (uint32)(Delta * 2) ^ (uint32)(Delta >> 31);
+		Ar.SerializeIntPacked(ZigZag);
+
+		if (Ar.IsLoading())
+		{
+			const int32 Decoded = (int32)(ZigZag >> 1) ^ -(int32)(ZigZag & 1);
+			Value = (uint16)(BaseValue + Decoded);
+		}
+	}
+
+	// Timestamps have to come back bit exact (the client acks by timestamp), so positive timestamps after the first
+	// are sent as the distance between the two float bit patterns, which is small for the few ms between moves.
+	static void SerializeDeltaTimeStamp(float& Value, float BaseValue, FArchive& Ar)
+	{
+		uint32 BaseBits = 0;
+		FMemory::Memcpy(&BaseBits, &BaseValue, sizeof(float));
+
+		bool bIsDelta = false;
+		uint32 DeltaBits = 0;
+
+		if (Ar.IsSaving())
+		{
+			uint32 ValueBits = 0;
+			FMemory::Memcpy(&ValueBits, &Value, sizeof(float));
+
+			// Timestamp resets (and anything not strictly after the first move) go out in full
+			bIsDelta = BaseValue > 0.0f && Value >= BaseValue && (ValueBits - BaseBits) < (1u << 24);
+			DeltaBits = ValueBits - BaseBits;
+		}
+
+		Ar.SerializeBits(&bIsDelta, 1);
+
+		if (bIsDelta)
+		{
+			Ar.SerializeIntPacked(DeltaBits);
+
+			if (Ar.IsLoading())
+			{
+				const uint32 ValueBits = BaseBits + DeltaBits;
+				FMemory::Memcpy(&Value, &ValueBits, sizeof(float));
+			}
+		}
+		else
+		{
+			Ar << Value;
+		}
+	}
+
+	static void SerializeView(FVRServerMoveBatchEntry& Move, FArchive& Ar)
+	{
+		bool bRepRollAndPitch = (Move.ClientRoll != 0 || Move.ClientPitch != 0);
+		Ar.SerializeBits(&bRepRollAndPitch, 1);
+
+		if (bRepRollAndPitch)
+		{
+			Ar << Move.ClientPitch;
+			Ar << Move.ClientRoll;
+		}
+		else if (Ar.IsLoading())
+		{
+			Move.ClientPitch = 0;
+			Move.ClientRoll = 0;
+		}
+	}
+}
+
+bool FVRServerMoveBatch::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint32 NumMoves = Moves.Num();
+	Ar.SerializeIntPacked(NumMoves);
+
+	if (NumMoves < 1 || NumMoves > MaxMoves)
+	{
+		bOutSuccess = false;
+		return false;
+	}
+
+	if (Ar.IsLoading())
+		Moves.SetNum(NumMoves);
+
+	// First move in full, quantized in place so that the deltas below are against the same values that the server reads
+	FVRServerMoveBatchEntry& First = Moves[0];
+	Ar << First.TimeStamp;
+	bOutSuccess &= SerializePackedVector<10, 24>(First.Accel, Ar);
+	bOutSuccess &= SerializePackedVector<100, 30>(First.CapsuleLoc, Ar);
+	bOutSuccess &= SerializePackedVector<100, 30>(First.LFDiff, Ar);
+	Ar << First.CapsuleYaw;
+	Ar << First.ClientYaw;
+	VRServerMoveBatch::SerializeView(First, Ar);
+	First.ConditionalReps.NetSerialize(Ar, Map, bOutSuccess);
+	Ar << First.CompressedFlags;
+
+	const FVector BaseAccel = Ar.IsSaving() ? VRServerMoveBatch::QuantizeVector(First.Accel, 10.f) : First.Accel;
+	const FVector BaseCapsuleLoc = Ar.IsSaving() ? VRServerMoveBatch::QuantizeVector(First.CapsuleLoc, 100.f) : First.CapsuleLoc;
+	const FVector BaseLFDiff = Ar.IsSaving() ? VRServerMoveBatch::QuantizeVector(First.LFDiff, 100.f) : First.LFDiff;
+
+	for (uint32 i = 1; i < NumMoves; i++)
+	{
+		FVRServerMoveBatchEntry& Move = Moves[i];
+
+		VRServerMoveBatch::SerializeDeltaTimeStamp(Move.TimeStamp, First.TimeStamp, Ar);
+		bOutSuccess &= VRServerMoveBatch::SerializeDeltaVector<10, 24>(Move.Accel, BaseAccel, Ar);
+		bOutSuccess &= VRServerMoveBatch::SerializeDeltaVector<100, 30>(Move.CapsuleLoc, BaseCapsuleLoc, Ar);
+		bOutSuccess &= VRServerMoveBatch::SerializeDeltaVector<100, 30>(Move.LFDiff, BaseLFDiff, Ar);
+		VRServerMoveBatch::SerializeDeltaAxis(Move.CapsuleYaw, First.CapsuleYaw, Ar);
+		VRServerMoveBatch::SerializeDeltaAxis(Move.ClientYaw, First.ClientYaw, Ar);
+		VRServerMoveBatch::SerializeView(Move, Ar);
+		Move.ConditionalReps.NetSerialize(Ar, Map, bOutSuccess);
+		Ar << Move.CompressedFlags;
+	}
+
+	bOutSuccess &= SerializePackedVector<100, 30>(ClientLoc, Ar);
+	Ar << ClientMovementMode;
+
+	bool bHasMovementBase = MovementBaseUtility::IsDynamicBase(ClientMovementBase);
+	Ar.SerializeBits(&bHasMovementBase, 1);
+
+	if (bHasMovementBase)
+	{
+		Ar << ClientMovementBase;
+
+		bool bValidName = ClientBaseBoneName != NAME_None;
+		Ar.SerializeBits(&bValidName, 1);
+
+		if (bValidName)
+		{
+			Ar << ClientBaseBoneName;
+		}
+	}
+	else if (Ar.IsLoading())
+	{
+		ClientMovementBase = nullptr;
+		ClientBaseBoneName = NAME_None;
+	}
+
+	return bOutSuccess;
+}
+
+void FVRFloorCache::Store(const FFindFloorResult& NewFloor, const FVector& InCapsuleLocation, float InCapsuleHalfHeight, float InLineDistance, float InSweepDistance, float InSweepRadius, float CurrentTime)
+{
+	UPrimitiveComponent * FloorComponent = NewFloor.HitResult.Component.Get();
+
+	if (!NewFloor.IsWalkableFloor() || NewFloor.HitResult.bStartPenetrating || !FloorComponent)
+	{
+		Invalidate();
+		return;
+	}
+
+	FloorResult = NewFloor;
+	BaseComponent = FloorComponent;
+	BaseTransform = FloorComponent->GetComponentTransform();
+	CapsuleLocation = InCapsuleLocation;
+	CapsuleHalfHeight = InCapsuleHalfHeight;
+	LineDistance = InLineDistance;
+	SweepDistance = InSweepDistance;
+	SweepRadius = InSweepRadius;
+	LastValidatedTime = CurrentTime;
+	bIsValid = true;
+}
+
+bool FVRFloorCache::FollowBase(bool& bOutBaseMoved)
+{
+	bOutBaseMoved = false;
+
+	if (!bIsValid)
+		return false;
+
+	const UPrimitiveComponent * Base = BaseComponent.Get();
+	if (!Base || Base->IsPendingKill() || !Base->IsQueryCollisionEnabled())
+		return false;
+
+	// There is no transform version on components, a moved or simulating base just has to compare unequal here
+	const FTransform & NewBaseTransform = Base->GetComponentTransform();
+	if (NewBaseTransform.Equals(BaseTransform, KINDA_SMALL_NUMBER))
+		return true;
+
+	// The floor plane only keeps its normal through a translation
+	if (!NewBaseTransform.GetRotation().Equals(BaseTransform.GetRotation(), KINDA_SMALL_NUMBER) || !NewBaseTransform.GetScale3D().Equals(BaseTransform.GetScale3D(), KINDA_SMALL_NUMBER))
+		return false;
+
+	const FVector BaseTranslation = NewBaseTransform.GetTranslation() - BaseTransform.GetTranslation();
+	FHitResult & Hit = FloorResult.HitResult;
+	Hit.ImpactPoint += BaseTranslation;
+	Hit.Location += BaseTranslation;
+	Hit.TraceStart += BaseTranslation;
+	Hit.TraceEnd += BaseTranslation;
+
+	// Based movement carries the capsule along, so this is where it would be standing on the moved floor
+	CapsuleLocation += BaseTranslation;
+	BaseTransform = NewBaseTransform;
+	bOutBaseMoved = true;
+	return true;
+}
+
+bool FVRFloorCache::CanReuse(const FVector& InCapsuleLocation, float InCapsuleHalfHeight, float InLineDistance, float InSweepDistance, float InSweepRadius, float Tolerance) const
+{
+	if (!bIsValid)
+		return false;
+
+	// Different query setup (crouching, walking vs falling trace distances), can't compare results
+	if (!FMath::IsNearlyEqual(CapsuleHalfHeight, InCapsuleHalfHeight) || !FMath::IsNearlyEqual(LineDistance, InLineDistance) ||
+		!FMath::IsNearlyEqual(SweepDistance, InSweepDistance) || !FMath::IsNearlyEqual(SweepRadius, InSweepRadius))
+		return false;
+
+	return CapsuleLocation.Equals(InCapsuleLocation, Tolerance);
+}
+
+void FVRFloorCache::GetFloorResult(const FVector& InCapsuleLocation, FFindFloorResult& OutFloorResult) const
+{
+	OutFloorResult = FloorResult;
+
+	// Both the sweep and the line trace go straight down, so moving the capsule by Offset changes the distance to the
+	// floor plane by (Offset | Normal) / Normal.Z. That is just the height change on flat ground, but not on ramps.
+	const FVector Offset = InCapsuleLocation - CapsuleLocation;
+	const FVector & PlaneNormal = FloorResult.HitResult.ImpactNormal;
+	const float HeightChange = PlaneNormal.Z > KINDA_SMALL_NUMBER ? (Offset | PlaneNormal) / PlaneNormal.Z : Offset.Z;
+	OutFloorResult.FloorDist += HeightChange;
+
+	if (OutFloorResult.bLineTrace)
+		OutFloorResult.LineDist += HeightChange;
+}
+
+bool UVRBaseCharacterMovementComponent::RevalidateFloorCache(const FVector& CapsuleLocation, float CapsuleHalfHeight) const
+{
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FloorCacheLineTrace), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+	const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
+
+	if (bIgnoreSimulatingComponentsInFloorCheck)
+		ResponseParam.CollisionResponse.PhysicsBody = ECollisionResponse::ECR_Ignore;
+
+	// Only needs to reach as far as the cached floor plus the drift we allow
+	const float TraceDist = CapsuleHalfHeight + FloorCache.FloorResult.FloorDist + FloorCacheTolerance + MAX_FLOOR_DIST;
+
+	FHitResult Hit(1.f);
+	if (!CountSceneQuery(GetWorld()->LineTraceSingleByChannel(Hit, CapsuleLocation, CapsuleLocation + FVector(0.f, 0.f, -TraceDist), CollisionChannel, QueryParams, ResponseParam)))
+		return false;
+
+	// Still the same floor component, and still walkable where we are standing
+	return !Hit.bStartPenetrating && Hit.Component == FloorCache.BaseComponent && IsWalkable(Hit);
+}
+
 void UVRBaseCharacterMovementComponent::ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult) const
+{
+	// A supplied downward sweep is already free, and only the walking floor is worth caching
+	if (!bUseFloorCache || DownwardSweepResult != NULL || !IsMovingOnGround())
+	{
+		if (FloorCache.bIsValid)
+			FloorCache.Invalidate();
+
+		ComputeFloorDist_Uncached(CapsuleLocation, LineDistance, SweepDistance, OutFloorResult, SweepRadius, DownwardSweepResult);
+		return;
+	}
+
+	const float CapsuleHalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	bool bBaseMoved = false;
+	if (FloorCache.bIsValid && !FloorCache.FollowBase(bBaseMoved))
+		FloorCache.Invalidate();
+
+	// Collision on the floor was changed so that we no longer stand on it, the line trace would catch this but it doesn't run inside the interval
+	if (FloorCache.bIsValid && FloorCache.BaseComponent->GetCollisionResponseToChannel(UpdatedComponent->GetCollisionObjectType()) != ECR_Block)
+		FloorCache.Invalidate();
+
+	if (FloorCache.CanReuse(CapsuleLocation, CapsuleHalfHeight, LineDistance, SweepDistance, SweepRadius, FloorCacheTolerance))
+	{
+		// The interval only covers a base that stayed put, a moved one is checked again straight away
+		bool bFloorStillValid = !bBaseMoved && (CurrentTime - FloorCache.LastValidatedTime) < FloorCacheRevalidationInterval;
+
+		if (!bFloorStillValid && RevalidateFloorCache(CapsuleLocation, CapsuleHalfHeight))
+		{
+			FloorCache.LastValidatedTime = CurrentTime;
+			bFloorStillValid = true;
+		}
+
+		if (bFloorStillValid)
+		{
+			FloorCache.GetFloorResult(CapsuleLocation, OutFloorResult);
+			return;
+		}
+	}
+
+	ComputeFloorDist_Uncached(CapsuleLocation, LineDistance, SweepDistance, OutFloorResult, SweepRadius, DownwardSweepResult);
+	FloorCache.Store(OutFloorResult, CapsuleLocation, CapsuleHalfHeight, LineDistance, SweepDistance, SweepRadius, CurrentTime);
+}
+
+void UVRBaseCharacterMovementComponent::ComputeFloorDist_Uncached(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult) const
 {
 	//UE_LOG(LogCharacterMovement, VeryVerbose, TEXT("[Role:%d] ComputeFloorDist: %s at location %s"), (int32)CharacterOwner->Role, *GetNameSafe(CharacterOwner), *CapsuleLocation.ToString());
 	OutFloorResult.Clear();
@@ -289,7 +617,7 @@ void UVRBaseCharacterMovementComponent::ComputeFloorDist(const FVector& CapsuleL
 		FCollisionShape CapsuleShape = FCollisionShape::MakeCapsule(SweepRadius, PawnHalfHeight - ShrinkHeight);
 
 		FHitResult Hit(1.f);
-		bBlockingHit = FloorSweepTest(Hit, CapsuleLocation, CapsuleLocation + FVector(0.f, 0.f, -TraceDist), CollisionChannel, CapsuleShape, QueryParams, ResponseParam);
+		bBlockingHit = CountSceneQuery(FloorSweepTest(Hit, CapsuleLocation, CapsuleLocation + FVector(0.f, 0.f, -TraceDist), CollisionChannel, CapsuleShape, QueryParams, ResponseParam));
 
 		if (bBlockingHit)
 		{
@@ -307,7 +635,7 @@ void UVRBaseCharacterMovementComponent::ComputeFloorDist(const FVector& CapsuleL
 					CapsuleShape.Capsule.HalfHeight = FMath::Max(PawnHalfHeight - ShrinkHeight, CapsuleShape.Capsule.Radius);
 					Hit.Reset(1.f, false);
 
-					bBlockingHit = FloorSweepTest(Hit, CapsuleLocation, CapsuleLocation + FVector(0.f, 0.f, -TraceDist), CollisionChannel, CapsuleShape, QueryParams, ResponseParam);
+					bBlockingHit = CountSceneQuery(FloorSweepTest(Hit, CapsuleLocation, CapsuleLocation + FVector(0.f, 0.f, -TraceDist), CollisionChannel, CapsuleShape, QueryParams, ResponseParam));
 				}
 			}
 
@@ -347,7 +675,7 @@ void UVRBaseCharacterMovementComponent::ComputeFloorDist(const FVector& CapsuleL
 		QueryParams.TraceTag = SCENE_QUERY_STAT_NAME_ONLY(FloorLineTrace);
 
 		FHitResult Hit(1.f);
-		bBlockingHit = GetWorld()->LineTraceSingleByChannel(Hit, LineTraceStart, LineTraceStart + Down, CollisionChannel, QueryParams, ResponseParam);
+		bBlockingHit = CountSceneQuery(GetWorld()->LineTraceSingleByChannel(Hit, LineTraceStart, LineTraceStart + Down, CollisionChannel, QueryParams, ResponseParam));
 
 		if (bBlockingHit)
 		{
@@ -1032,6 +1360,13 @@ void FSavedMove_VRBaseCharacter::SetInitialPosition(ACharacter* C)
 void FSavedMove_VRBaseCharacter::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
 {
 	UCharacterMovementComponent* CharMovement = InCharacter->GetCharacterMovement();
+
+	// The pending move was already recorded on its own, this combined move replaces it
+	UVRBaseCharacterMovementComponent* BaseCharMove = Cast<UVRBaseCharacterMovementComponent>(CharMovement);
+	if (BaseCharMove && BaseCharMove->MovementRecording.IsValid())
+	{
+		BaseCharMove->MovementRecording->RemoveLastMove();
+	}
 	
 	// to combine move, first revert pawn position to PendingMove start position, before playing combined move on client
 	CharMovement->UpdatedComponent->SetWorldLocationAndRotation(OldStartLocation, OldMove->StartRotation, false, nullptr, CharMovement->GetTeleportType());
@@ -1072,6 +1407,11 @@ void FSavedMove_VRBaseCharacter::PostUpdate(ACharacter* C, EPostUpdateMode PostU
 		{
 			ConditionalValues.MoveActionArray = moveComp->MoveActionArray;
 			moveComp->MoveActionArray.Clear();
+
+			if (PostUpdateMode == PostUpdate_Record && moveComp->MovementRecording.IsValid())
+			{
+				moveComp->MovementRecording->AddMove(*this);
+			}
 		}
 	}
 	/*if (ConditionalValues.MoveAction.MoveAction != EVRMoveAction::VRMOVEACTION_None)
@@ -1139,6 +1479,13 @@ void FSavedMove_VRBaseCharacter::PrepMoveFor(ACharacter* Character)
 	FSavedMove_Character::PrepMoveFor(Character);
 }
 
+void UVRBaseCharacterMovementComponent::ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	// The replay starts from the corrected location, don't let it reuse a floor found from the mispredicted one
+	FloorCache.Invalidate();
+	Super::ClientAdjustPosition_Implementation(TimeStamp, NewLoc, NewVel, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+}
+
 void UVRBaseCharacterMovementComponent::SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation)
 {
 	//SCOPE_CYCLE_COUNTER(STAT_CharacterMovementSmoothCorrection);
@@ -1391,3 +1738,515 @@ void FVRCharacterScopedMovementUpdate::RevertMove()
 		RootComponent->GenerateOffsetToWorld();
 	}
 }
+
+bool UVRBaseCharacterMovementComponent::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+{
+	// Same cutoff that MoveComponent uses to skip the sweep
+	if (bSweep && Delta.SizeSquared() > FMath::Square(4.f * KINDA_SMALL_NUMBER))
+	{
+		SceneQueryCounter++;
+	}
+
+	return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+}
+
+FVRRecordedMove::FVRRecordedMove()
+{
+	TimeStamp = 0.0f;
+	DeltaTime = 0.0f;
+	Acceleration = FVector::ZeroVector;
+	CompressedFlags = 0;
+	ControlRotation = FRotator::ZeroRotator;
+	VRCapsuleLocation = FVector::ZeroVector;
+	VRCapsuleRotation = FRotator::ZeroRotator;
+	LFDiff = FVector::ZeroVector;
+	JumpKeyHoldTime = 0.0f;
+	JumpForceTimeRemaining = 0.0f;
+	JumpMaxCount = 1;
+	JumpCurrentCount = 0;
+	bForceMaxAccel = false;
+	EndLocation = FVector::ZeroVector;
+}
+
+void FVRRecordedMove::InitFromSavedMove(const FSavedMove_VRBaseCharacter& Move)
+{
+	TimeStamp = Move.TimeStamp;
+	DeltaTime = Move.DeltaTime;
+	Acceleration = Move.Acceleration;
+	CompressedFlags = Move.GetCompressedFlags();
+	ControlRotation = Move.SavedControlRotation;
+	VRCapsuleLocation = Move.VRCapsuleLocation;
+	VRCapsuleRotation = Move.VRCapsuleRotation;
+	LFDiff = Move.LFDiff;
+	ConditionalValues = Move.ConditionalValues;
+	JumpKeyHoldTime = Move.JumpKeyHoldTime;
+	JumpForceTimeRemaining = Move.JumpForceTimeRemaining;
+	JumpMaxCount = Move.JumpMaxCount;
+	JumpCurrentCount = Move.JumpCurrentCount;
+	bForceMaxAccel = Move.bForceMaxAccel;
+	EndLocation = Move.SavedLocation;
+}
+
+void FVRRecordedMove::CopyToSavedMove(FSavedMove_VRBaseCharacter& Move) const
+{
+	Move.TimeStamp = TimeStamp;
+	Move.DeltaTime = DeltaTime;
+	Move.Acceleration = Acceleration;
+	Move.SavedControlRotation = ControlRotation;
+	Move.VRCapsuleLocation = VRCapsuleLocation;
+	Move.VRCapsuleRotation = VRCapsuleRotation;
+	Move.LFDiff = LFDiff;
+	Move.ConditionalValues = ConditionalValues;
+	Move.JumpKeyHoldTime = JumpKeyHoldTime;
+	Move.JumpForceTimeRemaining = JumpForceTimeRemaining;
+	Move.JumpMaxCount = JumpMaxCount;
+	Move.JumpCurrentCount = JumpCurrentCount;
+	Move.bForceMaxAccel = bForceMaxAccel;
+
+	// Packed in the same bits that UpdateFromCompressedFlags reads it back out of
+	Move.VRReplicatedMovementMode = (EVRConjoinedMovementModes)((CompressedFlags >> 2) & 15);
+}
+
+namespace VRMovementReplay
+{
+	static const uint32 FileMagic = 0x56524D56; // VRMV
+	static const int32 FileVersion = 1;
+
+	// Serialized sizes, used to bound the counts read from a file against what is actually left in it
+	static const int64 MinRecordedMoveSize = 129;
+	static const int64 RecordedMoveActionSize = 26;
+	static const int32 MaxMoveActionsPerMove = 255;
+
+	// Fails the archive if Count entries of EntrySize can't fit in what is left of it
+	static bool ValidateLoadCount(FArchive& Ar, int32 Count, int64 EntrySize, int32 MaxCount)
+	{
+		if (Count < 0 || Count > MaxCount || (int64)Count * EntrySize > Ar.TotalSize() - Ar.Tell())
+		{
+			Ar.SetError();
+			return false;
+		}
+
+		return true;
+	}
+}
+
+FArchive& operator<<(FArchive& Ar, FVRRecordedMove& Move)
+{
+	Ar << Move.TimeStamp;
+	Ar << Move.DeltaTime;
+	Ar << Move.Acceleration;
+	Ar << Move.CompressedFlags;
+	Ar << Move.ControlRotation;
+	Ar << Move.VRCapsuleLocation;
+	Ar << Move.VRCapsuleRotation;
+	Ar << Move.LFDiff;
+	Ar << Move.ConditionalValues.CustomVRInputVector;
+	Ar << Move.ConditionalValues.RequestedVelocity;
+
+	// Full precision rather than the NetSerialize packing, the replay should see exactly what the client performed
+	int32 NumMoveActions = Move.ConditionalValues.MoveActionArray.MoveActions.Num();
+	Ar << NumMoveActions;
+
+	if (Ar.IsLoading())
+	{
+		if (!VRMovementReplay::ValidateLoadCount(Ar, NumMoveActions, VRMovementReplay::RecordedMoveActionSize, VRMovementReplay::MaxMoveActionsPerMove))
+		{
+			return Ar;
+		}
+
+		Move.ConditionalValues.MoveActionArray.MoveActions.SetNum(NumMoveActions);
+	}
+
+	for (FVRMoveActionContainer& MoveAction : Move.ConditionalValues.MoveActionArray.MoveActions)
+	{
+		Ar << (uint8&)MoveAction.MoveAction;
+		Ar << (uint8&)MoveAction.MoveActionDataReq;
+		Ar << MoveAction.MoveActionLoc;
+		Ar << MoveAction.MoveActionRot;
+	}
+
+	Ar << Move.JumpKeyHoldTime;
+	Ar << Move.JumpForceTimeRemaining;
+	Ar << Move.JumpMaxCount;
+	Ar << Move.JumpCurrentCount;
+	Ar << Move.bForceMaxAccel;
+	Ar << Move.EndLocation;
+
+	return Ar;
+}
+
+namespace VRMovementReplay
+{
+	// Bare names go in Saved/VRMovementRecordings, .vrmove is added if there is no extension
+	static FString GetRecordingPath(const FString& Name)
+	{
+		FString Filename = Name.IsEmpty() ? FString::Printf(TEXT("VRMovement_%s"), *FDateTime::Now().ToString()) : Name;
+
+		if (FPaths::GetExtension(Filename).IsEmpty())
+		{
+			Filename += TEXT(".vrmove");
+		}
+
+		if (FPaths::IsRelative(Filename))
+		{
+			Filename = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VRMovementRecordings"), Filename);
+		}
+
+		return Filename;
+	}
+
+	// Movement components in game worlds, only locally controlled characters when recording
+	static void GetMovementComponents(bool bLocallyControlledOnly, TArray<UVRBaseCharacterMovementComponent*>& OutComponents)
+	{
+		for (TObjectIterator<UVRBaseCharacterMovementComponent> It; It; ++It)
+		{
+			UVRBaseCharacterMovementComponent* MoveComp = *It;
+			if (!MoveComp || MoveComp->IsTemplate() || MoveComp->IsPendingKill() || !MoveComp->GetCharacterOwner())
+			{
+				continue;
+			}
+
+			UWorld* World = MoveComp->GetWorld();
+			if (!World || !World->IsGameWorld())
+			{
+				continue;
+			}
+
+			if (bLocallyControlledOnly && !MoveComp->IsLocallyControlled())
+			{
+				continue;
+			}
+
+			OutComponents.Add(MoveComp);
+		}
+	}
+
+	void StartRecording()
+	{
+		TArray<UVRBaseCharacterMovementComponent*> MoveComps;
+		GetMovementComponents(true, MoveComps);
+
+		for (UVRBaseCharacterMovementComponent* MoveComp : MoveComps)
+		{
+			MoveComp->StartMovementRecording();
+			UE_LOG(LogVRCharacterMovement, Display, TEXT("Recording movement for %s"), *GetNameSafe(MoveComp->GetCharacterOwner()));
+		}
+
+		if (MoveComps.Num() == 0)
+		{
+			UE_LOG(LogVRCharacterMovement, Warning, TEXT("vre.StartMovementRecording: no locally controlled VR characters to record"));
+		}
+	}
+
+	void StopRecording(const TArray<FString>& Args)
+	{
+		TArray<UVRBaseCharacterMovementComponent*> MoveComps;
+		GetMovementComponents(true, MoveComps);
+
+		const FString BaseName = Args.Num() > 0 ? Args[0] : FString();
+		int32 NumSaved = 0;
+
+		for (UVRBaseCharacterMovementComponent* MoveComp : MoveComps)
+		{
+			TSharedPtr<FVRMovementRecording> Recording = MoveComp->StopMovementRecording();
+			if (!Recording.IsValid() || Recording->Moves.Num() == 0)
+			{
+				continue;
+			}
+
+			// More than one local player (split screen) gets a file each
+			FString Name = BaseName;
+			if (NumSaved > 0)
+			{
+				Name = FPaths::GetBaseFilename(GetRecordingPath(BaseName)) + FString::Printf(TEXT("_%d"), NumSaved);
+			}
+
+			const FString Filename = GetRecordingPath(Name);
+			if (Recording->SaveToFile(Filename))
+			{
+				UE_LOG(LogVRCharacterMovement, Display, TEXT("Saved %d moves from %s to %s"), Recording->Moves.Num(), *GetNameSafe(MoveComp->GetCharacterOwner()), *Filename);
+				NumSaved++;
+			}
+			else
+			{
+				UE_LOG(LogVRCharacterMovement, Warning, TEXT("vre.StopMovementRecording: failed to write %s"), *Filename);
+			}
+		}
+
+		if (NumSaved == 0)
+		{
+			UE_LOG(LogVRCharacterMovement, Warning, TEXT("vre.StopMovementRecording: nothing was recorded"));
+		}
+	}
+
+	void Replay(const TArray<FString>& Args)
+	{
+		if (Args.Num() < 1)
+		{
+			UE_LOG(LogVRCharacterMovement, Warning, TEXT("Usage: vre.ReplayMovementRecording <file> [iterations]"));
+			return;
+		}
+
+		const FString Filename = GetRecordingPath(Args[0]);
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1;
+
+		FVRMovementRecording Recording;
+		if (!Recording.LoadFromFile(Filename))
+		{
+			UE_LOG(LogVRCharacterMovement, Warning, TEXT("vre.ReplayMovementRecording: could not load %s"), *Filename);
+			return;
+		}
+
+		TArray<UVRBaseCharacterMovementComponent*> MoveComps;
+		GetMovementComponents(false, MoveComps);
+
+		for (UVRBaseCharacterMovementComponent* MoveComp : MoveComps)
+		{
+			FVRMovementReplayResult Result;
+			if (!MoveComp->ReplayMovementRecording(Recording, Iterations, Result))
+			{
+				continue;
+			}
+
+			UE_LOG(LogVRCharacterMovement, Display, TEXT("MovementReplay %s (recorded on %s) against %s (%s): %d moves x %d, %.0f ns/move, %.2f scene queries/move, final position diff %.3f cm, max %.3f cm"),
+				*FPaths::GetCleanFilename(Filename), *Recording.MovementComponentClass,
+				*GetNameSafe(MoveComp->GetCharacterOwner()), *MoveComp->GetClass()->GetName(),
+				Result.NumMoves, Result.Iterations, Result.NanosecondsPerMove, Result.SceneQueriesPerMove,
+				Result.FinalPositionError, Result.MaxPositionError);
+		}
+
+		if (MoveComps.Num() == 0)
+		{
+			UE_LOG(LogVRCharacterMovement, Warning, TEXT("vre.ReplayMovementRecording: no VR characters in the world to replay against"));
+		}
+	}
+
+	FAutoConsoleCommand CmdStartMovementRecording(
+		TEXT("vre.StartMovementRecording"),
+		TEXT("Starts recording the moves (accel, capsule location, LFDiff, conditional values and move actions) of locally controlled VR characters.\n")
+		TEXT("Saved moves only exist on a networked client, so record from a client session."),
+		FConsoleCommandDelegate::CreateStatic(&StartRecording));
+
+	FAutoConsoleCommand CmdStopMovementRecording(
+		TEXT("vre.StopMovementRecording"),
+		TEXT("Stops recording movement and saves it to the given file (optional, bare names go in Saved/VRMovementRecordings)."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&StopRecording));
+
+	FAutoConsoleCommand CmdReplayMovementRecording(
+		TEXT("vre.ReplayMovementRecording"),
+		TEXT("Replays a movement recording against every VR character in the world (optional iteration count) and logs ns/move, scene queries/move and the final position diff.\n")
+		TEXT("Meant for a standalone -nullrhi run of a benchmark map, ie: -ExecCmds=\"vre.ReplayMovementRecording MyRecording 20, quit\""),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Replay));
+}
+
+FVRMovementRecording::FVRMovementRecording()
+{
+	StartLocation = FVector::ZeroVector;
+	StartRotation = FRotator::ZeroRotator;
+	StartVelocity = FVector::ZeroVector;
+	StartMovementMode = MOVE_Walking;
+	StartCustomMovementMode = 0;
+}
+
+void FVRMovementRecording::AddMove(const FSavedMove_VRBaseCharacter& Move)
+{
+	if (Moves.Num() == 0)
+	{
+		StartLocation = Move.StartLocation;
+		StartRotation = Move.StartRotation;
+		StartVelocity = Move.StartVelocity;
+	}
+
+	const int32 Index = Moves.AddDefaulted();
+	Moves[Index].InitFromSavedMove(Move);
+}
+
+FArchive& operator<<(FArchive& Ar, FVRMovementRecording& Recording)
+{
+	Ar << Recording.MovementComponentClass;
+	Ar << Recording.StartLocation;
+	Ar << Recording.StartRotation;
+	Ar << Recording.StartVelocity;
+	Ar << Recording.StartMovementMode;
+	Ar << Recording.StartCustomMovementMode;
+
+	// Not using the TArray serializer, it would allocate whatever count the file claims
+	int32 NumMoves = Recording.Moves.Num();
+	Ar << NumMoves;
+
+	if (Ar.IsLoading())
+	{
+		Recording.Moves.Reset();
+
+		if (Ar.IsError() || !VRMovementReplay::ValidateLoadCount(Ar, NumMoves, VRMovementReplay::MinRecordedMoveSize, MAX_int32))
+		{
+			return Ar;
+		}
+
+		Recording.Moves.SetNum(NumMoves);
+	}
+
+	for (FVRRecordedMove& Move : Recording.Moves)
+	{
+		Ar << Move;
+
+		if (Ar.IsError())
+		{
+			break;
+		}
+	}
+
+	return Ar;
+}
+
+bool FVRMovementRecording::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Buffer;
+	FMemoryWriter Writer(Buffer);
+
+	uint32 Magic = VRMovementReplay::FileMagic;
+	int32 Version = VRMovementReplay::FileVersion;
+	Writer << Magic;
+	Writer << Version;
+	Writer << const_cast<FVRMovementRecording&>(*this);
+
+	return FFileHelper::SaveArrayToFile(Buffer, *Filename);
+}
+
+bool FVRMovementRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Buffer;
+	if (!FFileHelper::LoadFileToArray(Buffer, *Filename))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Buffer);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+
+	if (Magic != VRMovementReplay::FileMagic || Version != VRMovementReplay::FileVersion)
+	{
+		return false;
+	}
+
+	Reader << *this;
+
+	if (Reader.IsError())
+	{
+		Moves.Empty();
+		return false;
+	}
+
+	return true;
+}
+
+void UVRBaseCharacterMovementComponent::StartMovementRecording()
+{
+	MovementRecording = MakeShareable(new FVRMovementRecording());
+	MovementRecording->MovementComponentClass = GetClass()->GetName();
+	MovementRecording->StartMovementMode = MovementMode;
+	MovementRecording->StartCustomMovementMode = CustomMovementMode;
+}
+
+TSharedPtr<FVRMovementRecording> UVRBaseCharacterMovementComponent::StopMovementRecording()
+{
+	TSharedPtr<FVRMovementRecording> Recording = MovementRecording;
+	MovementRecording.Reset();
+	return Recording;
+}
+
+bool UVRBaseCharacterMovementComponent::ReplayMovementRecording(const FVRMovementRecording& Recording, int32 Iterations, FVRMovementReplayResult& OutResult)
+{
+	OutResult = FVRMovementReplayResult();
+
+	if (!HasValidData() || Recording.Moves.Num() == 0)
+	{
+		return false;
+	}
+
+	// Allocated through the prediction data so that it is the saved move type for this component, and its PrepMoveFor is the one that runs
+	FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+	FSavedMovePtr ReplayMovePtr = ClientData ? ClientData->AllocateNewMove() : FSavedMovePtr();
+	FSavedMove_VRBaseCharacter* ReplayMove = (FSavedMove_VRBaseCharacter*)ReplayMovePtr.Get();
+	if (!ReplayMove)
+	{
+		return false;
+	}
+
+	// Replays the same way the client does, without the controller requirement or anim ticking
+	const bool bOldRunPhysicsWithNoController = bRunPhysicsWithNoController;
+	const bool bOldClientUpdating = CharacterOwner->bClientUpdating;
+	bRunPhysicsWithNoController = true;
+	CharacterOwner->bClientUpdating = true;
+
+	AController* Controller = CharacterOwner->GetController();
+	Iterations = FMath::Max(Iterations, 1);
+
+	uint64 TotalCycles = 0;
+	uint32 TotalQueries = 0;
+
+	for (int32 Iteration = 0; Iteration < Iterations && HasValidData(); Iteration++)
+	{
+		// Every pass starts from the recorded start state
+		UpdatedComponent->SetWorldLocationAndRotation(Recording.StartLocation, Recording.StartRotation, false, nullptr, ETeleportType::TeleportPhysics);
+		Velocity = Recording.StartVelocity;
+		SetBase(nullptr);
+		SetMovementMode((EMovementMode)Recording.StartMovementMode, Recording.StartCustomMovementMode);
+		FloorCache.Invalidate();
+		UpdateFloorFromAdjustment();
+		bJustTeleported = true;
+
+		for (const FVRRecordedMove& RecordedMove : Recording.Moves)
+		{
+			ReplayMove->Clear();
+			RecordedMove.CopyToSavedMove(*ReplayMove);
+
+			if (Controller)
+			{
+				Controller->SetControlRotation(RecordedMove.ControlRotation);
+			}
+
+			const uint32 StartQueries = SceneQueryCounter;
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			{
+				FVRCharacterScopedMovementUpdate ScopedMovementUpdate(UpdatedComponent, bEnableScopedMovementUpdates ? EScopedUpdate::DeferredUpdates : EScopedUpdate::ImmediateUpdates);
+				ReplayMove->PrepMoveFor(CharacterOwner);
+				MoveAutonomous(RecordedMove.TimeStamp, RecordedMove.DeltaTime, RecordedMove.CompressedFlags, RecordedMove.Acceleration);
+			}
+			TotalCycles += FPlatformTime::Cycles64() - StartCycles;
+			TotalQueries += SceneQueryCounter - StartQueries;
+
+			SetHasRequestedVelocity(false);
+
+			if (!HasValidData())
+			{
+				break;
+			}
+
+			OutResult.MaxPositionError = FMath::Max(OutResult.MaxPositionError, (float)FVector::Dist(UpdatedComponent->GetComponentLocation(), RecordedMove.EndLocation));
+		}
+
+		if (HasValidData())
+		{
+			OutResult.FinalPositionError = FVector::Dist(UpdatedComponent->GetComponentLocation(), Recording.Moves.Last().EndLocation);
+		}
+	}
+
+	if (CharacterOwner)
+	{
+		CharacterOwner->bClientUpdating = bOldClientUpdating;
+	}
+	bRunPhysicsWithNoController = bOldRunPhysicsWithNoController;
+
+	const double TotalMoves = (double)Recording.Moves.Num() * Iterations;
+	OutResult.NumMoves = Recording.Moves.Num();
+	OutResult.Iterations = Iterations;
+	OutResult.NanosecondsPerMove = (FPlatformTime::GetSecondsPerCycle64() * TotalCycles * 1000000000.0) / TotalMoves;
+	OutResult.SceneQueriesPerMove = (float)(TotalQueries / TotalMoves);
+
+	return true;
+}
@@ -220,6 +220,16 @@ bool AVRCharacter::ServerMoveVRDualHybridRootMotion_Validate(float TimeStamp0, F
 	return ((UVRCharacterMovementComponent*)GetCharacterMovement())->ServerMoveVRDualHybridRootMotion_Validate(TimeStamp0, InAccel0, PendingFlags, View0, OldCapsuleLoc, OldConditionalReps, OldLFDiff, OldCapsuleYaw, TimeStamp, InAccel, ClientLoc, CapsuleLoc, ConditionalReps, LFDiff, CapsuleYaw, NewFlags, MoveReps, ClientMovementMode);
 }
 
+bool AVRCharacter::ServerMoveVRBatch_Validate(const FVRServerMoveBatch& MoveBatch)
+{
+	return ((UVRCharacterMovementComponent*)GetCharacterMovement())->ServerMoveVRBatch_Validate(MoveBatch);
+}
+
+void AVRCharacter::ServerMoveVRBatch_Implementation(const FVRServerMoveBatch& MoveBatch)
+{
+	((UVRCharacterMovementComponent*)GetCharacterMovement())->ServerMoveVRBatch_Implementation(MoveBatch);
+}
+
 void AVRCharacter::ServerMoveVRDualHybridRootMotion_Implementation(
 	float TimeStamp0,
 	FVector_NetQuantize10 InAccel0,
@@ -26,6 +26,8 @@
 
 #include "Engine/DemoNetDriver.h"
 #include "Engine/NetworkObjectList.h"
+#include "UObject/UObjectIterator.h"
+#include "ProfilingDebugging/CsvProfiler.h"
 
 //#include "PerfCountersHelpers.h"
 
@@ -73,6 +75,141 @@ namespace CharacterMovementComponentStatics
 		TEXT("Rotation is replicated at 2 decimal precision, so values less than 0.01 won't matter."),
 		ECVF_Default);
 
+	static int32 MovementCorrectionTelemetry = 0;
+	FAutoConsoleVariableRef CVarMovementCorrectionTelemetry(
+		TEXT("vre.MovementCorrectionTelemetry"),
+		MovementCorrectionTelemetry,
+		TEXT("Whether to count client corrections for VR characters (reason, error size, replayed moves) and send them to the csv profiler under VRMovement.\n")
+		TEXT("A summary is logged for each character when it ends play, or on demand with vre.DumpMovementCorrectionTelemetry."),
+		ECVF_Default);
+
+}
+
+// Correction telemetry goes out to the csv profiler under VRMovement, only while vre.MovementCorrectionTelemetry is on
+CSV_DEFINE_CATEGORY(VRMovement, true);
+
+// Returns the telemetry to record into if it is turned on, starting its session timer on first use
+static FVRMovementCorrectionTelemetry* GetActiveCorrectionTelemetry(FVRMovementCorrectionTelemetry& Telemetry)
+{
+	if (CharacterMovementComponentStatics::MovementCorrectionTelemetry == 0)
+	{
+		return nullptr;
+	}
+
+	if (Telemetry.StartTime <= 0.0)
+	{
+		Telemetry.StartTime = FPlatformTime::Seconds();
+	}
+
+	return &Telemetry;
+}
+
+static void CsvRecordCorrection(EVRMovementCorrectionReason Reason, float Error)
+{
+	CSV_CUSTOM_STAT(VRMovement, Corrections, 1, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(VRMovement, CorrectionErrorMax, Error, ECsvCustomStatOp::Max);
+
+	switch (Reason)
+	{
+	case EVRMovementCorrectionReason::LocationError: CSV_CUSTOM_STAT(VRMovement, CorrectionsLocationError, 1, ECsvCustomStatOp::Accumulate); break;
+	case EVRMovementCorrectionReason::ForcedPercent: CSV_CUSTOM_STAT(VRMovement, CorrectionsForcedPercent, 1, ECsvCustomStatOp::Accumulate); break;
+	case EVRMovementCorrectionReason::MovementMode: CSV_CUSTOM_STAT(VRMovement, CorrectionsMovementMode, 1, ECsvCustomStatOp::Accumulate); break;
+	case EVRMovementCorrectionReason::YawRollback: CSV_CUSTOM_STAT(VRMovement, CorrectionsYawRollback, 1, ECsvCustomStatOp::Accumulate); break;
+	case EVRMovementCorrectionReason::ForcedUpdate: CSV_CUSTOM_STAT(VRMovement, CorrectionsForcedUpdate, 1, ECsvCustomStatOp::Accumulate); break;
+	default: break;
+	}
+}
+
+FString FVRMovementCorrectionTelemetry::ToString(double SessionTime) const
+{
+	const uint32 TotalCorrections = GetTotalCorrections();
+	const double SafeSessionTime = FMath::Max(SessionTime, 0.001);
+
+	FString Histogram;
+	float UpperBound = 1.0f;
+	for (int32 i = 0; i < NumErrorBuckets; i++, UpperBound *= 2.0f)
+	{
+		Histogram += (i < NumErrorBuckets - 1) ?
+			FString::Printf(TEXT(" <=%.0f:%u"), UpperBound, ErrorHistogram[i]) :
+			FString::Printf(TEXT(" >%.0f:%u"), UpperBound * 0.5f, ErrorHistogram[i]);
+	}
+
+	return FString::Printf(TEXT("%.1fs, %u moves checked, %u corrections (%.2f/s, %.2f%% of moves), sent %u throttled %u\n")
+		TEXT("  Reasons: location %u, forced percent %u, movement mode %u, yaw rollback %u, forced update %u, other %u\n")
+		TEXT("  Error (cm): avg %.2f max %.2f, histogram%s\n")
+		TEXT("  Client: %u adjustments received, %u moves replayed (avg %.1f, max %u)"),
+		SessionTime, ServerMovesChecked, TotalCorrections, TotalCorrections / SafeSessionTime, ServerMovesChecked > 0 ? 100.0 * TotalCorrections / ServerMovesChecked : 0.0, AdjustmentsSent, AdjustmentsThrottled,
+		Corrections[(uint8)EVRMovementCorrectionReason::LocationError],
+		Corrections[(uint8)EVRMovementCorrectionReason::ForcedPercent],
+		Corrections[(uint8)EVRMovementCorrectionReason::MovementMode],
+		Corrections[(uint8)EVRMovementCorrectionReason::YawRollback],
+		Corrections[(uint8)EVRMovementCorrectionReason::ForcedUpdate],
+		Corrections[(uint8)EVRMovementCorrectionReason::None],
+		TotalCorrections > 0 ? TotalError / TotalCorrections : 0.0, MaxError, *Histogram,
+		AdjustmentsReceived, ReplayedMoves, AdjustmentsReceived > 0 ? (float)ReplayedMoves / AdjustmentsReceived : 0.f, MaxReplayedMoves);
+}
+
+namespace
+{
+	void DumpMovementCorrectionTelemetry(const TArray<FString>& Args)
+	{
+		const bool bReset = Args.Num() > 0 && Args[0].Equals(TEXT("reset"), ESearchCase::IgnoreCase);
+
+		for (TObjectIterator<UVRCharacterMovementComponent> It; It; ++It)
+		{
+			UVRCharacterMovementComponent* MoveComp = *It;
+			if (!MoveComp || MoveComp->IsTemplate() || MoveComp->IsPendingKill())
+			{
+				continue;
+			}
+
+			MoveComp->DumpCorrectionTelemetry();
+
+			if (bReset)
+			{
+				MoveComp->CorrectionTelemetry.Reset(0.0);
+			}
+		}
+	}
+
+	FAutoConsoleCommand CmdDumpMovementCorrectionTelemetry(
+		TEXT("vre.DumpMovementCorrectionTelemetry"),
+		TEXT("Logs the client correction telemetry (see vre.MovementCorrectionTelemetry) for every VR character, pass reset to clear the counters afterwards."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&DumpMovementCorrectionTelemetry));
+}
+
+void UVRCharacterMovementComponent::DumpCorrectionTelemetry() const
+{
+	if (CorrectionTelemetry.StartTime <= 0.0)
+	{
+		return;
+	}
+
+	const AActor* MyOwner = GetOwner();
+	const TCHAR* RoleName = TEXT("None");
+	if (MyOwner)
+	{
+		switch (MyOwner->Role)
+		{
+		case ROLE_Authority: RoleName = TEXT("Authority"); break;
+		case ROLE_AutonomousProxy: RoleName = TEXT("AutonomousProxy"); break;
+		case ROLE_SimulatedProxy: RoleName = TEXT("SimulatedProxy"); break;
+		default: break;
+		}
+	}
+
+	UE_LOG(LogVRCharacterMovement, Log, TEXT("Correction telemetry for %s (%s): %s"), *GetNameSafe(MyOwner), RoleName, *CorrectionTelemetry.ToString(FPlatformTime::Seconds() - CorrectionTelemetry.StartTime));
+}
+
+void UVRCharacterMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Per session summary
+	if (CharacterMovementComponentStatics::MovementCorrectionTelemetry != 0)
+	{
+		DumpCorrectionTelemetry();
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UVRCharacterMovementComponent::Crouch(bool bClientSimulation)
@@ -142,8 +279,8 @@ void UVRCharacterMovementComponent::Crouch(bool bClientSimulation)
 			else
 				capLocation = UpdatedComponent->GetComponentLocation();
 
-			const bool bEncroached = GetWorld()->OverlapBlockingTestByChannel(capLocation - FVector(0.f, 0.f, ScaledHalfHeightAdjust), FQuat::Identity,
-				UpdatedComponent->GetCollisionObjectType(), GetPawnCapsuleCollisionShape(SHRINK_None), CapsuleParams, ResponseParam);
+			const bool bEncroached = CountSceneQuery(GetWorld()->OverlapBlockingTestByChannel(capLocation - FVector(0.f, 0.f, ScaledHalfHeightAdjust), FQuat::Identity,
+				UpdatedComponent->GetCollisionObjectType(), GetPawnCapsuleCollisionShape(SHRINK_None), CapsuleParams, ResponseParam));
 
 			// If encroached, cancel
 			if (bEncroached)
@@ -243,7 +380,7 @@ void UVRCharacterMovementComponent::UnCrouch(bool bClientSimulation)
 		if (!bCrouchMaintainsBaseLocation)
 		{
 			// Expand in place
-			bEncroached = MyWorld->OverlapBlockingTestByChannel(PawnLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+			bEncroached = CountSceneQuery(MyWorld->OverlapBlockingTestByChannel(PawnLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam));
 
 			if (bEncroached)
 			{
@@ -259,7 +396,7 @@ void UVRCharacterMovementComponent::UnCrouch(bool bClientSimulation)
 
 					FHitResult Hit(1.f);
 					const FCollisionShape ShortCapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_HeightCustom, ShrinkHalfHeight);
-					const bool bBlockingHit = MyWorld->SweepSingleByChannel(Hit, PawnLocation, PawnLocation + Down, FQuat::Identity, CollisionChannel, ShortCapsuleShape, CapsuleParams);
+					const bool bBlockingHit = CountSceneQuery(MyWorld->SweepSingleByChannel(Hit, PawnLocation, PawnLocation + Down, FQuat::Identity, CollisionChannel, ShortCapsuleShape, CapsuleParams));
 					if (Hit.bStartPenetrating)
 					{
 						bEncroached = true;
@@ -269,7 +406,7 @@ void UVRCharacterMovementComponent::UnCrouch(bool bClientSimulation)
 						// Compute where the base of the sweep ended up, and see if we can stand there
 						const float DistanceToBase = (Hit.Time * TraceDist) + ShortCapsuleShape.Capsule.HalfHeight;
 						const FVector NewLoc = FVector(PawnLocation.X, PawnLocation.Y, PawnLocation.Z - DistanceToBase + StandingCapsuleShape.Capsule.HalfHeight + SweepInflation + MIN_FLOOR_DIST / 2.f);
-						bEncroached = MyWorld->OverlapBlockingTestByChannel(NewLoc, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+						bEncroached = CountSceneQuery(MyWorld->OverlapBlockingTestByChannel(NewLoc, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam));
 						if (!bEncroached)
 						{
 							// Intentionally not using MoveUpdatedComponent, where a horizontal plane constraint would prevent the base of the capsule from staying at the same spot.
@@ -283,7 +420,7 @@ void UVRCharacterMovementComponent::UnCrouch(bool bClientSimulation)
 		{
 			// Expand while keeping base location the same.
 			FVector StandingLocation = PawnLocation + FVector(0.f, 0.f, StandingCapsuleShape.GetCapsuleHalfHeight() - CurrentCrouchedHalfHeight);
-			bEncroached = MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+			bEncroached = CountSceneQuery(MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam));
 
 			if (bEncroached)
 			{
@@ -294,7 +431,7 @@ void UVRCharacterMovementComponent::UnCrouch(bool bClientSimulation)
 					if (CurrentFloor.bBlockingHit && CurrentFloor.FloorDist > MinFloorDist)
 					{
 						StandingLocation.Z -= CurrentFloor.FloorDist - MinFloorDist;
-						bEncroached = MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+						bEncroached = CountSceneQuery(MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam));
 					}
 				}
 			}
@@ -452,6 +589,33 @@ bool UVRCharacterMovementComponent::ServerMoveVRDualHybridRootMotion_Validate(fl
 	return true;
 }
 
+bool UVRCharacterMovementComponent::ServerMoveVRBatch_Validate(const FVRServerMoveBatch& MoveBatch)
+{
+	return MoveBatch.Moves.Num() > 0 && MoveBatch.Moves.Num() <= FVRServerMoveBatch::MaxMoves;
+}
+
+void UVRCharacterMovementComponent::ServerMoveVRBatch_Implementation(const FVRServerMoveBatch& MoveBatch)
+{
+	if (!HasValidData() || !IsComponentTickEnabled())
+	{
+		return;
+	}
+
+	// Scope these, they nest with Outer references so it should work fine, this keeps the update rotation and move autonomous from double updating the char
+	FVRCharacterScopedMovementUpdate ScopedMovementUpdate(UpdatedComponent, bEnableScopedMovementUpdates ? EScopedUpdate::DeferredUpdates : EScopedUpdate::ImmediateUpdates);
+
+	FVRConditionalMoveRep2 MoveReps;
+	for (int32 i = 0; i < MoveBatch.Moves.Num(); ++i)
+	{
+		const FVRServerMoveBatchEntry& Move = MoveBatch.Moves[i];
+		MoveBatch.GetMoveReps(Move, MoveReps);
+
+		// Same as the dual moves, everything but the last move passes the "no error check" location
+		const bool bLastMove = i == MoveBatch.Moves.Num() - 1;
+		ServerMoveVR_Implementation(Move.TimeStamp, Move.Accel, bLastMove ? MoveBatch.ClientLoc : FVector(1.f, 2.f, 3.f), Move.CapsuleLoc, Move.ConditionalReps, Move.LFDiff, Move.CapsuleYaw, Move.CompressedFlags, MoveReps, MoveBatch.ClientMovementMode);
+	}
+}
+
 void UVRCharacterMovementComponent::ServerMoveVRDualHybridRootMotion_Implementation(
 	float TimeStamp0,
 	FVector_NetQuantize10 InAccel0,
@@ -886,6 +1050,65 @@ void UVRCharacterMovementComponent::CallServerMove
 }
 
 
+void UVRCharacterMovementComponent::CallServerMoveBatch(const class FSavedMove_Character* OldCMove)
+{
+	if (PendingBatchMoves.Num() < 1)
+		return;
+
+	// send old move if it exists and isn't already part of this batch
+	if (OldCMove && OldCMove->TimeStamp < PendingBatchMoves[0]->TimeStamp)
+	{
+		ServerMoveOld(OldCMove->TimeStamp, OldCMove->Acceleration, OldCMove->GetCompressedFlags());
+	}
+
+	const bool bRepPitch = CharacterOwner && CharacterOwner->bUseControllerRotationPitch;
+	const bool bRepRoll = CharacterOwner && CharacterOwner->bUseControllerRotationRoll;
+
+	FVRServerMoveBatch MoveBatch;
+	MoveBatch.Moves.Reserve(PendingBatchMoves.Num());
+
+	for (const FSavedMovePtr& SavedMove : PendingBatchMoves)
+	{
+		// Same as CallServerMove, these are always our own saved moves
+		const FSavedMove_VRCharacter * BatchMove = (const FSavedMove_VRCharacter *)SavedMove.Get();
+
+		FVRServerMoveBatchEntry& Move = MoveBatch.Moves[MoveBatch.Moves.AddDefaulted()];
+		Move.TimeStamp = BatchMove->TimeStamp;
+		Move.Accel = BatchMove->Acceleration;
+		Move.CapsuleLoc = BatchMove->VRCapsuleLocation;
+		Move.ConditionalReps = BatchMove->ConditionalValues;
+		Move.LFDiff = BatchMove->LFDiff;
+		Move.CapsuleYaw = FRotator::CompressAxisToShort(BatchMove->VRCapsuleRotation.Yaw);
+		Move.CompressedFlags = BatchMove->GetCompressedFlags();
+		Move.ClientYaw = FRotator::CompressAxisToShort(BatchMove->SavedControlRotation.Yaw);
+		Move.ClientPitch = bRepPitch ? FRotator::CompressAxisToShort(BatchMove->SavedControlRotation.Pitch) : 0;
+		Move.ClientRoll = bRepRoll ? FRotator::CompressAxisToByte(BatchMove->SavedControlRotation.Roll) : 0;
+	}
+
+	// Determine if we send absolute or relative location for the last move, which is the only one checked for error
+	const FSavedMove_VRCharacter * LastMove = (const FSavedMove_VRCharacter *)PendingBatchMoves.Last().Get();
+	MoveBatch.ClientMovementBase = LastMove->EndBase.Get();
+	MoveBatch.ClientBaseBoneName = LastMove->EndBoneName;
+	MoveBatch.ClientLoc = MovementBaseUtility::UseRelativeLocation(MoveBatch.ClientMovementBase) ? LastMove->SavedRelativeLocation : LastMove->SavedLocation;
+	MoveBatch.ClientMovementMode = LastMove->EndPackedMovementMode;
+
+	PendingBatchMoves.Reset();
+
+	ServerMoveVRBatch(MoveBatch);
+
+	APlayerController* PC = Cast<APlayerController>(CharacterOwner->GetController());
+	APlayerCameraManager* PlayerCameraManager = (PC ? PC->PlayerCameraManager : NULL);
+	if (PlayerCameraManager != NULL && PlayerCameraManager->bUseClientSideCameraUpdates)
+	{
+		PlayerCameraManager->bShouldSendClientSideCameraUpdate = true;
+	}
+}
+
+void UVRCharacterMovementComponent::ServerMoveVRBatch(const FVRServerMoveBatch& MoveBatch)
+{
+	((AVRCharacter*)CharacterOwner)->ServerMoveVRBatch(MoveBatch);
+}
+
 void UVRCharacterMovementComponent::ServerMoveVR(float TimeStamp, FVector_NetQuantize10 InAccel, FVector_NetQuantize100 ClientLoc, FVector_NetQuantize100 CapsuleLoc, FVRConditionalMoveRep ConditionalReps, FVector_NetQuantize100 LFDiff, uint16 CapsuleYaw, uint8 CompressedMoveFlags, FVRConditionalMoveRep2 MoveReps, uint8 ClientMovementMode)
 {
 	((AVRCharacter*)CharacterOwner)->ServerMoveVR(TimeStamp, InAccel, ClientLoc, CapsuleLoc, ConditionalReps, LFDiff, CapsuleYaw, CompressedMoveFlags, MoveReps, ClientMovementMode);
@@ -962,6 +1185,12 @@ void UVRCharacterMovementComponent::PhysWalking(float deltaTime, int32 Iteration
 	// Rewind the players position by the new capsule location
 	RewindVRRelativeMovement();
 
+	// The root component skipped its own sweep of the HMD movement, resolve it off of the first move sweep instead
+	bResolveDeferredVRRelativeMovement = VRRootCapsule && VRRootCapsule->IsDeferringRelativeMovementSweep() && !AdditionalVRInputVector.IsNearlyZero();
+
+	if (VRRootCapsule && VRRootCapsule->IsDeferringRelativeMovementSweep())
+		VRRootCapsule->bHadRelativeMovement = false;
+
 	// Perform the move
 	while ((remainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) && CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || HasAnimRootMotion() || CurrentRootMotion.HasOverrideVelocity() || (CharacterOwner->Role == ROLE_SimulatedProxy)))
 	{
@@ -970,6 +1199,14 @@ void UVRCharacterMovementComponent::PhysWalking(float deltaTime, int32 Iteration
 		const float timeTick = GetSimulationTimeStep(remainingTime, Iterations);
 		remainingTime -= timeTick;
 
+		// Every iteration re-applies the HMD delta, resolving it against one of them would move it twice.
+		// If the frame gets split up it stays in the swept move instead, the same as if it had collided.
+		if (bResolveDeferredVRRelativeMovement && remainingTime >= MIN_TICK_TIME)
+		{
+			bResolveDeferredVRRelativeMovement = false;
+			VRRootCapsule->bHadRelativeMovement = true;
+		}
+
 		// Save current values
 		UPrimitiveComponent * const OldBase = GetMovementBase();
 		const FVector PreviousBaseLocation = (OldBase != NULL) ? OldBase->GetComponentLocation() : FVector::ZeroVector;
@@ -1031,7 +1268,7 @@ void UVRCharacterMovementComponent::PhysWalking(float deltaTime, int32 Iteration
 				Params.bFindInitialOverlaps = true;
 				bool bWasBlockingHit = false;
 
-				bWasBlockingHit = GetWorld()->SweepSingleByChannel(HitRes, VRRootCapsule->OffsetComponentToWorld.GetLocation(), VRRootCapsule->OffsetComponentToWorld.GetLocation() + VRRootCapsule->DifferenceFromLastFrame, FQuat(0.0f, 0.0f, 0.0f, 1.0f), VRRootCapsule->GetCollisionObjectType(), VRRootCapsule->GetCollisionShape(), Params, ResponseParam);
+				bWasBlockingHit = CountSceneQuery(GetWorld()->SweepSingleByChannel(HitRes, VRRootCapsule->OffsetComponentToWorld.GetLocation(), VRRootCapsule->OffsetComponentToWorld.GetLocation() + VRRootCapsule->DifferenceFromLastFrame, FQuat(0.0f, 0.0f, 0.0f, 1.0f), VRRootCapsule->GetCollisionObjectType(), VRRootCapsule->GetCollisionShape(), Params, ResponseParam));
 				
 				const FVector GravDir(0.f, 0.f, -1.f);
 				if (CanStepUp(HitRes) || (CharacterOwner->GetMovementBase() != NULL && CharacterOwner->GetMovementBase()->GetOwner() == HitRes.GetActor()))
@@ -1180,6 +1417,11 @@ void UVRCharacterMovementComponent::PhysWalking(float deltaTime, int32 Iteration
 			}
 		}
 
+		// While deferring, the HMD delta is applied every frame instead of only on collision, it can't be left in the velocity
+		// on the paths above that skip the recalculation (step ups, root motion).
+		if (VRRootCapsule && VRRootCapsule->IsDeferringRelativeMovementSweep())
+			RestorePreAdditiveVRMotionVelocity();
+
 		// If we didn't move at all this iteration then abort (since future iterations will also be stuck).
 		if (UpdatedComponent->GetComponentLocation() == OldLocation)
 		{
@@ -1189,6 +1431,8 @@ void UVRCharacterMovementComponent::PhysWalking(float deltaTime, int32 Iteration
 		}
 	}
 
+	bResolveDeferredVRRelativeMovement = false;
+
 	if (IsMovingOnGround())
 	{
 		MaintainHorizontalGroundVelocity();
@@ -1378,6 +1622,44 @@ void UVRCharacterMovementComponent::ReplicateMoveToServer(float DeltaTime, const
 		static const auto CVarNetEnableMoveCombining = IConsoleManager::Get().FindConsoleVariable(TEXT("p.NetEnableMoveCombining"));
 		const bool bCanDelayMove = (CVarNetEnableMoveCombining->GetInt() != 0) && CanDelaySendingMove(NewMovePtr);
 
+		// Root motion moves go through the regular (hybrid) RPCs, flush anything batched ahead of them first
+		if (bUseServerMoveBatching && !NewMove->RootMotionMontage)
+		{
+			PendingBatchMoves.Add(NewMovePtr);
+
+			const float NetMoveDelta = ServerMoveBatchInterval > 0.0f ? ServerMoveBatchInterval : FMath::Clamp(GetClientNetSendDeltaTime(PC, ClientData, NewMovePtr), 1.f / 120.f, 1.f / 5.f);
+			const bool bBatchFull = PendingBatchMoves.Num() >= FMath::Clamp(MaxServerMoveBatchSize, 2, (int32)FVRServerMoveBatch::MaxMoves);
+
+			if (bCanDelayMove && !bBatchFull && (MyWorld->TimeSeconds - ClientData->ClientUpdateTime) * MyWorld->GetWorldSettings()->GetEffectiveTimeDilation() < NetMoveDelta)
+			{
+				// Hold this move for the batch
+				ClientData->PendingMove = NULL;
+				return;
+			}
+
+			ClientData->ClientUpdateTime = MyWorld->TimeSeconds;
+
+			bool bSendBatch = true;
+#if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+			static const auto CVarNetForceClientServerMoveLossPercentBatch = IConsoleManager::Get().FindConsoleVariable(TEXT("p.NetForceClientServerMoveLossPercent"));
+			bSendBatch = (CVarNetForceClientServerMoveLossPercentBatch->GetFloat() == 0.f) || (FMath::SRand() >= CVarNetForceClientServerMoveLossPercentBatch->GetFloat());
+#endif
+			if (bSendBatch)
+			{
+				SCOPE_CYCLE_COUNTER(STAT_CharacterMovementCallServerMove);
+				CallServerMoveBatch(OldMove.Get());
+			}
+
+			PendingBatchMoves.Reset();
+			ClientData->PendingMove = NULL;
+			return;
+		}
+		else if (PendingBatchMoves.Num() > 0)
+		{
+			// The root motion move sends the old move itself, don't send it twice
+			CallServerMoveBatch(nullptr);
+		}
+
 		if (bCanDelayMove && ClientData->PendingMove.IsValid() == false)
 		{
 			// Decide whether to hold off on move	
@@ -1438,7 +1720,13 @@ UVRCharacterMovementComponent::UVRCharacterMovementComponent(const FObjectInitia
 	WallRepulsionMultiplier = 0.01f;
 	bUseClientControlRotation = false;
 	bAllowMovementMerging = false;
+	bResolveDeferredVRRelativeMovement = false;
 	bRequestedMoveUseAcceleration = false;
+	bUseServerMoveBatching = false;
+	MaxServerMoveBatchSize = 4;
+	ServerMoveBatchInterval = 0.0f;
+	LastCorrectionReason = EVRMovementCorrectionReason::None;
+	LastClientLocationError = 0.0f;
 }
 
 
@@ -1646,12 +1934,21 @@ void UVRCharacterMovementComponent::MoveAlongFloor(const FVector& InVelocity, fl
 	}
 
 	// Move along the current floor
-	const FVector Delta = FVector(InVelocity.X, InVelocity.Y, 0.f) * DeltaSeconds;
+	FVector Delta = FVector(InVelocity.X, InVelocity.Y, 0.f) * DeltaSeconds;
 	FHitResult Hit(1.f);
 	FVector RampVector = ComputeGroundMovementDelta(Delta, CurrentFloor.HitResult, CurrentFloor.bLineTrace);
 	SafeMoveUpdatedComponent(RampVector, UpdatedComponent->GetComponentQuat(), true, Hit);
 	float LastMoveTimeSlice = DeltaSeconds;
 
+	if (bResolveDeferredVRRelativeMovement)
+	{
+		bResolveDeferredVRRelativeMovement = false;
+
+		// If the HMD was let through, only the locomotion is left to slide / step up with
+		if (ResolveDeferredVRRelativeMovement(Hit, Delta))
+			RampVector = ComputeGroundMovementDelta(Delta, CurrentFloor.HitResult, CurrentFloor.bLineTrace);
+	}
+
 	if (Hit.bStartPenetrating)
 	{
 		// Allow this hit to be used as an impact we can deflect off, otherwise we do nothing the rest of the update and appear to hitch.
@@ -1711,6 +2008,51 @@ void UVRCharacterMovementComponent::MoveAlongFloor(const FVector& InVelocity, fl
 	}
 }
 
+bool UVRCharacterMovementComponent::ResolveDeferredVRRelativeMovement(const FHitResult& MoveHit, FVector& InOutDelta)
+{
+	if (!VRRootCapsule || !MoveHit.bBlockingHit || !MoveHit.Component.IsValid())
+		return false;
+
+	// Same rules that the root components sweep used, only hits that block the walking override channel count as HMD collision
+	const ECollisionResponse WalkingResponse = MoveHit.Component->GetCollisionResponseToChannel(VRRootCapsule->WalkingCollisionOverride);
+	const bool bIgnoreSimulating = bIgnoreSimulatingComponentsInFloorCheck && MoveHit.Component->IsSimulatingPhysics();
+
+	if (WalkingResponse == ECR_Block && !bIgnoreSimulating)
+	{
+		VRRootCapsule->bHadRelativeMovement = true;
+		return false;
+	}
+
+	// The root component would have let the HMD through this, but the rest of its movement can still run into something on the override channel.
+	// Sweep the remainder the same way the root component would have before carrying it.
+	const FVector HMDDelta = FVector(AdditionalVRInputVector.X, AdditionalVRInputVector.Y, 0.f);
+	const FVector RemainingHMDDelta = HMDDelta * (1.f - MoveHit.Time);
+
+	if (!RemainingHMDDelta.IsNearlyZero())
+	{
+		FHitResult OverrideHit;
+		FCollisionQueryParams Params("RelativeMovementSweep", false, GetOwner());
+		FCollisionResponseParams ResponseParam;
+
+		VRRootCapsule->InitSweepCollisionParams(Params, ResponseParam);
+		Params.bFindInitialOverlaps = true;
+
+		const FVector Start = VRRootCapsule->OffsetComponentToWorld.GetLocation();
+		const bool bBlockingHit = CountSceneQuery(GetWorld()->SweepSingleByChannel(OverrideHit, Start, Start + RemainingHMDDelta, FQuat::Identity, VRRootCapsule->WalkingCollisionOverride, VRRootCapsule->GetCollisionShape(), Params, ResponseParam));
+
+		if (bBlockingHit && OverrideHit.Component.IsValid() && !(bIgnoreSimulatingComponentsInFloorCheck && OverrideHit.Component->IsSimulatingPhysics()))
+		{
+			// Counts as HMD collision, leave the HMD in the delta so that it slides / steps up off of the original hit
+			VRRootCapsule->bHadRelativeMovement = true;
+			return false;
+		}
+	}
+
+	MoveUpdatedComponent(RemainingHMDDelta, UpdatedComponent->GetComponentQuat(), false);
+	InOutDelta -= HMDDelta;
+	return true;
+}
+
 bool UVRCharacterMovementComponent::StepUp(const FVector& GravDir, const FVector& Delta, const FHitResult &InHit, FStepDownResult* OutStepDownResult)
 {
 	SCOPE_CYCLE_COUNTER(STAT_CharStepUp);
@@ -3477,7 +3819,7 @@ bool UVRCharacterMovementComponent::CheckWaterJump(FVector CheckPoint, FVector&
 	InitCollisionParams(CapsuleParams, ResponseParam);
 	FCollisionShape CapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_None);
 	const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
-	bool bHit = GetWorld()->SweepSingleByChannel(HitInfo, currentLoc, CheckPoint, FQuat::Identity, CollisionChannel, CapsuleShape, CapsuleParams, ResponseParam);
+	bool bHit = CountSceneQuery(GetWorld()->SweepSingleByChannel(HitInfo, currentLoc, CheckPoint, FQuat::Identity, CollisionChannel, CapsuleShape, CapsuleParams, ResponseParam));
 
 	if (bHit && !Cast<APawn>(HitInfo.GetActor()))
 	{
@@ -3489,7 +3831,7 @@ bool UVRCharacterMovementComponent::CheckWaterJump(FVector CheckPoint, FVector&
 		FCollisionQueryParams LineParams(SCENE_QUERY_STAT(CheckWaterJump), true, CharacterOwner);
 		FCollisionResponseParams LineResponseParam;
 		InitCollisionParams(LineParams, LineResponseParam);
-		bHit = GetWorld()->LineTraceSingleByChannel(HitInfo, Start, CheckPoint, CollisionChannel, LineParams, LineResponseParam);
+		bHit = CountSceneQuery(GetWorld()->LineTraceSingleByChannel(HitInfo, Start, CheckPoint, CollisionChannel, LineParams, LineResponseParam));
 		// if no high obstruction, or it's a valid floor, then pawn can jump out of water
 		return !bHit || IsWalkable(HitInfo);
 	}
@@ -3818,11 +4160,18 @@ void UVRCharacterMovementComponent::SendClientAdjustment()
 			FMath::Min(NetworkMinTimeBetweenClientAdjustmentsLargeCorrection, NetworkMinTimeBetweenClientAdjustments) :
 			FMath::Max(NetworkMinTimeBetweenClientAdjustmentsLargeCorrection, NetworkMinTimeBetweenClientAdjustments);
 
+		FVRMovementCorrectionTelemetry* Telemetry = GetActiveCorrectionTelemetry(CorrectionTelemetry);
+
 		// Check if correction is throttled based on time limit between updates.
 		if (CurrentTime - ServerLastClientAdjustmentTime > AdjustmentTimeThreshold)
 		{
 			ServerLastClientAdjustmentTime = CurrentTime;
 
+			if (Telemetry)
+			{
+				Telemetry->AdjustmentsSent++;
+			}
+
 			const bool bIsPlayingNetworkedRootMotionMontage = CharacterOwner->IsPlayingNetworkedRootMotionMontage();
 			if (HasRootMotionSources())
 			{
@@ -3892,6 +4241,11 @@ void UVRCharacterMovementComponent::SendClientAdjustment()
 				);
 			}
 		}
+		else if (Telemetry)
+		{
+			Telemetry->AdjustmentsThrottled++;
+			CSV_CUSTOM_STAT(VRMovement, AdjustmentsThrottled, 1, ECsvCustomStatOp::Accumulate);
+		}
 	}
 
 	ServerData->PendingAdjustment.TimeStamp = 0;
@@ -4002,6 +4356,17 @@ void UVRCharacterMovementComponent::ClientAdjustPositionVR_Implementation
 
 	ClientData->AckMove(MoveIndex);
 
+	// The replay starts from the corrected location, don't let it reuse a floor found from the mispredicted one
+	FloorCache.Invalidate();
+
+	// Everything still saved after the ack gets replayed in ClientUpdatePositionAfterServerUpdate
+	if (FVRMovementCorrectionTelemetry* Telemetry = GetActiveCorrectionTelemetry(CorrectionTelemetry))
+	{
+		Telemetry->RecordReplay(ClientData->SavedMoves.Num());
+		CSV_CUSTOM_STAT(VRMovement, AdjustmentsReceived, 1, ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(VRMovement, ReplayedMoves, ClientData->SavedMoves.Num(), ECsvCustomStatOp::Accumulate);
+	}
+
 	FVector WorldShiftedNewLocation;
 	//  Received Location is relative to dynamic base
 	if (bBaseRelativePosition)
@@ -4072,10 +4437,13 @@ void UVRCharacterMovementComponent::ClientAdjustPositionVR_Implementation
 
 bool UVRCharacterMovementComponent::ServerCheckClientErrorVR(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, float ClientYaw, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
 {
+	LastCorrectionReason = EVRMovementCorrectionReason::None;
+
 	// Check location difference against global setting
 	if (!bIgnoreClientMovementErrorChecksAndCorrection)
 	{
 		const FVector LocDiff = UpdatedComponent->GetComponentLocation() - ClientWorldLocation;
+		LastClientLocationError = LocDiff.Size();
 
 #if ROOT_MOTION_DEBUG
 		if (RootMotionSourceDebug::CVarDebugRootMotionSources.GetValueOnAnyThread() == 1)
@@ -4088,6 +4456,7 @@ bool UVRCharacterMovementComponent::ServerCheckClientErrorVR(float ClientTimeSta
 		if (GetDefault<AGameNetworkManager>()->ExceedsAllowablePositionError(LocDiff))
 		{
 			bNetworkLargeClientCorrection = (LocDiff.SizeSquared() > FMath::Square(NetworkLargeClientCorrectionDistance));
+			LastCorrectionReason = EVRMovementCorrectionReason::LocationError;
 			return true;
 		}
 #if !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
@@ -4097,6 +4466,7 @@ bool UVRCharacterMovementComponent::ServerCheckClientErrorVR(float ClientTimeSta
 			if (FMath::SRand() < CVarNetForceClientAdjustmentPercent->GetFloat())
 			{
 				UE_LOG(LogVRCharacterMovement, VeryVerbose, TEXT("** ServerCheckClientError forced by p.NetForceClientAdjustmentPercent"));
+				LastCorrectionReason = EVRMovementCorrectionReason::ForcedPercent;
 				return true;
 			}
 		}
@@ -4117,12 +4487,14 @@ bool UVRCharacterMovementComponent::ServerCheckClientErrorVR(float ClientTimeSta
 	const uint8 CurrentPackedMovementMode = PackNetworkMovementMode();
 	if (CurrentPackedMovementMode != ClientMovementMode)
 	{
+		LastCorrectionReason = EVRMovementCorrectionReason::MovementMode;
 		return true;
 	}
 	
 	// If we are rolling back client rotation
 	if (!bUseClientControlRotation && !FMath::IsNearlyEqual(FRotator::ClampAxis(ClientYaw), FRotator::ClampAxis(UpdatedComponent->GetComponentRotation().Yaw), CharacterMovementComponentStatics::fRotationCorrectionThreshold))
 	{
+		LastCorrectionReason = EVRMovementCorrectionReason::YawRollback;
 		return true;
 	}
 
@@ -4161,9 +4533,23 @@ void UVRCharacterMovementComponent::ServerMoveHandleClientErrorVR(float ClientTi
 	// Compute the client error from the server's position
 	// If client has accumulated a noticeable positional error, correct them.
 	bNetworkLargeClientCorrection = ServerData->bForceClientUpdate;
+	LastClientLocationError = 0.0f;
+
+	FVRMovementCorrectionTelemetry* Telemetry = GetActiveCorrectionTelemetry(CorrectionTelemetry);
+	if (Telemetry)
+	{
+		Telemetry->ServerMovesChecked++;
+	}
 
 	if (ServerData->bForceClientUpdate || ServerCheckClientErrorVR(ClientTimeStamp, DeltaTime, Accel, ClientLoc, ClientYaw, RelativeClientLoc, ClientMovementBase, ClientBaseBoneName, ClientMovementMode))
 	{
+		if (Telemetry)
+		{
+			const EVRMovementCorrectionReason Reason = ServerData->bForceClientUpdate ? EVRMovementCorrectionReason::ForcedUpdate : LastCorrectionReason;
+			Telemetry->RecordCorrection(Reason, LastClientLocationError);
+			CsvRecordCorrection(Reason, LastClientLocationError);
+		}
+
 		UPrimitiveComponent* MovementBase = CharacterOwner->GetMovementBase();
 		ServerData->PendingAdjustment.NewVel = Velocity;
 		ServerData->PendingAdjustment.NewBase = MovementBase;
@@ -1,7 +1,330 @@
 #include "VRGestureComponent.h"
 #include "TimerManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Containers/Queue.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "UObject/CoreNet.h"
+#include "Engine/NetSerialization.h"
+
+DEFINE_LOG_CATEGORY(LogVRGesture);
 
 DECLARE_CYCLE_STAT(TEXT("TickGesture ~ TickingGesture"), STAT_TickGesture, STATGROUP_TickGesture);
+DECLARE_CYCLE_STAT(TEXT("TickGesture ~ AsyncDetection"), STAT_GestureAsyncDetection, STATGROUP_TickGesture);
+DECLARE_CYCLE_STAT(TEXT("TickGesture ~ ServerVerification"), STAT_GestureVerification, STATGROUP_TickGesture);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("TickGesture ~ VerificationBitsSent"), STAT_GestureVerificationBits, STATGROUP_TickGesture);
+
+// Entry in the queue to the async detector, either a newly captured sample or a request to clear the log
+struct FVRGestureAsyncSample
+{
+	FVector Sample;
+	bool bClearLog;
+
+	FVRGestureAsyncSample()
+	{
+		Sample = FVector::ZeroVector;
+		bClearLog = false;
+	}
+
+	FVRGestureAsyncSample(const FVector & NewSample, bool bInClearLog)
+	{
+		Sample = NewSample;
+		bClearLog = bInClearLog;
+	}
+};
+
+// Entry in the queue back from the async detector, the log is only filled in if the detector was asked to keep it
+struct FVRGestureAsyncDetection
+{
+	int GestureIndex;
+	FVRGesture DetectedLog;
+
+	FVRGestureAsyncDetection()
+	{
+		GestureIndex = INDEX_NONE;
+	}
+};
+
+// Runs gesture detection for a component on task graph workers.
+// The game thread is the only producer of samples and consumer of detections, and only one worker task is
+// ever in flight per detector, so both queues are single producer / single consumer.
+class FVRGestureAsyncDetector
+{
+public:
+
+	// Game thread -> worker
+	TQueue<FVRGestureAsyncSample, EQueueMode::Spsc> PendingSamples;
+
+	// Worker -> game thread, indices are into the database the copy was taken from
+	TQueue<FVRGestureAsyncDetection, EQueueMode::Spsc> DetectedGestures;
+
+	// Only touched on the game thread
+	FGraphEventRef DetectionTask;
+	bool bSamplesPendingDispatch;
+
+	FVRGestureAsyncDetector(UGesturesDatabase * Database, int maxSlope, EVRGestureMirrorMode MirroringHand, bool bParallelScoring, int InBufferSize, bool bInKeepDetectedLogs)
+	{
+		Gestures = Database->Gestures;
+		SampleCache = Database->EnsureSampleCache();
+		TargetGestureScale = Database->TargetGestureScale;
+
+		Matcher.maxSlope = maxSlope;
+		Matcher.MirroringHand = MirroringHand;
+		Matcher.bParallelScoring = bParallelScoring;
+
+		BufferSize = InBufferSize;
+		bKeepDetectedLogs = bInKeepDetectedLogs;
+		GestureLog.GestureSize.Init();
+		GestureLog.Samples.Reserve(BufferSize);
+		bSamplesPendingDispatch = false;
+	}
+
+	// Runs on the worker, mirrors what CaptureGestureFrame and RecognizeGesture do to the game threads log
+	void ProcessPendingSamples()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_GestureAsyncDetection);
+
+		FVRGestureAsyncSample NewSample;
+		while (PendingSamples.Dequeue(NewSample))
+		{
+			if (NewSample.bClearLog)
+			{
+				GestureLog.Samples.Reset(BufferSize);
+				continue;
+			}
+
+			if (GestureLog.Samples.Num() >= BufferSize)
+				GestureLog.Samples.Pop(false);
+
+			GestureLog.GestureSize.Max = GestureLog.GestureSize.Max.ComponentMax(NewSample.Sample);
+			GestureLog.GestureSize.Min = GestureLog.GestureSize.Min.ComponentMin(NewSample.Sample);
+			GestureLog.Samples.Insert(NewSample.Sample, 0);
+
+			int GestureIndex = Matcher.FindBestMatch(GestureLog, Gestures, TargetGestureScale, &SampleCache);
+			if (GestureIndex != INDEX_NONE)
+			{
+				FVRGestureAsyncDetection Detection;
+				Detection.GestureIndex = GestureIndex;
+				if (bKeepDetectedLogs)
+					Detection.DetectedLog = GestureLog;
+
+				DetectedGestures.Enqueue(MoveTemp(Detection));
+				GestureLog.Samples.Reset(BufferSize);
+			}
+		}
+	}
+
+private:
+
+	// Copy of the database so the game thread is free to edit the original
+	TArray<FVRGesture> Gestures;
+	TArray<FVRGestureSampleSoA> SampleCache;
+	float TargetGestureScale;
+
+	FVRGestureMatcher Matcher;
+	FVRGesture GestureLog;
+	int BufferSize;
+
+	// Copy the log out with each detection so that it can be sent for verification
+	bool bKeepDetectedLogs;
+};
+
+namespace VRGestureBenchmarks
+{
+	// Compares the per cell scalar distances that dtw used to run against the SoA row kernel
+	static void RunDistanceBenchmark()
+	{
+		const int MatrixSizes[] = { 60, 200 };
+		const int Iterations = 200;
+
+		FRandomStream RandStream(1234);
+
+		for (int MatrixSize : MatrixSizes)
+		{
+			TArray<FVector> InputSamples;
+			TArray<FVector> ExampleSamples;
+			for (int i = 0; i < MatrixSize; ++i)
+			{
+				InputSamples.Add(RandStream.GetUnitVector() * RandStream.FRandRange(0.f, 100.f));
+				ExampleSamples.Add(RandStream.GetUnitVector() * RandStream.FRandRange(0.f, 100.f));
+			}
+
+			FVRGestureSampleSoA ExampleSoA;
+			ExampleSoA.Build(ExampleSamples);
+
+			TArray<float, TAlignedHeapAllocator<16>> RowDistances;
+			RowDistances.SetNumZeroed(FVRGestureSampleSoA::GetPaddedCount(MatrixSize));
+
+			float ScalarSum = 0.f;
+			double StartTime = FPlatformTime::Seconds();
+			for (int Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				for (int i = 0; i < MatrixSize; ++i)
+				{
+					for (int j = 0; j < MatrixSize; ++j)
+					{
+						ScalarSum += FVector::DistSquared(InputSamples[i], ExampleSamples[j]);
+					}
+				}
+			}
+			double ScalarTime = FPlatformTime::Seconds() - StartTime;
+
+			float KernelSum = 0.f;
+			StartTime = FPlatformTime::Seconds();
+			for (int Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				for (int i = 0; i < MatrixSize; ++i)
+				{
+					ExampleSoA.GetRowDistances(InputSamples[i], RowDistances.GetData());
+					for (int j = 0; j < MatrixSize; ++j)
+					{
+						KernelSum += RowDistances[j];
+					}
+				}
+			}
+			double KernelTime = FPlatformTime::Seconds() - StartTime;
+
+			double CellCount = (double)MatrixSize * MatrixSize * Iterations;
+			UE_LOG(LogVRGesture, Display, TEXT("Gesture distances %dx%d: Scalar %.2f ns/cell, SoA kernel %.2f ns/cell (%.2fx), results %s"),
+				MatrixSize, MatrixSize,
+				(ScalarTime * 1.0e9) / CellCount,
+				(KernelTime * 1.0e9) / CellCount,
+				KernelTime > 0.0 ? ScalarTime / KernelTime : 0.0,
+				ScalarSum == KernelSum ? TEXT("match") : TEXT("DIFFER"));
+		}
+	}
+
+	// Compares FastDTW against the full table on the same database, either a cooked database passed in or generated random walks
+	static void RunFastDTWBenchmark(const TArray<FString> & Args)
+	{
+		FRandomStream RandStream(4321);
+
+		UGesturesDatabase * Database = nullptr;
+		if (Args.Num() > 0)
+		{
+			Database = UGesturesDatabase::LoadCookedGestures(GetTransientPackage(), Args[0]);
+			if (Database == nullptr)
+				return;
+		}
+		else
+		{
+			Database = NewObject<UGesturesDatabase>();
+
+			for (int GestureIndex = 0; GestureIndex < 20; ++GestureIndex)
+			{
+				FVRGesture NewGesture;
+				NewGesture.GestureSize.Init();
+
+				FVector Position = FVector::ZeroVector;
+				for (int i = 0; i < 150; ++i)
+				{
+					Position += RandStream.GetUnitVector() * 2.f;
+					NewGesture.Samples.Add(Position);
+				}
+
+				NewGesture.CalculateSizeOfGesture(true, Database->TargetGestureScale);
+				Database->Gestures.Add(NewGesture);
+				Database->MarkGesturesDirty();
+			}
+		}
+
+		const int Radii[] = { 1, 4, 8 };
+		FVRGestureMatcher Matcher;
+
+		for (int Radius : Radii)
+		{
+			double ExactTime = 0.0;
+			double FastTime = 0.0;
+			double TotalError = 0.0;
+			int ComparedCount = 0;
+			int MatchingBestCount = 0;
+
+			for (const FVRGesture & QueryGesture : Database->Gestures)
+			{
+				if (QueryGesture.Samples.Num() < 1)
+					continue;
+
+				// Noisy, rescaled copy of the gesture with some leading movement in front of it (oldest samples are at the end)
+				FVRGesture Input;
+				Input.GestureSize.Init();
+				float InputScale = RandStream.FRandRange(0.5f, 2.f);
+				for (const FVector & Sample : QueryGesture.Samples)
+				{
+					Input.Samples.Add((Sample + RandStream.GetUnitVector() * RandStream.FRandRange(0.f, 3.f)) * InputScale);
+				}
+				for (int i = 0; i < 20; ++i)
+				{
+					Input.Samples.Add(Input.Samples.Last() + RandStream.GetUnitVector() * 2.f * InputScale);
+				}
+				Input.CalculateSizeOfGesture(false);
+
+				float Scaler = Database->TargetGestureScale / Input.GestureSize.GetSize().GetMax();
+
+				int ExactBest = INDEX_NONE;
+				int FastBest = INDEX_NONE;
+				float ExactBestCost = MAX_FLT;
+				float FastBestCost = MAX_FLT;
+
+				for (int i = 0; i < Database->Gestures.Num(); ++i)
+				{
+					const FVRGesture & Example = Database->Gestures[i];
+					if (Example.Samples.Num() < 1)
+						continue;
+
+					double StartTime = FPlatformTime::Seconds();
+					float ExactCost = Matcher.dtw(Input, Example, false, Scaler) / Example.Samples.Num();
+					ExactTime += FPlatformTime::Seconds() - StartTime;
+
+					StartTime = FPlatformTime::Seconds();
+					float FastCost = Matcher.fastdtw(Input, Example, false, Scaler, Radius) / Example.Samples.Num();
+					FastTime += FPlatformTime::Seconds() - StartTime;
+
+					if (ExactCost < MAX_FLT && FastCost < MAX_FLT && ExactCost > 0.f)
+					{
+						TotalError += FMath::Abs(FastCost - ExactCost) / ExactCost;
+						ComparedCount++;
+					}
+
+					if (ExactCost < ExactBestCost)
+					{
+						ExactBestCost = ExactCost;
+						ExactBest = i;
+					}
+
+					if (FastCost < FastBestCost)
+					{
+						FastBestCost = FastCost;
+						FastBest = i;
+					}
+				}
+
+				if (ExactBest == FastBest)
+					MatchingBestCount++;
+			}
+
+			int QueryCount = FMath::Max(Database->Gestures.Num(), 1);
+			UE_LOG(LogVRGesture, Display, TEXT("FastDTW radius %d over %d gestures: exact %.3f ms/query, fast %.3f ms/query (%.2fx), mean cost error %.2f%%, same best match %d/%d"),
+				Radius, Database->Gestures.Num(),
+				(ExactTime * 1000.0) / QueryCount,
+				(FastTime * 1000.0) / QueryCount,
+				FastTime > 0.0 ? ExactTime / FastTime : 0.0,
+				ComparedCount > 0 ? (TotalError * 100.0) / ComparedCount : 0.0,
+				MatchingBestCount, Database->Gestures.Num());
+		}
+	}
+
+	FAutoConsoleCommand CmdBenchmarkGestureFastDTW(
+		TEXT("vr.BenchmarkGestureFastDTW"),
+		TEXT("Compares FastDTW against full DTW on a cooked gesture database (optional path argument) or on generated gestures and logs latency and accuracy."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunFastDTWBenchmark));
+
+	FAutoConsoleCommand CmdBenchmarkGestureDistances(
+		TEXT("vr.BenchmarkGestureDistances"),
+		TEXT("Times the scalar gesture distance path against the SoA distance kernel on 60x60 and 200x200 matrices and logs the results."),
+		FConsoleCommandDelegate::CreateStatic(&RunDistanceBenchmark));
+}
 
 UVRGestureComponent::UVRGestureComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -18,448 +341,1710 @@ UVRGestureComponent::UVRGestureComponent(const FObjectInitializer& ObjectInitial
 	MirroringHand = EVRGestureMirrorMode::GES_NoMirror;
 	bDrawSplinesCurved = true;
 	bGetGestureInWorldSpace = true;
+	bDetectGesturesAsync = false;
+	bScoreGesturesInParallel = false;
+	bVerifyGesturesOnServer = false;
+	LastVerificationBits = 0;
+	TotalVerificationBits = 0;
+	VerificationCount = 0;
 }
 
-void UGesturesDatabase::FillSplineWithGesture(FVRGesture &Gesture, USplineComponent * SplineComponent, bool bCenterPointsOnSpline, bool bScaleToBounds, float OptionalBounds, bool bUseCurvedPoints, bool bFillInSplineMeshComponents, UStaticMesh * Mesh, UMaterial * MeshMat)
+void UVRGestureComponent::OnRegister()
 {
-	if (!SplineComponent || Gesture.Samples.Num() < 2)
-		return;
+	// Only used for the verification RPCs, there are no replicated properties so leave it to the owner otherwise
+	if (bVerifyGesturesOnServer)
+	{
+		SetIsReplicated(true);
+	}
 
-	UWorld* InWorld = GEngine->GetWorldFromContextObject(SplineComponent, EGetWorldErrorMode::LogAndReturnNull);
+	Super::OnRegister();
+}
 
-	if (!InWorld)
-		return;
+void FVRGestureSampleSoA::Build(const TArray<FVector> & Samples)
+{
+	SampleCount = Samples.Num();
+	SampleHash = HashSamples(Samples);
+	int PaddedCount = GetPaddedCount(SampleCount);
+
+	X.Reset(PaddedCount);
+	Y.Reset(PaddedCount);
+	Z.Reset(PaddedCount);
+	X.AddZeroed(PaddedCount);
+	Y.AddZeroed(PaddedCount);
+	Z.AddZeroed(PaddedCount);
+
+	for (int i = 0; i < SampleCount; ++i)
+	{
+		X[i] = Samples[i].X;
+		Y[i] = Samples[i].Y;
+		Z[i] = Samples[i].Z;
+	}
+}
 
-	SplineComponent->ClearSplinePoints(false);
+void FVRGestureSampleSoA::GetRowDistances(const FVector & Sample, float * OutDistances) const
+{
+	// Same operation order as FVector::DistSquared and no fused multiply add, so each lane is bit identical to the scalar path
+	const VectorRegister SampleX = VectorSetFloat1(Sample.X);
+	const VectorRegister SampleY = VectorSetFloat1(Sample.Y);
+	const VectorRegister SampleZ = VectorSetFloat1(Sample.Z);
 
-	FVector PointOffset = FVector::ZeroVector;
-	float Scaler = 1.0f;
-	if (bScaleToBounds && OptionalBounds > 0.0f)
+	const float * XData = X.GetData();
+	const float * YData = Y.GetData();
+	const float * ZData = Z.GetData();
+
+	for (int i = 0; i < X.Num(); i += 4)
 	{
-		Scaler = OptionalBounds / Gesture.GestureSize.GetSize().GetMax();
+		VectorRegister DiffX = VectorSubtract(VectorLoadAligned(XData + i), SampleX);
+		VectorRegister DiffY = VectorSubtract(VectorLoadAligned(YData + i), SampleY);
+		VectorRegister DiffZ = VectorSubtract(VectorLoadAligned(ZData + i), SampleZ);
+
+		VectorRegister Dist = VectorAdd(VectorAdd(VectorMultiply(DiffX, DiffX), VectorMultiply(DiffY, DiffY)), VectorMultiply(DiffZ, DiffZ));
+		VectorStoreAligned(Dist, OutDistances + i);
 	}
+}
 
-	if (bCenterPointsOnSpline)
+const float FVRGestureSampleRep::MaxQuantizationError = 0.005f * 1.7320508f;
+
+void FVRGestureSampleRep::SetFromGesture(const FVRGesture & Gesture)
+{
+	int SampleCount = FMath::Min(Gesture.Samples.Num(), MaxSamples);
+	Samples.Reset(SampleCount);
+
+	// Quantize against the previous quantized sample so that the receiver rebuilds exactly these values
+	FVector Previous = FVector::ZeroVector;
+	for (int i = 0; i < SampleCount; ++i)
 	{
-		PointOffset = -Gesture.GestureSize.GetCenter();
+		FVector Delta = Gesture.Samples[i] - Previous;
+		Delta.X = FMath::RoundToFloat(Delta.X * 100.f) / 100.f;
+		Delta.Y = FMath::RoundToFloat(Delta.Y * 100.f) / 100.f;
+		Delta.Z = FMath::RoundToFloat(Delta.Z * 100.f) / 100.f;
+
+		Previous += Delta;
+		Samples.Add(Previous);
 	}
 
-	int curIndex = 0;
-	for (int i = Gesture.Samples.Num() - 1; i >= 0; --i)
+	GestureSize = Gesture.GestureSize;
+}
+
+bool FVRGestureSampleRep::ToGesture(FVRGesture & OutGesture) const
+{
+	if (Samples.Num() < 1 || Samples.Num() > MaxSamples || !GestureSize.IsValid)
+		return false;
+
+	OutGesture.Samples = Samples;
+	OutGesture.GestureSize = GestureSize;
+
+	// The log bounds only ever grow, so they have to hold every sample. Allow for the quantization of both.
+	FBox QuantizedBounds = GestureSize.ExpandBy(0.02f);
+	for (const FVector & Sample : Samples)
 	{
-		SplineComponent->AddSplinePoint((Gesture.Samples[i] + PointOffset) * Scaler, ESplineCoordinateSpace::Local, false);
-		curIndex++;
-		SplineComponent->SetSplinePointType(curIndex, bUseCurvedPoints ? ESplinePointType::Curve : ESplinePointType::Linear, false);
+		if (!QuantizedBounds.IsInsideOrOn(Sample))
+			return false;
 	}
 
-	// Update spline now
-	SplineComponent->UpdateSpline();
+	return true;
+}
 
-	if (bFillInSplineMeshComponents && Mesh != nullptr && MeshMat != nullptr)
+bool FVRGestureSampleRep::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint32 SampleCount = Samples.Num();
+	Ar.SerializeIntPacked(SampleCount);
+
+	if (Ar.IsLoading())
 	{
-		TArray<USplineMeshComponent *> CurrentSplineChildren;
-		
-		TArray<USceneComponent*> Children;
-		SplineComponent->GetChildrenComponents(false, Children);
-		for (auto Child : Children)
+		if (SampleCount > (uint32)MaxSamples)
 		{
-			USplineMeshComponent* SplineMesh = Cast<USplineMeshComponent>(Child);
-			if (SplineMesh != nullptr && !SplineMesh->IsPendingKill())
-			{
-				CurrentSplineChildren.Add(SplineMesh);
-			}
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
 		}
 
-		if (CurrentSplineChildren.Num() > SplineComponent->GetNumberOfSplinePoints() - 1)
+		Samples.Reset(SampleCount);
+		Samples.AddZeroed(SampleCount);
+	}
+
+	bOutSuccess &= SerializePackedVector<100, 30>(GestureSize.Min, Ar);
+	bOutSuccess &= SerializePackedVector<100, 30>(GestureSize.Max, Ar);
+
+	if (Ar.IsLoading())
+		GestureSize.IsValid = 1;
+
+	// Each sample is sent as the delta from the one before it, SerializePackedVector picks the bit width per delta
+	FVector Previous = FVector::ZeroVector;
+	FVector Delta;
+	for (uint32 i = 0; i < SampleCount; ++i)
+	{
+		if (Ar.IsSaving())
+			Delta = Samples[i] - Previous;
+
+		bOutSuccess &= SerializePackedVector<100, 30>(Delta, Ar);
+
+		if (Ar.IsLoading())
+			Samples[i] = Previous + Delta;
+
+		Previous = Samples[i];
+	}
+
+	return bOutSuccess;
+}
+
+const TArray<FVRGestureSampleSoA> & UGesturesDatabase::EnsureSampleCache()
+{
+	if (SampleCacheRevision != GestureRevision || SampleCache.Num() != Gestures.Num())
+	{
+		RebuildSampleCache();
+	}
+	else
+	{
+		// Sample edits that weren't marked (blueprint sets, in place edits), a CRC of each gesture is cheap next to the match itself
+		for (int i = 0; i < Gestures.Num(); ++i)
 		{
-			int diff = CurrentSplineChildren.Num() - (CurrentSplineChildren.Num() - (SplineComponent->GetNumberOfSplinePoints() -1));
+			if (!SampleCache[i].IsBuiltFrom(Gestures[i].Samples))
+				SampleCache[i].Build(Gestures[i].Samples);
+		}
+	}
 
-			for (int i = CurrentSplineChildren.Num()- 1; i >= diff; --i)
-			{
-				if (!CurrentSplineChildren[i]->IsBeingDestroyed())
-				{
-					CurrentSplineChildren[i]->SetVisibility(false);
-					CurrentSplineChildren[i]->Modify();
-					CurrentSplineChildren[i]->DestroyComponent();
-					CurrentSplineChildren.RemoveAt(i);
-				}
-			}
+	return SampleCache;
+}
+
+void UGesturesDatabase::RebuildSampleCache()
+{
+	SampleCache.SetNum(Gestures.Num());
+	SampleCacheRevision = GestureRevision;
+	GestureTypeIndex.Reset();
+
+	for (int i = 0; i < Gestures.Num(); ++i)
+	{
+		SampleCache[i].Build(Gestures[i].Samples);
+		GestureTypeIndex.FindOrAdd(Gestures[i].GestureType).Add(i);
+	}
+}
+
+void UGesturesDatabase::GetGesturesOfType(uint8 GestureType, TArray<int> & OutGestureIndices)
+{
+	OutGestureIndices.Reset();
+
+	int IndexedCount = 0;
+	for (const TPair<uint8, TArray<int>> & TypeEntry : GestureTypeIndex)
+	{
+		IndexedCount += TypeEntry.Value.Num();
+	}
+
+	if (IndexedCount != Gestures.Num() || SampleCacheRevision != GestureRevision)
+		RebuildSampleCache();
+
+	if (const TArray<int> * TypeGestures = GestureTypeIndex.Find(GestureType))
+	{
+		OutGestureIndices = *TypeGestures;
+	}
+}
+
+namespace VRGestureCookedFormat
+{
+	// Layout: Header | Entries | TypeRanges | TypeIndices | Samples (16 byte aligned) | Names
+	// Offsets are in bytes from the start of the file, everything is stored little endian.
+	static const uint32 Magic = 0x44475256; // "VRGD"
+	static const uint32 Version = 2;
+	static const uint32 SampleAlignment = 16;
+	// Upper bound on an entries sample count, keeps GetPaddedCount and the byte sizes derived from it inside int32
+	static const uint32 MaxSampleCount = 1 << 20;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 GestureCount;
+		uint32 TypeRangeCount;
+		float TargetGestureScale;
+		uint32 EntriesOffset;
+		uint32 TypeRangesOffset;
+		uint32 TypeIndicesOffset;
+		uint32 SamplesOffset;
+		uint32 NamesOffset;
+		uint32 TotalSize;
+		uint32 Reserved;
+	};
+
+	struct FGestureEntry
+	{
+		float BoundsMin[3];
+		float BoundsMax[3];
+		// X, Y and Z blocks of FVRGestureSampleSoA::GetPaddedCount(SampleCount) floats each, back to back
+		uint32 SampleOffset;
+		uint32 SampleCount;
+		uint32 NameOffset;
+		uint32 NameLength;
+		int32 MinimumGestureLength;
+		float FirstThreshold;
+		float FullThreshold;
+		int32 FastDTWRadius;
+		uint8 GestureType;
+		uint8 MirrorMode;
+		uint8 bEnabled;
+		uint8 bUseFastDTW;
+	};
+
+	// Range of TypeIndices holding the gestures of one GestureType
+	struct FTypeRange
+	{
+		uint32 GestureType;
+		uint32 FirstIndex;
+		uint32 Count;
+	};
+
+	static_assert(sizeof(FHeader) % SampleAlignment == 0, "Cooked gesture header must keep the following blocks aligned");
+	static_assert(sizeof(FGestureEntry) == 60, "Cooked gesture entry layout changed, bump the version");
+	static_assert(sizeof(FTypeRange) == 12, "Cooked gesture type range layout changed, bump the version");
+
+	static bool IsRangeValid(uint64 Offset, uint64 Size, uint64 TotalSize)
+	{
+		return Offset <= TotalSize && Size <= TotalSize - Offset;
+	}
+}
+
+bool UGesturesDatabase::SaveCookedGestures(const FString & FilePath)
+{
+	using namespace VRGestureCookedFormat;
+
+#if !PLATFORM_LITTLE_ENDIAN
+	UE_LOG(LogVRGesture, Warning, TEXT("Cooked gesture databases are only supported on little endian platforms"));
+	return false;
+#else
+
+	// Normalize copies so the asset itself is left as is, this is idempotent for gestures that are already at the target scale
+	TArray<FVRGesture> NormalizedGestures = Gestures;
+	for (FVRGesture & Gesture : NormalizedGestures)
+	{
+		Gesture.CalculateSizeOfGesture(true, TargetGestureScale);
+	}
+
+	// Stable sort of the gesture indices by type for the index
+	TArray<uint32> TypeIndices;
+	for (int i = 0; i < NormalizedGestures.Num(); ++i)
+	{
+		TypeIndices.Add(i);
+	}
+	TypeIndices.StableSort([&NormalizedGestures](const uint32 & A, const uint32 & B)
+	{
+		return NormalizedGestures[A].GestureType < NormalizedGestures[B].GestureType;
+	});
+
+	TArray<FTypeRange> TypeRanges;
+	for (int i = 0; i < TypeIndices.Num(); ++i)
+	{
+		uint8 GestureType = NormalizedGestures[TypeIndices[i]].GestureType;
+		if (TypeRanges.Num() < 1 || TypeRanges.Last().GestureType != GestureType)
+		{
+			FTypeRange NewRange;
+			NewRange.GestureType = GestureType;
+			NewRange.FirstIndex = i;
+			NewRange.Count = 0;
+			TypeRanges.Add(NewRange);
 		}
-		else
+
+		TypeRanges.Last().Count++;
+	}
+
+	FHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = Magic;
+	Header.Version = Version;
+	Header.GestureCount = NormalizedGestures.Num();
+	Header.TypeRangeCount = TypeRanges.Num();
+	Header.TargetGestureScale = TargetGestureScale;
+	Header.EntriesOffset = sizeof(FHeader);
+	Header.TypeRangesOffset = Header.EntriesOffset + sizeof(FGestureEntry) * NormalizedGestures.Num();
+	Header.TypeIndicesOffset = Header.TypeRangesOffset + sizeof(FTypeRange) * TypeRanges.Num();
+	Header.SamplesOffset = Align(Header.TypeIndicesOffset + sizeof(uint32) * TypeIndices.Num(), SampleAlignment);
+
+	TArray<FGestureEntry> Entries;
+	Entries.AddZeroed(NormalizedGestures.Num());
+
+	TArray<TArray<uint8>> Names;
+	uint32 SampleBytes = 0;
+	uint32 NameBytes = 0;
+	for (int i = 0; i < NormalizedGestures.Num(); ++i)
+	{
+		const FVRGesture & Gesture = NormalizedGestures[i];
+		FGestureEntry & Entry = Entries[i];
+
+		if ((uint32)Gesture.Samples.Num() > MaxSampleCount)
+		{
+			UE_LOG(LogVRGesture, Warning, TEXT("Gesture %s has too many samples to cook"), *Gesture.Name);
+			return false;
+		}
+
+		Entry.BoundsMin[0] = Gesture.GestureSize.Min.X;
+		Entry.BoundsMin[1] = Gesture.GestureSize.Min.Y;
+		Entry.BoundsMin[2] = Gesture.GestureSize.Min.Z;
+		Entry.BoundsMax[0] = Gesture.GestureSize.Max.X;
+		Entry.BoundsMax[1] = Gesture.GestureSize.Max.Y;
+		Entry.BoundsMax[2] = Gesture.GestureSize.Max.Z;
+		Entry.SampleOffset = Header.SamplesOffset + SampleBytes;
+		Entry.SampleCount = Gesture.Samples.Num();
+		Entry.MinimumGestureLength = Gesture.GestureSettings.Minimum_Gesture_Length;
+		Entry.FirstThreshold = Gesture.GestureSettings.firstThreshold;
+		Entry.FullThreshold = Gesture.GestureSettings.FullThreshold;
+		Entry.GestureType = Gesture.GestureType;
+		Entry.MirrorMode = (uint8)Gesture.GestureSettings.MirrorMode;
+		Entry.bEnabled = Gesture.GestureSettings.bEnabled ? 1 : 0;
+		Entry.bUseFastDTW = Gesture.GestureSettings.bUseFastDTW ? 1 : 0;
+		Entry.FastDTWRadius = Gesture.GestureSettings.FastDTWRadius;
+
+		SampleBytes += FVRGestureSampleSoA::GetPaddedCount(Gesture.Samples.Num()) * 3 * sizeof(float);
+
+		FTCHARToUTF8 NameConverter(*Gesture.Name);
+		Names.Emplace(reinterpret_cast<const uint8*>(NameConverter.Get()), NameConverter.Length());
+		Entry.NameOffset = NameBytes;
+		Entry.NameLength = Names.Last().Num();
+		NameBytes += Entry.NameLength;
+	}
+
+	Header.NamesOffset = Header.SamplesOffset + SampleBytes;
+	Header.TotalSize = Header.NamesOffset + NameBytes;
+
+	for (FGestureEntry & Entry : Entries)
+	{
+		Entry.NameOffset += Header.NamesOffset;
+	}
+
+	TArray<uint8> Buffer;
+	Buffer.AddZeroed(Header.TotalSize);
+	uint8 * Data = Buffer.GetData();
+
+	FMemory::Memcpy(Data, &Header, sizeof(FHeader));
+	FMemory::Memcpy(Data + Header.EntriesOffset, Entries.GetData(), sizeof(FGestureEntry) * Entries.Num());
+	FMemory::Memcpy(Data + Header.TypeRangesOffset, TypeRanges.GetData(), sizeof(FTypeRange) * TypeRanges.Num());
+	FMemory::Memcpy(Data + Header.TypeIndicesOffset, TypeIndices.GetData(), sizeof(uint32) * TypeIndices.Num());
+
+	FVRGestureSampleSoA GestureSoA;
+	for (int i = 0; i < NormalizedGestures.Num(); ++i)
+	{
+		GestureSoA.Build(NormalizedGestures[i].Samples);
+		int PaddedBytes = GestureSoA.X.Num() * sizeof(float);
+
+		FMemory::Memcpy(Data + Entries[i].SampleOffset, GestureSoA.X.GetData(), PaddedBytes);
+		FMemory::Memcpy(Data + Entries[i].SampleOffset + PaddedBytes, GestureSoA.Y.GetData(), PaddedBytes);
+		FMemory::Memcpy(Data + Entries[i].SampleOffset + PaddedBytes * 2, GestureSoA.Z.GetData(), PaddedBytes);
+		FMemory::Memcpy(Data + Entries[i].NameOffset, Names[i].GetData(), Entries[i].NameLength);
+	}
+
+	return FFileHelper::SaveArrayToFile(Buffer, *FilePath);
+#endif
+}
+
+UGesturesDatabase * UGesturesDatabase::LoadCookedGestures(UObject * Outer, const FString & FilePath)
+{
+	UGesturesDatabase * CookedDB = NewObject<UGesturesDatabase>(Outer ? Outer : GetTransientPackage(), NAME_None, RF_Transient);
+	return CookedDB->ReadCookedGestures(FilePath) ? CookedDB : nullptr;
+}
+
+bool UGesturesDatabase::ReadCookedGestures(const FString & FilePath)
+{
+	using namespace VRGestureCookedFormat;
+
+#if !PLATFORM_LITTLE_ENDIAN
+	UE_LOG(LogVRGesture, Warning, TEXT("Cooked gesture databases are only supported on little endian platforms"));
+	return false;
+#else
+
+	TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath));
+	if (!FileHandle.IsValid())
+	{
+		UE_LOG(LogVRGesture, Warning, TEXT("Failed to open cooked gesture database %s"), *FilePath);
+		return false;
+	}
+
+	int64 FileSize = FileHandle->Size();
+	if (FileSize < (int64)sizeof(FHeader) || FileSize > MAX_int32)
+	{
+		UE_LOG(LogVRGesture, Warning, TEXT("Cooked gesture database %s has an invalid size"), *FilePath);
+		return false;
+	}
+
+	// One bulk read into an aligned buffer, the sample blocks are copied straight out of it
+	TArray<uint8, TAlignedHeapAllocator<SampleAlignment>> Buffer;
+	Buffer.SetNumUninitialized((int32)FileSize);
+	if (!FileHandle->Read(Buffer.GetData(), FileSize))
+	{
+		UE_LOG(LogVRGesture, Warning, TEXT("Failed to read cooked gesture database %s"), *FilePath);
+		return false;
+	}
+
+	const uint8 * Data = Buffer.GetData();
+	const FHeader & Header = *reinterpret_cast<const FHeader*>(Data);
+
+	if (Header.Magic != Magic || Header.Version != Version || Header.TotalSize != FileSize ||
+		!IsRangeValid(Header.EntriesOffset, (uint64)sizeof(FGestureEntry) * Header.GestureCount, FileSize) ||
+		!IsRangeValid(Header.TypeRangesOffset, (uint64)sizeof(FTypeRange) * Header.TypeRangeCount, FileSize) ||
+		!IsRangeValid(Header.TypeIndicesOffset, (uint64)sizeof(uint32) * Header.GestureCount, FileSize) ||
+		(Header.SamplesOffset % SampleAlignment) != 0 ||
+		!FMath::IsFinite(Header.TargetGestureScale) || Header.TargetGestureScale <= 0.f)
+	{
+		UE_LOG(LogVRGesture, Warning, TEXT("Cooked gesture database %s is corrupt or from a different version"), *FilePath);
+		return false;
+	}
+
+	const FGestureEntry * Entries = reinterpret_cast<const FGestureEntry*>(Data + Header.EntriesOffset);
+	const FTypeRange * TypeRanges = reinterpret_cast<const FTypeRange*>(Data + Header.TypeRangesOffset);
+	const uint32 * TypeIndices = reinterpret_cast<const uint32*>(Data + Header.TypeIndicesOffset);
+
+	for (uint32 i = 0; i < Header.GestureCount; ++i)
+	{
+		// Has to be checked before the count goes anywhere near GetPaddedCount
+		if (Entries[i].SampleCount > MaxSampleCount)
+		{
+			UE_LOG(LogVRGesture, Warning, TEXT("Cooked gesture database %s has an invalid sample count on entry %u"), *FilePath, i);
+			return false;
+		}
+
+		uint64 PaddedBytes = (uint64)FVRGestureSampleSoA::GetPaddedCount((int)Entries[i].SampleCount) * sizeof(float);
+		if ((Entries[i].SampleOffset % SampleAlignment) != 0 ||
+			!IsRangeValid(Entries[i].SampleOffset, PaddedBytes * 3, FileSize) ||
+			!IsRangeValid(Entries[i].NameOffset, Entries[i].NameLength, FileSize) ||
+			Entries[i].MirrorMode > (uint8)EVRGestureMirrorMode::GES_MirrorBoth)
+		{
+			UE_LOG(LogVRGesture, Warning, TEXT("Cooked gesture database %s has an invalid entry %u"), *FilePath, i);
+			return false;
+		}
+
+		// NaN or Inf in a template would poison every distance it is matched against
+		bool bFinite = FMath::IsFinite(Entries[i].FirstThreshold) && FMath::IsFinite(Entries[i].FullThreshold);
+		for (int Axis = 0; Axis < 3 && bFinite; ++Axis)
+		{
+			bFinite = FMath::IsFinite(Entries[i].BoundsMin[Axis]) && FMath::IsFinite(Entries[i].BoundsMax[Axis]);
+		}
+
+		const float * SampleData = reinterpret_cast<const float*>(Data + Entries[i].SampleOffset);
+		int PaddedCount = FVRGestureSampleSoA::GetPaddedCount((int)Entries[i].SampleCount);
+		for (int Axis = 0; Axis < 3 && bFinite; ++Axis)
+		{
+			const float * AxisData = SampleData + PaddedCount * Axis;
+			for (uint32 j = 0; j < Entries[i].SampleCount && bFinite; ++j)
+			{
+				bFinite = FMath::IsFinite(AxisData[j]);
+			}
+		}
+
+		if (!bFinite)
+		{
+			UE_LOG(LogVRGesture, Warning, TEXT("Cooked gesture database %s has non finite values on entry %u"), *FilePath, i);
+			return false;
+		}
+	}
+
+	Gestures.Reset(Header.GestureCount);
+	Gestures.AddDefaulted(Header.GestureCount);
+	SampleCache.Reset(Header.GestureCount);
+	SampleCache.AddDefaulted(Header.GestureCount);
+	TargetGestureScale = Header.TargetGestureScale;
+
+	for (uint32 i = 0; i < Header.GestureCount; ++i)
+	{
+		const FGestureEntry & Entry = Entries[i];
+		FVRGesture & Gesture = Gestures[i];
+		FVRGestureSampleSoA & GestureSoA = SampleCache[i];
+
+		int PaddedCount = FVRGestureSampleSoA::GetPaddedCount(Entry.SampleCount);
+		const float * XData = reinterpret_cast<const float*>(Data + Entry.SampleOffset);
+		const float * YData = XData + PaddedCount;
+		const float * ZData = YData + PaddedCount;
+
+		GestureSoA.SampleCount = Entry.SampleCount;
+		GestureSoA.X.SetNumUninitialized(PaddedCount);
+		GestureSoA.Y.SetNumUninitialized(PaddedCount);
+		GestureSoA.Z.SetNumUninitialized(PaddedCount);
+		FMemory::Memcpy(GestureSoA.X.GetData(), XData, PaddedCount * sizeof(float));
+		FMemory::Memcpy(GestureSoA.Y.GetData(), YData, PaddedCount * sizeof(float));
+		FMemory::Memcpy(GestureSoA.Z.GetData(), ZData, PaddedCount * sizeof(float));
+
+		Gesture.Samples.SetNumUninitialized(Entry.SampleCount);
+		for (uint32 j = 0; j < Entry.SampleCount; ++j)
+		{
+			Gesture.Samples[j] = FVector(XData[j], YData[j], ZData[j]);
+		}
+		GestureSoA.SampleHash = FVRGestureSampleSoA::HashSamples(Gesture.Samples);
+
+		FUTF8ToTCHAR NameConverter(reinterpret_cast<const ANSICHAR*>(Data + Entry.NameOffset), Entry.NameLength);
+		Gesture.Name = FString(NameConverter.Length(), NameConverter.Get());
+		Gesture.GestureType = Entry.GestureType;
+		Gesture.GestureSize = FBox(FVector(Entry.BoundsMin[0], Entry.BoundsMin[1], Entry.BoundsMin[2]), FVector(Entry.BoundsMax[0], Entry.BoundsMax[1], Entry.BoundsMax[2]));
+		Gesture.GestureSettings.Minimum_Gesture_Length = Entry.MinimumGestureLength;
+		Gesture.GestureSettings.firstThreshold = Entry.FirstThreshold;
+		Gesture.GestureSettings.FullThreshold = Entry.FullThreshold;
+		Gesture.GestureSettings.MirrorMode = (EVRGestureMirrorMode)Entry.MirrorMode;
+		Gesture.GestureSettings.bEnabled = Entry.bEnabled != 0;
+		Gesture.GestureSettings.bUseFastDTW = Entry.bUseFastDTW != 0;
+		Gesture.GestureSettings.FastDTWRadius = Entry.FastDTWRadius;
+	}
+
+	// Filled straight from the file, it is current for the gestures we just loaded
+	SampleCacheRevision = ++GestureRevision;
+
+	GestureTypeIndex.Reset();
+	for (uint32 i = 0; i < Header.TypeRangeCount; ++i)
+	{
+		TArray<int> & TypeGestures = GestureTypeIndex.FindOrAdd((uint8)TypeRanges[i].GestureType);
+		for (uint32 j = TypeRanges[i].FirstIndex; j < TypeRanges[i].FirstIndex + TypeRanges[i].Count && j < Header.GestureCount; ++j)
+		{
+			if (TypeIndices[j] < Header.GestureCount)
+				TypeGestures.Add(TypeIndices[j]);
+		}
+	}
+
+	return true;
+#endif
+}
+
+void UGesturesDatabase::PostLoad()
+{
+	Super::PostLoad();
+	RebuildSampleCache();
+}
+
+#if WITH_EDITOR
+void UGesturesDatabase::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	RebuildSampleCache();
+}
+#endif
+
+void UGesturesDatabase::FillSplineWithGesture(FVRGesture &Gesture, USplineComponent * SplineComponent, bool bCenterPointsOnSpline, bool bScaleToBounds, float OptionalBounds, bool bUseCurvedPoints, bool bFillInSplineMeshComponents, UStaticMesh * Mesh, UMaterial * MeshMat)
+{
+	if (!SplineComponent || Gesture.Samples.Num() < 2)
+		return;
+
+	UWorld* InWorld = GEngine->GetWorldFromContextObject(SplineComponent, EGetWorldErrorMode::LogAndReturnNull);
+
+	if (!InWorld)
+		return;
+
+	SplineComponent->ClearSplinePoints(false);
+
+	FVector PointOffset = FVector::ZeroVector;
+	float Scaler = 1.0f;
+	if (bScaleToBounds && OptionalBounds > 0.0f)
+	{
+		Scaler = OptionalBounds / Gesture.GestureSize.GetSize().GetMax();
+	}
+
+	if (bCenterPointsOnSpline)
+	{
+		PointOffset = -Gesture.GestureSize.GetCenter();
+	}
+
+	int curIndex = 0;
+	for (int i = Gesture.Samples.Num() - 1; i >= 0; --i)
+	{
+		SplineComponent->AddSplinePoint((Gesture.Samples[i] + PointOffset) * Scaler, ESplineCoordinateSpace::Local, false);
+		curIndex++;
+		SplineComponent->SetSplinePointType(curIndex, bUseCurvedPoints ? ESplinePointType::Curve : ESplinePointType::Linear, false);
+	}
+
+	// Update spline now
+	SplineComponent->UpdateSpline();
+
+	if (bFillInSplineMeshComponents && Mesh != nullptr && MeshMat != nullptr)
+	{
+		TArray<USplineMeshComponent *> CurrentSplineChildren;
+		
+		TArray<USceneComponent*> Children;
+		SplineComponent->GetChildrenComponents(false, Children);
+		for (auto Child : Children)
+		{
+			USplineMeshComponent* SplineMesh = Cast<USplineMeshComponent>(Child);
+			if (SplineMesh != nullptr && !SplineMesh->IsPendingKill())
+			{
+				CurrentSplineChildren.Add(SplineMesh);
+			}
+		}
+
+		if (CurrentSplineChildren.Num() > SplineComponent->GetNumberOfSplinePoints() - 1)
+		{
+			int diff = CurrentSplineChildren.Num() - (CurrentSplineChildren.Num() - (SplineComponent->GetNumberOfSplinePoints() -1));
+
+			for (int i = CurrentSplineChildren.Num()- 1; i >= diff; --i)
+			{
+				if (!CurrentSplineChildren[i]->IsBeingDestroyed())
+				{
+					CurrentSplineChildren[i]->SetVisibility(false);
+					CurrentSplineChildren[i]->Modify();
+					CurrentSplineChildren[i]->DestroyComponent();
+					CurrentSplineChildren.RemoveAt(i);
+				}
+			}
+		}
+		else
+		{
+			for (int i = CurrentSplineChildren.Num(); i < SplineComponent->GetNumberOfSplinePoints() -1; ++i)
+			{
+				USplineMeshComponent * newSplineMesh = NewObject<USplineMeshComponent>(SplineComponent);
+
+				newSplineMesh->RegisterComponentWithWorld(InWorld);
+				newSplineMesh->SetMobility(EComponentMobility::Movable);
+				CurrentSplineChildren.Add(newSplineMesh);
+				newSplineMesh->SetStaticMesh(Mesh);
+				newSplineMesh->SetMaterial(0, MeshMat);
+				newSplineMesh->AttachToComponent(SplineComponent, FAttachmentTransformRules::SnapToTargetIncludingScale);
+				newSplineMesh->SetVisibility(true);
+			}
+		}
+
+
+		for(int i=0; i<SplineComponent->GetNumberOfSplinePoints() - 1; i++)
+		{
+			CurrentSplineChildren[i]->SetStartAndEnd(SplineComponent->GetLocationAtSplinePoint(i, ESplineCoordinateSpace::Local),
+				SplineComponent->GetTangentAtSplinePoint(i, ESplineCoordinateSpace::Local),
+				SplineComponent->GetLocationAtSplinePoint(i + 1, ESplineCoordinateSpace::Local),
+				SplineComponent->GetTangentAtSplinePoint(i + 1, ESplineCoordinateSpace::Local),
+				true);
+		}
+	}
+
+}
+
+void FVRGestureSplineDraw::Init(USceneComponent * Owner, int Capacity, UStaticMesh * Mesh, UMaterialInterface * Material, USceneComponent * AttachParent, const FTransform & MeshTransform)
+{
+	if (Owner == nullptr)
+		return;
+
+	// Only drawn segments are ever visible, hiding those hides the whole pool and restarts the slots from zero
+	Reset();
+	RingSize = 0;
+
+	// Fill in anything that was destroyed out from under us
+	for (int i = SplineMeshes.Num() - 1; i >= 0; --i)
+	{
+		if (SplineMeshes[i] == nullptr || SplineMeshes[i]->IsPendingKill())
+			SplineMeshes.RemoveAtSwap(i, 1, false);
+	}
+
+	while (SplineMeshes.Num() < Capacity)
+	{
+		USplineMeshComponent * MeshComp = NewObject<USplineMeshComponent>(Owner);
+		MeshComp->RegisterComponentWithWorld(Owner->GetWorld());
+		MeshComp->SetMobility(EComponentMobility::Movable);
+		MeshComp->SetVisibility(false);
+		SplineMeshes.Add(MeshComp);
+	}
+
+	RingSize = FMath::Max(Capacity, 0);
+
+	for (USplineMeshComponent * MeshComp : SplineMeshes)
+	{
+		// Both early out if nothing changed
+		MeshComp->SetStaticMesh(Mesh);
+		MeshComp->SetMaterial(0, Material);
+
+		if (AttachParent != nullptr)
+		{
+			if (MeshComp->GetAttachParent() != AttachParent)
+				MeshComp->AttachToComponent(AttachParent, FAttachmentTransformRules::KeepRelativeTransform);
+
+			MeshComp->SetRelativeLocationAndRotation(MeshTransform.GetLocation(), MeshTransform.GetRotation());
+		}
+		else
+		{
+			if (MeshComp->GetAttachParent() != nullptr)
+				MeshComp->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+
+			MeshComp->SetWorldLocationAndRotation(MeshTransform.GetLocation(), MeshTransform.GetRotation());
+		}
+	}
+}
+
+USplineMeshComponent * FVRGestureSplineDraw::AddPoint(const FVector & NewPoint, bool bCurved)
+{
+	if (RingSize < 1)
+		return nullptr;
+
+	if (DrawnCount >= RingSize)
+		ClearLastPoint();
+
+	// The tangent a spline gives its end point, the direction in from the last sample
+	FVector NewTangent = DrawnCount > 0 ? NewPoint - LastPoint : FVector::ZeroVector;
+
+	// Finish the previous segment at the new sample
+	if (DrawnCount > 0)
+	{
+		USplineMeshComponent * PreviousMesh = SplineMeshes[(HeadIndex + DrawnCount - 1) % RingSize];
+		if (PreviousMesh != nullptr)
+		{
+			if (bCurved)
+			{
+				PreviousMesh->SetEndPosition(NewPoint, false);
+				PreviousMesh->SetEndTangent(NewTangent, true);
+			}
+			else
+			{
+				PreviousMesh->SetStartAndEnd(LastPoint, NewTangent, NewPoint, NewTangent, true);
+			}
+		}
+	}
+
+	// The newest segment stays collapsed onto its sample until the next one comes in
+	USplineMeshComponent * MeshComp = SplineMeshes[(HeadIndex + DrawnCount) % RingSize];
+	if (MeshComp != nullptr)
+	{
+		MeshComp->SetStartAndEnd(NewPoint, NewTangent, NewPoint, FVector::ZeroVector, true);
+		MeshComp->SetVisibility(true);
+	}
+
+	DrawnCount++;
+	LastPoint = NewPoint;
+	return MeshComp;
+}
+
+void UVRGestureComponent::BeginRecording(bool bRunDetection, bool bFlattenGesture, bool bDrawGesture, bool bDrawAsSpline, int SamplingHTZ, int SampleBufferSize, float ClampingTolerance)
+{
+	RecordingBufferSize = SampleBufferSize;
+	RecordingDelta = 1.0f / SamplingHTZ;
+	RecordingClampingTolerance = ClampingTolerance;
+	bDrawRecordingGesture = bDrawGesture;
+	bDrawRecordingGestureAsSpline = bDrawAsSpline;
+	bRecordingFlattenGesture = bFlattenGesture;
+	GestureLog.GestureSize.Init();
+
+	// Reset does the reserve already
+	GestureLog.Samples.Reset(RecordingBufferSize);
+
+	CurrentState = bRunDetection ? EVRGestureState::GES_Detecting : EVRGestureState::GES_Recording;
+
+	// Any previous detector finishes against its own copy and is thrown away
+	AsyncDetector.Reset();
+	if (bRunDetection && bDetectGesturesAsync && GesturesDB != nullptr)
+	{
+		AsyncDetector = MakeShared<FVRGestureAsyncDetector, ESPMode::ThreadSafe>(GesturesDB, maxSlope, MirroringHand, bScoreGesturesInParallel, RecordingBufferSize, bVerifyGesturesOnServer);
+	}
+
+	if (TargetCharacter != nullptr)
+	{
+		OriginatingTransform = TargetCharacter->OffsetComponentToWorld;
+	}
+	else if (AVRBaseCharacter * own = Cast<AVRBaseCharacter>(GetOwner()))
+	{
+		TargetCharacter = own;
+		OriginatingTransform = TargetCharacter->OffsetComponentToWorld;
+	}
+	else
+		OriginatingTransform = this->GetComponentTransform();
+
+	StartVector = OriginatingTransform.InverseTransformPosition(this->GetComponentLocation());
+
+	// Reinit the drawing pool
+	if (!bDrawAsSpline || !bDrawGesture || SplineMesh == nullptr || SplineMaterial == nullptr)
+		RecordingGestureDraw.Clear(); // Not drawing or not as a spline, remove the components if they exist
+	else
+	{
+		// Otherwise hide what was drawn and make sure there is a mesh for every sample in the buffer, all component registration happens here
+		RecordingGestureDraw.Reset();
+
+		if (bGetGestureInWorldSpace || !TargetCharacter)
+			RecordingGestureDraw.Init(this, RecordingBufferSize, SplineMesh, SplineMaterial, nullptr, FTransform(OriginatingTransform.GetRotation(), OriginatingTransform.TransformPosition(StartVector)));
+		else
+			RecordingGestureDraw.Init(this, RecordingBufferSize, SplineMesh, SplineMaterial, TargetCharacter->GetRootComponent(), FTransform(StartVector));
+	}
+
+	this->SetComponentTickEnabled(true);
+
+	if (!TickGestureTimer_Handle.IsValid())
+		GetWorld()->GetTimerManager().SetTimer(TickGestureTimer_Handle, this, &UVRGestureComponent::TickGesture, RecordingDelta, true);
+}
+
+void UVRGestureComponent::CaptureGestureFrame()
+{
+	FVector NewSample = OriginatingTransform.InverseTransformPosition(this->GetComponentLocation()) - StartVector;
+
+	if (bRecordingFlattenGesture)
+		NewSample.X = 0;
+
+	if (RecordingClampingTolerance > 0.0f)
+	{
+		NewSample.X = FMath::GridSnap(NewSample.X, RecordingClampingTolerance);
+		NewSample.Y = FMath::GridSnap(NewSample.Y, RecordingClampingTolerance);
+		NewSample.Z = FMath::GridSnap(NewSample.Z, RecordingClampingTolerance);
+	}
+
+	// Add in newest sample at beginning (reverse order)
+	if (NewSample != FVector::ZeroVector && (GestureLog.Samples.Num() < 1 || !GestureLog.Samples[0].Equals(NewSample, SameSampleTolerance)))
+	{
+		// Pop off oldest sample
+		if (GestureLog.Samples.Num() >= RecordingBufferSize)
+		{
+			GestureLog.Samples.Pop(false);
+		}
+		
+		GestureLog.GestureSize.Max.X = FMath::Max(NewSample.X, GestureLog.GestureSize.Max.X);
+		GestureLog.GestureSize.Max.Y = FMath::Max(NewSample.Y, GestureLog.GestureSize.Max.Y);
+		GestureLog.GestureSize.Max.Z = FMath::Max(NewSample.Z, GestureLog.GestureSize.Max.Z);
+
+		GestureLog.GestureSize.Min.X = FMath::Min(NewSample.X, GestureLog.GestureSize.Min.X);
+		GestureLog.GestureSize.Min.Y = FMath::Min(NewSample.Y, GestureLog.GestureSize.Min.Y);
+		GestureLog.GestureSize.Min.Z = FMath::Min(NewSample.Z, GestureLog.GestureSize.Min.Z);
+
+		// The pool is sized to the buffer, so the ring drops its oldest segment at the same time that the log pops its oldest sample
+		if (bDrawRecordingGesture && bDrawRecordingGestureAsSpline)
+		{
+			RecordingGestureDraw.AddPoint(NewSample, bDrawSplinesCurved);
+		}
+
+		GestureLog.Samples.Insert(NewSample, 0);
+		bGestureChanged = true;
+	}
+}
+
+void UVRGestureComponent::TickGesture()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TickGesture);
+
+	switch (CurrentState)
+	{
+	case EVRGestureState::GES_Detecting:
+	{
+		CaptureGestureFrame();
+
+		if (AsyncDetector.IsValid())
+			TickAsyncDetection();
+		else
+			RecognizeGesture(GestureLog);
+
+		bGestureChanged = false;
+	}break;
+
+	case EVRGestureState::GES_Recording:
+	{
+		CaptureGestureFrame();
+	}break;
+
+	case EVRGestureState::GES_None:
+	default: {}break;
+	}
+
+	if (bDrawRecordingGesture)
+	{
+		if (!bDrawRecordingGestureAsSpline)
+		{
+			FTransform DrawTransform = FTransform(StartVector) * OriginatingTransform;
+			// Setting the lifetime to the recording htz now, should remove the flicker.
+			DrawDebugGesture(this, DrawTransform, GestureLog, FColor::White, false, 0, RecordingDelta, 0.0f);
+		}
+	}
+}
+
+void UVRGestureComponent::ClearRecording()
+{
+	GestureLog.Samples.Reset(RecordingBufferSize);
+
+	if (AsyncDetector.IsValid())
+	{
+		AsyncDetector->PendingSamples.Enqueue(FVRGestureAsyncSample(FVector::ZeroVector, true));
+		AsyncDetector->bSamplesPendingDispatch = true;
+	}
+}
+
+void UVRGestureComponent::TickAsyncDetection()
+{
+	// Hold onto the detector, a broadcast can end or restart the recording
+	TSharedPtr<FVRGestureAsyncDetector, ESPMode::ThreadSafe> Detector = AsyncDetector;
+
+	if (bGestureChanged && GestureLog.Samples.Num() > 0)
+	{
+		Detector->PendingSamples.Enqueue(FVRGestureAsyncSample(GestureLog.Samples[0], false));
+		Detector->bSamplesPendingDispatch = true;
+	}
+
+	// Only one worker at a time per detector, anything queued while one is running goes out with the next one
+	if (Detector->bSamplesPendingDispatch && (!Detector->DetectionTask.IsValid() || Detector->DetectionTask->IsComplete()))
+	{
+		Detector->bSamplesPendingDispatch = false;
+		Detector->DetectionTask = FFunctionGraphTask::CreateAndDispatchWhenReady([Detector]()
+		{
+			Detector->ProcessPendingSamples();
+		}, GET_STATID(STAT_GestureAsyncDetection), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask);
+	}
+
+	FVRGestureAsyncDetection Detection;
+	while (Detector->DetectedGestures.Dequeue(Detection))
+	{
+		// The worker reset its log when it made the detection and has possibly taken samples since, queueing another clear would drop them
+		BroadcastGestureDetected(Detection.GestureIndex, Detection.DetectedLog, false);
+
+		if (AsyncDetector != Detector)
+			break;
+	}
+}
+
+void UVRGestureComponent::RecognizeGesture(const FVRGesture & inputGesture)
+{
+	if (!GesturesDB || inputGesture.Samples.Num() < 1 || !bGestureChanged)
+		return;
+
+	GestureMatcher.maxSlope = maxSlope;
+	GestureMatcher.MirroringHand = MirroringHand;
+	GestureMatcher.bParallelScoring = bScoreGesturesInParallel;
+
+	int OutGestureIndex = GestureMatcher.FindBestMatch(inputGesture, GesturesDB->Gestures, GesturesDB->TargetGestureScale, &GesturesDB->EnsureSampleCache());
+
+	if (/*minDist < FMath::Square(globalThreshold) && */OutGestureIndex != -1)
+	{
+		BroadcastGestureDetected(OutGestureIndex, inputGesture);
+	}
+}
+
+void UVRGestureComponent::BroadcastGestureDetected(int GestureIndex, const FVRGesture & DetectedLog, bool bClearAsyncDetector)
+{
+	if (!GesturesDB || !GesturesDB->Gestures.IsValidIndex(GestureIndex))
+		return;
+
+	// Has to go out before the broadcast, the log is cleared afterwards and the handlers are free to end the recording
+	SendGestureForVerification(GestureIndex, DetectedLog);
+
+	OnGestureDetected(GesturesDB->Gestures[GestureIndex].GestureType, /*minDist,*/ GesturesDB->Gestures[GestureIndex].Name, GestureIndex, GesturesDB);
+	OnGestureDetected_Bind.Broadcast(GesturesDB->Gestures[GestureIndex].GestureType, /*minDist,*/ GesturesDB->Gestures[GestureIndex].Name, GestureIndex, GesturesDB);
+
+	// Clear the recording out, we don't want to detect this gesture again with the same data
+	if (bClearAsyncDetector)
+		ClearRecording();
+	else
+		GestureLog.Samples.Reset(RecordingBufferSize);
+
+	RecordingGestureDraw.Reset();
+}
+
+float UVRGestureComponent::dtw(const FVRGesture & seq1, const FVRGesture & seq2, bool bMirrorGesture, float Scaler)
+{
+	GestureMatcher.maxSlope = maxSlope;
+	GestureMatcher.MirroringHand = MirroringHand;
+	return GestureMatcher.dtw(seq1, seq2, bMirrorGesture, Scaler);
+}
+
+void UVRGestureComponent::SendGestureForVerification(int GestureIndex, const FVRGesture & DetectedLog)
+{
+	if (!bVerifyGesturesOnServer || GetNetMode() != ENetMode::NM_Client || DetectedLog.Samples.Num() < 1)
+		return;
+
+	// The server would only see a truncated log and reject it anyway
+	if (DetectedLog.Samples.Num() > FVRGestureSampleRep::MaxSamples)
+	{
+		UE_LOG(LogVRGesture, Warning, TEXT("Gesture %d was detected on a log of %d samples, more than the %d that can be verified, not sending it"),
+			GestureIndex, DetectedLog.Samples.Num(), FVRGestureSampleRep::MaxSamples);
+		return;
+	}
+
+	APawn * OwningPawn = Cast<APawn>(GetOwner());
+	if (OwningPawn == nullptr || !OwningPawn->IsLocallyControlled())
+		return;
+
+	FVRGestureSampleRep GestureSamples;
+	GestureSamples.SetFromGesture(DetectedLog);
+
+	// Measure what the RPC parameter costs on the wire, only done when a detection fires
+	FNetBitWriter BitWriter(nullptr, 8192);
+	bool bSerializedOk = true;
+	GestureSamples.NetSerialize(BitWriter, nullptr, bSerializedOk);
+
+	LastVerificationBits = (int)BitWriter.GetNumBits();
+	TotalVerificationBits += LastVerificationBits;
+	VerificationCount++;
+	INC_DWORD_STAT_BY(STAT_GestureVerificationBits, LastVerificationBits);
+
+	UE_LOG(LogVRGesture, Verbose, TEXT("Sending gesture %d for verification: %d samples in %d bits (%.2f bits per sample), average %.1f bits per verification"),
+		GestureIndex, GestureSamples.Samples.Num(), LastVerificationBits,
+		(float)LastVerificationBits / GestureSamples.Samples.Num(),
+		(float)TotalVerificationBits / VerificationCount);
+
+	Server_VerifyGesture(GestureIndex, GestureSamples);
+}
+
+bool UVRGestureComponent::Server_VerifyGesture_Validate(int GestureIndex, const FVRGestureSampleRep & GestureSamples)
+{
+	return GestureSamples.Samples.Num() <= FVRGestureSampleRep::MaxSamples;
+}
+
+void UVRGestureComponent::Server_VerifyGesture_Implementation(int GestureIndex, const FVRGestureSampleRep & GestureSamples)
+{
+	bool bVerified = VerifyGesture(GestureIndex, GestureSamples);
+
+	BroadcastGestureVerified(GestureIndex, bVerified);
+	Client_GestureVerified(GestureIndex, bVerified);
+}
+
+void UVRGestureComponent::Client_GestureVerified_Implementation(int GestureIndex, bool bVerified)
+{
+	BroadcastGestureVerified(GestureIndex, bVerified);
+}
+
+bool UVRGestureComponent::VerifyGesture(int GestureIndex, const FVRGestureSampleRep & GestureSamples)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GestureVerification);
+
+	if (!GesturesDB || !GesturesDB->Gestures.IsValidIndex(GestureIndex))
+		return false;
+
+	FVRGesture InputGesture;
+	if (!GestureSamples.ToGesture(InputGesture))
+		return false;
+
+	// Too small to scale back up reliably through the quantization
+	float SizeMax = InputGesture.GestureSize.GetSize().GetMax();
+	if (SizeMax <= 0.02f)
+		return false;
+
+	// The client matched its unquantized log, widen the thresholds by how far the quantization can have moved any scaled sample.
+	// Each sample is off by at most MaxQuantizationError, and the size by at most the 0.02 ToGesture allows, which changes the scaler
+	// and moves every sample in proportion to its distance from the origin. Thresholds are on distances so the slack adds before squaring.
+	float Scaler = GesturesDB->TargetGestureScale / SizeMax;
+	float ScalerError = GesturesDB->TargetGestureScale / (SizeMax - 0.02f) - Scaler;
+	float MaxSampleSize = 0.f;
+	for (const FVector & Sample : InputGesture.Samples)
+	{
+		MaxSampleSize = FMath::Max(MaxSampleSize, Sample.Size());
+	}
+
+	// Uses the servers own settings, nothing but the samples is taken from the client
+	GestureMatcher.maxSlope = maxSlope;
+	GestureMatcher.MirroringHand = MirroringHand;
+	GestureMatcher.bParallelScoring = bScoreGesturesInParallel;
+	GestureMatcher.ThresholdSlack = FVRGestureSampleRep::MaxQuantizationError * Scaler + ScalerError * MaxSampleSize;
+
+	int ServerGestureIndex = GestureMatcher.FindBestMatch(InputGesture, GesturesDB->Gestures, GesturesDB->TargetGestureScale, &GesturesDB->EnsureSampleCache());
+	GestureMatcher.ThresholdSlack = 0.f;
+
+	if (ServerGestureIndex != GestureIndex)
+	{
+		UE_LOG(LogVRGesture, Log, TEXT("Rejected gesture %d from %s, server matched %d"), GestureIndex, *GetNameSafe(GetOwner()), ServerGestureIndex);
+		return false;
+	}
+
+	return true;
+}
+
+void UVRGestureComponent::BroadcastGestureVerified(int GestureIndex, bool bVerified)
+{
+	if (!GesturesDB || !GesturesDB->Gestures.IsValidIndex(GestureIndex))
+	{
+		OnGestureVerified_Bind.Broadcast(false, 0, FString(), GestureIndex, GesturesDB);
+		return;
+	}
+
+	OnGestureVerified_Bind.Broadcast(bVerified, GesturesDB->Gestures[GestureIndex].GestureType, GesturesDB->Gestures[GestureIndex].Name, GestureIndex, GesturesDB);
+}
+
+int FVRGestureMatcher::FindBestMatch(const FVRGesture & inputGesture, const TArray<FVRGesture> & Gestures, float TargetGestureScale, const TArray<FVRGestureSampleSoA> * SampleCache)
+{
+	if (inputGesture.Samples.Num() < 1)
+		return INDEX_NONE;
+
+	float minDist = MAX_FLT;
+
+	int OutGestureIndex = -1;
+	bool bMirrorGesture = false;
+
+	FVector Size = inputGesture.GestureSize.GetSize();
+	float Scaler = TargetGestureScale / Size.GetMax();
+	FVector FirstInputSample = inputGesture.Samples[0] * Scaler;
+
+	if (bParallelScoring)
+		return FindBestMatchParallel(inputGesture, Gestures, Scaler, SampleCache);
+
+	// Build the envelope of the scaled input once, every gesture in the DB bounds against it
+	BuildInputEnvelope(inputGesture, Scaler);
+
+	for (int i = 0; i < Gestures.Num(); i++)
+	{
+		const FVRGesture & exampleGesture = Gestures[i];
+
+		if (!exampleGesture.GestureSettings.bEnabled || exampleGesture.Samples.Num() < 1 || inputGesture.Samples.Num() < exampleGesture.GestureSettings.Minimum_Gesture_Length)
+			continue;
+
+		const FVRGestureSampleSoA * ExampleSoA = (SampleCache != nullptr && SampleCache->IsValidIndex(i)) ? &(*SampleCache)[i] : nullptr;
+
+		bMirrorGesture = (MirroringHand != EVRGestureMirrorMode::GES_NoMirror && MirroringHand != EVRGestureMirrorMode::GES_MirrorBoth && MirroringHand == exampleGesture.GestureSettings.MirrorMode);
+
+		if (GetGestureDistance(FirstInputSample, exampleGesture.Samples[0], bMirrorGesture) < GetFirstThresholdSq(exampleGesture))
+		{
+			float Limit = FMath::Min(minDist, GetFullThresholdSq(exampleGesture));
+			if (!RejectByLowerBound(exampleGesture, bMirrorGesture, Limit))
+			{
+				float d = GetMatchCost(inputGesture, exampleGesture, bMirrorGesture, Scaler, Limit, ExampleSoA) / (exampleGesture.Samples.Num());
+				if (d < minDist && d < GetFullThresholdSq(exampleGesture))
+				{
+					minDist = d;
+					OutGestureIndex = i;
+				}
+			}
+		}
+		else if (exampleGesture.GestureSettings.MirrorMode == EVRGestureMirrorMode::GES_MirrorBoth)
+		{
+			bMirrorGesture = true;
+			if (GetGestureDistance(FirstInputSample, exampleGesture.Samples[0], bMirrorGesture) < GetFirstThresholdSq(exampleGesture))
+			{
+				float Limit = FMath::Min(minDist, GetFullThresholdSq(exampleGesture));
+				if (!RejectByLowerBound(exampleGesture, bMirrorGesture, Limit))
+				{
+					float d = GetMatchCost(inputGesture, exampleGesture, bMirrorGesture, Scaler, Limit, ExampleSoA) / (exampleGesture.Samples.Num());
+					if (d < minDist && d < GetFullThresholdSq(exampleGesture))
+					{
+						minDist = d;
+						OutGestureIndex = i;
+					}
+				}
+			}
+		}
+	}
+
+	return OutGestureIndex;
+}
+
+int FVRGestureMatcher::FindBestMatchParallel(const FVRGesture & inputGesture, const TArray<FVRGesture> & Gestures, float Scaler, const TArray<FVRGestureSampleSoA> * SampleCache)
+{
+	FVector FirstInputSample = inputGesture.Samples[0] * Scaler;
+	bool bMirrorGesture = false;
+
+	// Same candidate selection as the serial loop, each gesture is scored at most once (mirrored or not)
+	ParallelCandidates.Reset();
+	for (int i = 0; i < Gestures.Num(); i++)
+	{
+		const FVRGesture & exampleGesture = Gestures[i];
+
+		if (!exampleGesture.GestureSettings.bEnabled || exampleGesture.Samples.Num() < 1 || inputGesture.Samples.Num() < exampleGesture.GestureSettings.Minimum_Gesture_Length)
+			continue;
+
+		bMirrorGesture = (MirroringHand != EVRGestureMirrorMode::GES_NoMirror && MirroringHand != EVRGestureMirrorMode::GES_MirrorBoth && MirroringHand == exampleGesture.GestureSettings.MirrorMode);
+
+		if (GetGestureDistance(FirstInputSample, exampleGesture.Samples[0], bMirrorGesture) < GetFirstThresholdSq(exampleGesture))
+		{
+			ParallelCandidates.Add(bMirrorGesture ? ~i : i);
+		}
+		else if (exampleGesture.GestureSettings.MirrorMode == EVRGestureMirrorMode::GES_MirrorBoth &&
+			GetGestureDistance(FirstInputSample, exampleGesture.Samples[0], true) < GetFirstThresholdSq(exampleGesture))
+		{
+			ParallelCandidates.Add(~i);
+		}
+	}
+
+	int CandidateCount = ParallelCandidates.Num();
+	if (CandidateCount < 1)
+		return INDEX_NONE;
+
+	ParallelCosts.SetNumUninitialized(CandidateCount, false);
+	ParallelRejected.SetNumUninitialized(CandidateCount, false);
+
+	// One batch per worker, each with its own scratch, striding the candidates to spread out the long gestures
+	int BatchCount = FMath::Min(CandidateCount, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+	if (ParallelMatchers.Num() < BatchCount)
+		ParallelMatchers.SetNum(BatchCount);
+
+	ParallelFor(BatchCount, [&](int32 BatchIndex)
+	{
+		FVRGestureMatcher & BatchMatcher = ParallelMatchers[BatchIndex];
+		BatchMatcher.maxSlope = maxSlope;
+		BatchMatcher.MirroringHand = MirroringHand;
+		BatchMatcher.ThresholdSlack = ThresholdSlack;
+		BatchMatcher.ResetInputEnvelope(inputGesture.Samples.Num());
+
+		for (int k = BatchIndex; k < CandidateCount; k += BatchCount)
 		{
-			for (int i = CurrentSplineChildren.Num(); i < SplineComponent->GetNumberOfSplinePoints() -1; ++i)
-			{
-				USplineMeshComponent * newSplineMesh = NewObject<USplineMeshComponent>(SplineComponent);
+			bool bMirrorCandidate = ParallelCandidates[k] < 0;
+			int GestureIndex = bMirrorCandidate ? ~ParallelCandidates[k] : ParallelCandidates[k];
+			const FVRGesture & exampleGesture = Gestures[GestureIndex];
+			const FVRGestureSampleSoA * ExampleSoA = (SampleCache != nullptr && SampleCache->IsValidIndex(GestureIndex)) ? &(*SampleCache)[GestureIndex] : nullptr;
 
-				newSplineMesh->RegisterComponentWithWorld(InWorld);
-				newSplineMesh->SetMobility(EComponentMobility::Movable);
-				CurrentSplineChildren.Add(newSplineMesh);
-				newSplineMesh->SetStaticMesh(Mesh);
-				newSplineMesh->SetMaterial(0, MeshMat);
-				newSplineMesh->AttachToComponent(SplineComponent, FAttachmentTransformRules::SnapToTargetIncludingScale);
-				newSplineMesh->SetVisibility(true);
-			}
+			// Built here on the worker, and only as far as this gesture reaches into the input
+			BatchMatcher.ExtendInputEnvelope(inputGesture, Scaler, BatchMatcher.GetDTWBandRowCount(exampleGesture.Samples.Num(), inputGesture.Samples.Num()));
+
+			// Only the gestures own threshold can be used as a limit here, the best so far depends on scheduling
+			float Limit = GetFullThresholdSq(exampleGesture);
+
+			ParallelRejected[k] = BatchMatcher.RejectByLowerBound(exampleGesture, bMirrorCandidate, Limit);
+			ParallelCosts[k] = ParallelRejected[k] ? MAX_FLT : BatchMatcher.GetMatchCost(inputGesture, exampleGesture, bMirrorCandidate, Scaler, Limit, ExampleSoA) / (exampleGesture.Samples.Num());
 		}
+	});
+
+	// Reduce in gesture order, strictly less than keeps the first index on ties just like the serial loop
+	float minDist = MAX_FLT;
+	int OutGestureIndex = -1;
 
+	for (int k = 0; k < CandidateCount; k++)
+	{
+		if (ParallelRejected[k])
+			continue;
 
-		for(int i=0; i<SplineComponent->GetNumberOfSplinePoints() - 1; i++)
+		int GestureIndex = ParallelCandidates[k] < 0 ? ~ParallelCandidates[k] : ParallelCandidates[k];
+		float d = ParallelCosts[k];
+
+		if (d < minDist && d < GetFullThresholdSq(Gestures[GestureIndex]))
 		{
-			CurrentSplineChildren[i]->SetStartAndEnd(SplineComponent->GetLocationAtSplinePoint(i, ESplineCoordinateSpace::Local),
-				SplineComponent->GetTangentAtSplinePoint(i, ESplineCoordinateSpace::Local),
-				SplineComponent->GetLocationAtSplinePoint(i + 1, ESplineCoordinateSpace::Local),
-				SplineComponent->GetTangentAtSplinePoint(i + 1, ESplineCoordinateSpace::Local),
-				true);
+			minDist = d;
+			OutGestureIndex = GestureIndex;
 		}
 	}
 
+	return OutGestureIndex;
 }
 
-void UVRGestureComponent::BeginRecording(bool bRunDetection, bool bFlattenGesture, bool bDrawGesture, bool bDrawAsSpline, int SamplingHTZ, int SampleBufferSize, float ClampingTolerance)
+float FVRGestureMatcher::GetMatchCost(const FVRGesture & inputGesture, const FVRGesture & exampleGesture, bool bMirrorGesture, float Scaler, float Limit, const FVRGestureSampleSoA * ExampleSoA)
 {
-	RecordingBufferSize = SampleBufferSize;
-	RecordingDelta = 1.0f / SamplingHTZ;
-	RecordingClampingTolerance = ClampingTolerance;
-	bDrawRecordingGesture = bDrawGesture;
-	bDrawRecordingGestureAsSpline = bDrawAsSpline;
-	bRecordingFlattenGesture = bFlattenGesture;
-	GestureLog.GestureSize.Init();
+	if (exampleGesture.GestureSettings.bUseFastDTW)
+		return fastdtw(inputGesture, exampleGesture, bMirrorGesture, Scaler, exampleGesture.GestureSettings.FastDTWRadius);
 
-	// Reinit the drawing spline
-	if (!bDrawAsSpline || !bDrawGesture)
-		RecordingGestureDraw.Clear(); // Not drawing or not as a spline, remove the components if they exist
-	else
-	{
-		RecordingGestureDraw.Reset(); // Otherwise just clear points and hide mesh components
+	return dtw(inputGesture, exampleGesture, bMirrorGesture, Scaler, Limit, ExampleSoA);
+}
 
-		if (RecordingGestureDraw.SplineComponent == nullptr)
-		{
-			RecordingGestureDraw.SplineComponent = NewObject<USplineComponent>(GetAttachParent());
-			RecordingGestureDraw.SplineComponent->RegisterComponentWithWorld(GetWorld());
-			RecordingGestureDraw.SplineComponent->SetMobility(EComponentMobility::Movable);
-			RecordingGestureDraw.SplineComponent->AttachToComponent(GetAttachParent(), FAttachmentTransformRules::KeepRelativeTransform);
-			RecordingGestureDraw.SplineComponent->ClearSplinePoints(true);
-		}
-	}
+void FVRGestureMatcher::BuildInputEnvelope(const FVRGesture & inputGesture, float Scaler)
+{
+	ResetInputEnvelope(inputGesture.Samples.Num());
+	ExtendInputEnvelope(inputGesture, Scaler, inputGesture.Samples.Num());
+}
 
-	// Reset does the reserve already
-	GestureLog.Samples.Reset(RecordingBufferSize);
+void FVRGestureMatcher::ResetInputEnvelope(int InputSampleCount)
+{
+	DTWEnvelopeMin.Reset();
+	DTWEnvelopeMax.Reset();
+	DTWEnvelopeInputCount = InputSampleCount;
+}
 
-	CurrentState = bRunDetection ? EVRGestureState::GES_Detecting : EVRGestureState::GES_Recording;
+void FVRGestureMatcher::ExtendInputEnvelope(const FVRGesture & inputGesture, float Scaler, int RowCount)
+{
+	RowCount = FMath::Min(RowCount, inputGesture.Samples.Num());
+	int FirstRow = DTWEnvelopeMin.Num();
 
-	if (TargetCharacter != nullptr)
+	if (RowCount <= FirstRow)
+		return;
+
+	DTWEnvelopeMin.SetNumUninitialized(RowCount, false);
+	DTWEnvelopeMax.SetNumUninitialized(RowCount, false);
+
+	if (FirstRow == 0)
 	{
-		OriginatingTransform = TargetCharacter->OffsetComponentToWorld;
+		DTWEnvelopeMin[0] = inputGesture.Samples[0] * Scaler;
+		DTWEnvelopeMax[0] = DTWEnvelopeMin[0];
+		FirstRow = 1;
 	}
-	else if (AVRBaseCharacter * own = Cast<AVRBaseCharacter>(GetOwner()))
+
+	for (int i = FirstRow; i < RowCount; i++)
 	{
-		TargetCharacter = own;
-		OriginatingTransform = TargetCharacter->OffsetComponentToWorld;
+		FVector ScaledSample = inputGesture.Samples[i] * Scaler;
+		DTWEnvelopeMin[i] = DTWEnvelopeMin[i - 1].ComponentMin(ScaledSample);
+		DTWEnvelopeMax[i] = DTWEnvelopeMax[i - 1].ComponentMax(ScaledSample);
 	}
-	else
-		OriginatingTransform = this->GetComponentTransform();
+}
 
-	StartVector = OriginatingTransform.InverseTransformPosition(this->GetComponentLocation());
-	this->SetComponentTickEnabled(true);
+bool FVRGestureMatcher::RejectByLowerBound(const FVRGesture & exampleGesture, bool bMirrorGesture, float Limit)
+{
+	// Every warp path in dtw() visits each example sample at least once, within the rows the band allows for that column.
+	// The distance to the input envelope over those rows is never larger than the cell it replaces, and the terms are summed
+	// in the same column order the path accumulates them, so these bounds hold exactly in float and never reject a match.
+	int SampleCount = exampleGesture.Samples.Num();
+	int InputCount = DTWEnvelopeInputCount;
+
+	if (SampleCount < 1 || InputCount < 1)
+		return false;
+
+	// Last point, the final example sample has to be matched somewhere within reach
+	int BandIndex = GetDTWBandRowCount(SampleCount, InputCount) - 1;
+	checkSlow(BandIndex < DTWEnvelopeMin.Num());
+	float LastPointCost = GetEnvelopeDistance(DTWEnvelopeMin[BandIndex], DTWEnvelopeMax[BandIndex], exampleGesture.Samples[SampleCount - 1], bMirrorGesture);
+
+	if (LastPointCost / SampleCount >= Limit)
+		return true;
+
+	// Envelope (LB_Keogh) with early abandon once the running sum passes the limit
+	float Cost = 0.f;
+	for (int j = 0; j < SampleCount; j++)
+	{
+		BandIndex = GetDTWBandRowCount(j + 1, InputCount) - 1;
+		Cost = GetEnvelopeDistance(DTWEnvelopeMin[BandIndex], DTWEnvelopeMax[BandIndex], exampleGesture.Samples[j], bMirrorGesture) + Cost;
 
-	if (!TickGestureTimer_Handle.IsValid())
-		GetWorld()->GetTimerManager().SetTimer(TickGestureTimer_Handle, this, &UVRGestureComponent::TickGesture, RecordingDelta, true);
+		if (Cost / SampleCount >= Limit)
+			return true;
+	}
+
+	return false;
 }
 
-void UVRGestureComponent::CaptureGestureFrame()
+float FVRGestureMatcher::dtw(const FVRGesture & seq1, const FVRGesture & seq2, bool bMirrorGesture, float Scaler, float AbandonAbove, const FVRGestureSampleSoA * Seq2SoA)
 {
-	FVector NewSample = OriginatingTransform.InverseTransformPosition(this->GetComponentLocation()) - StartVector;
+	// Getting number of average samples recorded over of a gesture (top down) may be able to achieve a basic % completed check
+	// to see how far into detecting a gesture we are, this would require ignoring the last position threshold though....
 
-	if (bRecordingFlattenGesture)
-		NewSample.X = 0;
+	// Every cell only references its left, upper and upper left neighbors, so instead of building the full
+	// (N+1)x(M+1) lookup and slope tables we roll two rows through persistent scratch buffers.
+	// The cell math and branch order is unchanged from the full table version so the results are identical.
 
-	if (RecordingClampingTolerance > 0.0f)
+	int RowCount = seq1.Samples.Num() + 1;
+	int ColumnCount = seq2.Samples.Num() + 1;
+
+	if (DTWLookupRows.Num() < ColumnCount * 2)
 	{
-		NewSample.X = FMath::GridSnap(NewSample.X, RecordingClampingTolerance);
-		NewSample.Y = FMath::GridSnap(NewSample.Y, RecordingClampingTolerance);
-		NewSample.Z = FMath::GridSnap(NewSample.Z, RecordingClampingTolerance);
+		DTWLookupRows.SetNumUninitialized(ColumnCount * 2);
+		DTWSlopeIRows.SetNumUninitialized(ColumnCount * 2);
+		DTWSlopeJRows.SetNumUninitialized(ColumnCount * 2);
 	}
 
-	// Add in newest sample at beginning (reverse order)
-	if (NewSample != FVector::ZeroVector && (GestureLog.Samples.Num() < 1 || !GestureLog.Samples[0].Equals(NewSample, SameSampleTolerance)))
+	float * LookupPrev = DTWLookupRows.GetData();
+	float * LookupCur = LookupPrev + ColumnCount;
+	int * SlopeIPrev = DTWSlopeIRows.GetData();
+	int * SlopeICur = SlopeIPrev + ColumnCount;
+	int * SlopeJPrev = DTWSlopeJRows.GetData();
+	int * SlopeJCur = SlopeJPrev + ColumnCount;
+
+	// Row zero, tab[0, 0] = 0 and everything else is unreachable
+	LookupPrev[0] = 0.f;
+	for (int j = 1; j < ColumnCount; j++)
 	{
-		bool bClearLatestSpline = false;
-		// Pop off oldest sample
-		if (GestureLog.Samples.Num() >= RecordingBufferSize)
-		{
-			GestureLog.Samples.Pop(false);
-			bClearLatestSpline = true;
-		}
-		
-		GestureLog.GestureSize.Max.X = FMath::Max(NewSample.X, GestureLog.GestureSize.Max.X);
-		GestureLog.GestureSize.Max.Y = FMath::Max(NewSample.Y, GestureLog.GestureSize.Max.Y);
-		GestureLog.GestureSize.Max.Z = FMath::Max(NewSample.Z, GestureLog.GestureSize.Max.Z);
+		LookupPrev[j] = MAX_FLT;
+	}
+	FMemory::Memzero(SlopeIPrev, sizeof(int) * ColumnCount);
+	FMemory::Memzero(SlopeJPrev, sizeof(int) * ColumnCount);
 
-		GestureLog.GestureSize.Min.X = FMath::Min(NewSample.X, GestureLog.GestureSize.Min.X);
-		GestureLog.GestureSize.Min.Y = FMath::Min(NewSample.Y, GestureLog.GestureSize.Min.Y);
-		GestureLog.GestureSize.Min.Z = FMath::Min(NewSample.Z, GestureLog.GestureSize.Min.Z);
+	if (Seq2SoA != nullptr && Seq2SoA->SampleCount != seq2.Samples.Num())
+		Seq2SoA = nullptr;
 
+	if (DTWRowDistances.Num() < FVRGestureSampleSoA::GetPaddedCount(seq2.Samples.Num()))
+		DTWRowDistances.SetNumUninitialized(FVRGestureSampleSoA::GetPaddedCount(seq2.Samples.Num()));
 
-		if (bDrawRecordingGesture && bDrawRecordingGestureAsSpline && SplineMesh != nullptr && SplineMaterial != nullptr)
-		{
+	float * RowDistances = DTWRowDistances.GetData();
+
+	// Find best between seq2 and an ending (postfix) of seq1.
+	// This is the last column of each row, so track it as the rows complete.
+	float bestMatch = FLT_MAX;
 
-			if (bClearLatestSpline)
-				RecordingGestureDraw.ClearLastPoint();
+	FVector ScaledSample;
+	float CellDistance = 0.f;
+	float RowMin = 0.f;
+	bool bCanAbandon = AbandonAbove < MAX_FLT;
 
-			RecordingGestureDraw.SplineComponent->AddSplinePoint(NewSample, ESplineCoordinateSpace::Local, false);
-			int SplineIndex = RecordingGestureDraw.SplineComponent->GetNumberOfSplinePoints() - 1;
-			RecordingGestureDraw.SplineComponent->SetSplinePointType(SplineIndex, bDrawSplinesCurved ? ESplinePointType::Curve : ESplinePointType::Linear, true);
+	// Dynamic computation of the DTW matrix.
+	for (int i = 1; i < RowCount; i++)
+	{
+		LookupCur[0] = MAX_FLT;
+		SlopeICur[0] = 0;
+		SlopeJCur[0] = 0;
 
-			bool bFoundEmptyMesh = false;
-			USplineMeshComponent * MeshComp = nullptr;
-			int MeshIndex = 0;
+		ScaledSample = seq1.Samples[i - 1] * Scaler;
+		RowMin = MAX_FLT;
 
-			for (int i = 0; i < RecordingGestureDraw.SplineMeshes.Num(); i++)
+		if (Seq2SoA != nullptr)
+		{
+			Seq2SoA->GetRowDistances(bMirrorGesture ? FVector(ScaledSample.X, -ScaledSample.Y, ScaledSample.Z) : ScaledSample, RowDistances);
+		}
+		else
+		{
+			for (int j = 1; j < ColumnCount; j++)
 			{
-				MeshIndex = i;
-				MeshComp = RecordingGestureDraw.SplineMeshes[i];
-				if (MeshComp == nullptr)
-				{
-					RecordingGestureDraw.SplineMeshes[i] = NewObject<USplineMeshComponent>(RecordingGestureDraw.SplineComponent);
-					MeshComp = RecordingGestureDraw.SplineMeshes[i];
-
-					MeshComp->RegisterComponentWithWorld(GetWorld());
-					MeshComp->SetMobility(EComponentMobility::Movable);
-					MeshComp->SetStaticMesh(SplineMesh);
-					MeshComp->SetMaterial(0, SplineMaterial);
-					bFoundEmptyMesh = true;
-					break;
-				}
-				else if (!MeshComp->IsVisible())
-				{
-					bFoundEmptyMesh = true;
-					break;
-				}
+				RowDistances[j - 1] = GetGestureDistance(ScaledSample, seq2.Samples[j - 1], bMirrorGesture);
 			}
+		}
+
+		for (int j = 1; j < ColumnCount; j++)
+		{
+			CellDistance = RowDistances[j - 1];
 
-			if (!bFoundEmptyMesh)
+			if (
+				LookupCur[j - 1] < LookupPrev[j - 1] &&
+				LookupCur[j - 1] < LookupPrev[j] &&
+				SlopeICur[j - 1] < maxSlope)
 			{
-				USplineMeshComponent * newSplineMesh = NewObject<USplineMeshComponent>(RecordingGestureDraw.SplineComponent);
-				MeshComp = newSplineMesh;
-				MeshComp->RegisterComponentWithWorld(GetWorld());
-				MeshComp->SetMobility(EComponentMobility::Movable);
-				RecordingGestureDraw.SplineMeshes.Add(MeshComp);
-				MeshIndex = RecordingGestureDraw.SplineMeshes.Num() - 1;
-				MeshComp->SetStaticMesh(SplineMesh);
-				MeshComp->SetMaterial(0, SplineMaterial);
-				if (!bGetGestureInWorldSpace && TargetCharacter)
-					MeshComp->AttachToComponent(TargetCharacter->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+				LookupCur[j] = CellDistance + LookupCur[j - 1];
+				SlopeICur[j] = SlopeJCur[j - 1] + 1;
+				SlopeJCur[j] = 0;
 			}
-
-			if (MeshComp != nullptr)
+			else if (
+				LookupPrev[j] < LookupPrev[j - 1] &&
+				LookupPrev[j] < LookupCur[j - 1] &&
+				SlopeJPrev[j] < maxSlope)
 			{
-				// Fill in last mesh component tangent and end pos
-				if (RecordingGestureDraw.LastIndexSet != MeshIndex && RecordingGestureDraw.SplineMeshes[RecordingGestureDraw.LastIndexSet] != nullptr)
-				{
-					RecordingGestureDraw.SplineMeshes[RecordingGestureDraw.LastIndexSet]->SetEndPosition(NewSample, false);
-					RecordingGestureDraw.SplineMeshes[RecordingGestureDraw.LastIndexSet]->SetEndTangent(RecordingGestureDraw.SplineComponent->GetTangentAtSplinePoint(SplineIndex, ESplineCoordinateSpace::Local), true);
-				}
+				LookupCur[j] = CellDistance + LookupPrev[j];
+				SlopeICur[j] = 0;
+				SlopeJCur[j] = SlopeJPrev[j] + 1;
+			}
+			else
+			{
+				LookupCur[j] = CellDistance + LookupPrev[j - 1];
+				SlopeICur[j] = 0;
+				SlopeJCur[j] = 0;
+			}
 
-				MeshComp->SetStartAndEnd(NewSample,
-					RecordingGestureDraw.SplineComponent->GetTangentAtSplinePoint(SplineIndex, ESplineCoordinateSpace::Local),
-					NewSample,
-					FVector::ZeroVector,
-					true);
+			RowMin = FMath::Min(RowMin, LookupCur[j]);
+		}
 
-				if (bGetGestureInWorldSpace)
-					MeshComp->SetWorldLocationAndRotation(OriginatingTransform.TransformPosition(StartVector), OriginatingTransform.GetRotation());
-				else
-					MeshComp->SetRelativeLocationAndRotation(/*OriginatingTransform.TransformPosition(*/StartVector/*)*/, FQuat::Identity/*OriginatingTransform.GetRotation()*/);
+		if (LookupCur[ColumnCount - 1] < bestMatch)
+			bestMatch = LookupCur[ColumnCount - 1];
 
-				RecordingGestureDraw.LastIndexSet = MeshIndex;
-				MeshComp->SetVisibility(true);
-			}
-		
-		}
+		// Costs only grow from row to row, nothing below this row can end lower than the cheapest cell in it.
+		if (RowMin >= bestMatch || (bCanAbandon && RowMin / seq2.Samples.Num() >= AbandonAbove))
+			break;
 
-		GestureLog.Samples.Insert(NewSample, 0);
-		bGestureChanged = true;
+		Swap(LookupPrev, LookupCur);
+		Swap(SlopeIPrev, SlopeICur);
+		Swap(SlopeJPrev, SlopeJCur);
 	}
+
+	return bestMatch;
 }
 
-void UVRGestureComponent::TickGesture()
+namespace VRGestureFastDTW
 {
-	SCOPE_CYCLE_COUNTER(STAT_TickGesture);
-
-	switch (CurrentState)
-	{
-	case EVRGestureState::GES_Detecting:
+	enum EWarpStep : uint8
 	{
-		CaptureGestureFrame();
-		RecognizeGesture(GestureLog);
-		bGestureChanged = false;
-	}break;
+		Step_Diagonal,
+		Step_Input,
+		Step_Example
+	};
 
-	case EVRGestureState::GES_Recording:
+	// Halves a sequence by averaging neighboring samples, an odd last sample is carried over
+	static void CoarsenSamples(const TArray<FVector> & Samples, TArray<FVector> & OutSamples)
 	{
-		CaptureGestureFrame();
-	}break;
-
-	case EVRGestureState::GES_None:
-	default: {}break;
-	}
+		OutSamples.Reset((Samples.Num() + 1) / 2);
 
-	if (bDrawRecordingGesture)
-	{
-		if (!bDrawRecordingGestureAsSpline)
+		for (int i = 0; i + 1 < Samples.Num(); i += 2)
 		{
-			FTransform DrawTransform = FTransform(StartVector) * OriginatingTransform;
-			// Setting the lifetime to the recording htz now, should remove the flicker.
-			DrawDebugGesture(this, DrawTransform, GestureLog, FColor::White, false, 0, RecordingDelta, 0.0f);
+			OutSamples.Add((Samples[i] + Samples[i + 1]) * 0.5f);
 		}
+
+		if (Samples.Num() % 2 != 0)
+			OutSamples.Add(Samples.Last());
 	}
 }
 
-void UVRGestureComponent::RecognizeGesture(FVRGesture inputGesture)
+float FVRGestureMatcher::fastdtw(const FVRGesture & seq1, const FVRGesture & seq2, bool bMirrorGesture, float Scaler, int Radius)
 {
-	if (!GesturesDB || inputGesture.Samples.Num() < 1 || !bGestureChanged)
-		return;
+	if (seq1.Samples.Num() < 1 || seq2.Samples.Num() < 1)
+		return FLT_MAX;
 
-	float minDist = MAX_FLT;
+	Radius = FMath::Max(Radius, 0);
+	const int MinimumLevelSize = Radius + 2;
 
-	int OutGestureIndex = -1;
-	bool bMirrorGesture = false;
+	// Finest level, the input is pre-scaled and mirroring is applied to it instead of the example (same distances)
+	FastDTWInputLevels.SetNum(1, false);
+	FastDTWExampleLevels.SetNum(1, false);
 
-	for (int i = 0; i < GesturesDB->Gestures.Num(); i++)
+	TArray<FVector> & FinestInput = FastDTWInputLevels[0];
+	FinestInput.Reset(seq1.Samples.Num());
+	for (const FVector & Sample : seq1.Samples)
 	{
-		FVRGesture exampleGesture = GesturesDB->Gestures[i];
+		FVector ScaledSample = Sample * Scaler;
+		if (bMirrorGesture)
+			ScaledSample.Y = -ScaledSample.Y;
 
-		if (!exampleGesture.GestureSettings.bEnabled || exampleGesture.Samples.Num() < 1 || inputGesture.Samples.Num() < exampleGesture.GestureSettings.Minimum_Gesture_Length)
-			continue;
+		FinestInput.Add(ScaledSample);
+	}
+	FastDTWExampleLevels[0] = seq2.Samples;
 
-		bMirrorGesture = (MirroringHand != EVRGestureMirrorMode::GES_NoMirror && MirroringHand != EVRGestureMirrorMode::GES_MirrorBoth && MirroringHand == exampleGesture.GestureSettings.MirrorMode);
+	int LevelCount = 1;
+	while (FastDTWInputLevels[LevelCount - 1].Num() > MinimumLevelSize && FastDTWExampleLevels[LevelCount - 1].Num() > MinimumLevelSize)
+	{
+		FastDTWInputLevels.SetNum(LevelCount + 1, false);
+		FastDTWExampleLevels.SetNum(LevelCount + 1, false);
+		VRGestureFastDTW::CoarsenSamples(FastDTWInputLevels[LevelCount - 1], FastDTWInputLevels[LevelCount]);
+		VRGestureFastDTW::CoarsenSamples(FastDTWExampleLevels[LevelCount - 1], FastDTWExampleLevels[LevelCount]);
+		LevelCount++;
+	}
 
-		FVector Size = inputGesture.GestureSize.GetSize();
-		float Scaler = GesturesDB->TargetGestureScale / Size.GetMax();
+	// Coarsest level is solved over the full table
+	int Level = LevelCount - 1;
+	int RowCount = FastDTWInputLevels[Level].Num();
+	int ColumnCount = FastDTWExampleLevels[Level].Num();
 
-		if (GetGestureDistance(inputGesture.Samples[0] * Scaler, exampleGesture.Samples[0], bMirrorGesture) < FMath::Square(exampleGesture.GestureSettings.firstThreshold))
-		{
-			float d = dtw(inputGesture, exampleGesture, bMirrorGesture, Scaler) / (exampleGesture.Samples.Num());
-			if (d < minDist && d < FMath::Square(exampleGesture.GestureSettings.FullThreshold))
-			{
-				minDist = d;
-				OutGestureIndex = i;
-			}
-		}
-		else if (exampleGesture.GestureSettings.MirrorMode == EVRGestureMirrorMode::GES_MirrorBoth)
+	FastDTWRowLo.SetNumUninitialized(RowCount + 1, false);
+	FastDTWRowHi.SetNumUninitialized(RowCount + 1, false);
+	for (int i = 1; i <= RowCount; i++)
+	{
+		FastDTWRowLo[i] = 1;
+		FastDTWRowHi[i] = ColumnCount;
+	}
+
+	float BestMatch = SolveWindowedDTW(FastDTWInputLevels[Level], FastDTWExampleLevels[Level], Level > 0);
+
+	// Then refined back up around the projected path
+	for (Level = LevelCount - 2; Level >= 0; --Level)
+	{
+		ProjectFastDTWWindow(FastDTWInputLevels[Level].Num(), FastDTWExampleLevels[Level].Num(), Radius);
+		BestMatch = SolveWindowedDTW(FastDTWInputLevels[Level], FastDTWExampleLevels[Level], Level > 0);
+	}
+
+	return BestMatch;
+}
+
+void FVRGestureMatcher::ProjectFastDTWWindow(int RowCount, int ColumnCount, int Radius)
+{
+	FastDTWRowLo.Init(ColumnCount + 1, RowCount + 1);
+	FastDTWRowHi.Init(0, RowCount + 1);
+
+	// Nothing was reachable at the coarser level, fall back to the full table
+	if (FastDTWPath.Num() < 1)
+	{
+		for (int i = 1; i <= RowCount; i++)
 		{
-			bMirrorGesture = true;
-			if (GetGestureDistance(inputGesture.Samples[0] * Scaler, exampleGesture.Samples[0], bMirrorGesture) < FMath::Square(exampleGesture.GestureSettings.firstThreshold))
-			{
-				float d = dtw(inputGesture, exampleGesture, bMirrorGesture, Scaler) / (exampleGesture.Samples.Num());
-				if (d < minDist && d < FMath::Square(exampleGesture.GestureSettings.FullThreshold))
-				{
-					minDist = d;
-					OutGestureIndex = i;
-				}
-			}
+			FastDTWRowLo[i] = 1;
+			FastDTWRowHi[i] = ColumnCount;
 		}
 
-		/*if (exampleGesture.MirrorMode == EVRGestureMirrorMode::GES_MirrorBoth)
-		{
-			bMirrorGesture = true;
+		return;
+	}
 
-			if (GetGestureDistance(inputGesture.Samples[0], exampleGesture.Samples[0], bMirrorGesture) < FMath::Square(exampleGesture.GestureSettings.firstThreshold))
-			{
-				float d = dtw(inputGesture, exampleGesture, bMirrorGesture) / (exampleGesture.Samples.Num());
-				if (d < minDist && d < FMath::Square(exampleGesture.GestureSettings.FullThreshold))
-				{
-					minDist = d;
-					OutGestureIndex = i;
-				}
-			}
-		}*/
+	// Every coarse cell covers a 2x2 block of the finer level
+	for (const FIntPoint & Cell : FastDTWPath)
+	{
+		int ColumnLo = FMath::Min(Cell.Y * 2 - 1, ColumnCount);
+		int ColumnHi = FMath::Min(Cell.Y * 2, ColumnCount);
+
+		for (int i = Cell.X * 2 - 1; i <= FMath::Min(Cell.X * 2, RowCount); i++)
+		{
+			FastDTWRowLo[i] = FMath::Min(FastDTWRowLo[i], ColumnLo);
+			FastDTWRowHi[i] = FMath::Max(FastDTWRowHi[i], ColumnHi);
+		}
 	}
 
-	if (/*minDist < FMath::Square(globalThreshold) && */OutGestureIndex != -1)
+	// Widen by the radius along both axis
+	FastDTWWidenLo.Init(ColumnCount + 1, RowCount + 1);
+	FastDTWWidenHi.Init(0, RowCount + 1);
+
+	for (int i = 1; i <= RowCount; i++)
 	{
-		OnGestureDetected(GesturesDB->Gestures[OutGestureIndex].GestureType, /*minDist,*/ GesturesDB->Gestures[OutGestureIndex].Name, OutGestureIndex, GesturesDB);
-		OnGestureDetected_Bind.Broadcast(GesturesDB->Gestures[OutGestureIndex].GestureType, /*minDist,*/ GesturesDB->Gestures[OutGestureIndex].Name, OutGestureIndex, GesturesDB);
-		ClearRecording(); // Clear the recording out, we don't want to detect this gesture again with the same data
-		RecordingGestureDraw.Reset();
+		if (FastDTWRowHi[i] < FastDTWRowLo[i])
+			continue;
+
+		int ColumnLo = FMath::Max(FastDTWRowLo[i] - Radius, 1);
+		int ColumnHi = FMath::Min(FastDTWRowHi[i] + Radius, ColumnCount);
+
+		for (int k = FMath::Max(i - Radius, 1); k <= FMath::Min(i + Radius, RowCount); k++)
+		{
+			FastDTWWidenLo[k] = FMath::Min(FastDTWWidenLo[k], ColumnLo);
+			FastDTWWidenHi[k] = FMath::Max(FastDTWWidenHi[k], ColumnHi);
+		}
 	}
+
+	Swap(FastDTWRowLo, FastDTWWidenLo);
+	Swap(FastDTWRowHi, FastDTWWidenHi);
 }
 
-float UVRGestureComponent::dtw(FVRGesture seq1, FVRGesture seq2, bool bMirrorGesture, float Scaler)
+float FVRGestureMatcher::SolveWindowedDTW(const TArray<FVector> & Input, const TArray<FVector> & Example, bool bBuildPath)
 {
+	using namespace VRGestureFastDTW;
 
-	// #TODO: Skip copying the array and reversing it in the future, we only ever use the reversed value.
-	// So pre-reverse it and keep it stored like that on init. When we do the initial sample we can check off of the first index instead of last then
-
-	// Should also be able to get SizeSquared for values and compared to squared thresholds instead of doing the full SQRT calc.
+	const int RowCount = Input.Num();
+	const int ColumnCount = Example.Num();
 
-	// Getting number of average samples recorded over of a gesture (top down) may be able to achieve a basic % completed check
-	// to see how far into detecting a gesture we are, this would require ignoring the last position threshold though....
+	// Pack the window rows back to back
+	FastDTWRowOffset.SetNumUninitialized(RowCount + 1, false);
+	int CellCount = 0;
+	for (int i = 1; i <= RowCount; i++)
+	{
+		FastDTWRowOffset[i] = CellCount;
+		if (FastDTWRowHi[i] >= FastDTWRowLo[i])
+			CellCount += FastDTWRowHi[i] - FastDTWRowLo[i] + 1;
+	}
 
-	int RowCount = seq1.Samples.Num() + 1;
-	int ColumnCount = seq2.Samples.Num() + 1;
+	FastDTWLookup.SetNumUninitialized(CellCount, false);
+	FastDTWSlopeI.SetNumUninitialized(CellCount, false);
+	FastDTWSlopeJ.SetNumUninitialized(CellCount, false);
+	FastDTWSteps.SetNumUninitialized(CellCount, false);
 
-	TArray<float> LookupTable;
-	LookupTable.AddZeroed(ColumnCount * RowCount);
+	// Cells outside of the window act like the table border, unreachable with no slope
+	auto GetCellIndex = [this](int i, int j) -> int
+	{
+		if (i < 1 || j < FastDTWRowLo[i] || j > FastDTWRowHi[i])
+			return INDEX_NONE;
 
-	TArray<int> SlopeI;
-	SlopeI.AddZeroed(ColumnCount * RowCount);
-	TArray<int> SlopeJ;
-	SlopeJ.AddZeroed(ColumnCount * RowCount);
+		return FastDTWRowOffset[i] + (j - FastDTWRowLo[i]);
+	};
 
-	for (int i = 1; i < (ColumnCount * RowCount); i++)
+	auto GetCellCost = [this](int i, int j, int CellIndex) -> float
 	{
-		LookupTable[i] = MAX_FLT;
-	}
-	// Don't need to do this, it is already handled by add zeroed
-	//tab[0, 0] = 0;
+		if (CellIndex != INDEX_NONE)
+			return FastDTWLookup[CellIndex];
 
-	int icol = 0, icolneg = 0;
+		return (i == 0 && j == 0) ? 0.f : MAX_FLT;
+	};
 
-	// Dynamic computation of the DTW matrix.
-	for (int i = 1; i < RowCount; i++)
+	float BestMatch = FLT_MAX;
+	int BestRow = INDEX_NONE;
+
+	for (int i = 1; i <= RowCount; i++)
 	{
-		for (int j = 1; j < ColumnCount; j++)
+		for (int j = FastDTWRowLo[i]; j <= FastDTWRowHi[i]; j++)
 		{
-			icol = i * ColumnCount;
-			icolneg = icol - ColumnCount;// (i - 1) * ColumnCount;
+			int CellIndex = FastDTWRowOffset[i] + (j - FastDTWRowLo[i]);
 
-			if (
-				LookupTable[icol + (j - 1)] < LookupTable[icolneg + (j - 1)] &&
-				LookupTable[icol + (j - 1)] < LookupTable[icolneg + j] &&
-				SlopeI[icol + (j - 1)] < maxSlope)
+			int LeftIndex = GetCellIndex(i, j - 1);
+			int UpIndex = GetCellIndex(i - 1, j);
+			int DiagIndex = GetCellIndex(i - 1, j - 1);
+
+			float LeftCost = GetCellCost(i, j - 1, LeftIndex);
+			float UpCost = GetCellCost(i - 1, j, UpIndex);
+			float DiagCost = GetCellCost(i - 1, j - 1, DiagIndex);
+
+			float CellDistance = FVector::DistSquared(Input[i - 1], Example[j - 1]);
+
+			// Same branch order as dtw()
+			if (LeftCost < DiagCost && LeftCost < UpCost && (LeftIndex != INDEX_NONE ? FastDTWSlopeI[LeftIndex] : 0) < maxSlope)
 			{
-				LookupTable[icol + j] = GetGestureDistance(seq1.Samples[i - 1] * Scaler, seq2.Samples[j - 1], bMirrorGesture) + LookupTable[icol + j - 1];
-				SlopeI[icol + j] = SlopeJ[icol + j - 1] + 1;
-				SlopeJ[icol + j] = 0;
+				FastDTWLookup[CellIndex] = CellDistance + LeftCost;
+				FastDTWSlopeI[CellIndex] = (LeftIndex != INDEX_NONE ? FastDTWSlopeJ[LeftIndex] : 0) + 1;
+				FastDTWSlopeJ[CellIndex] = 0;
+				FastDTWSteps[CellIndex] = Step_Example;
 			}
-			else if (
-				LookupTable[icolneg + j] < LookupTable[icolneg + j - 1] &&
-				LookupTable[icolneg + j] < LookupTable[icol + j - 1] &&
-				SlopeJ[icolneg + j] < maxSlope)
+			else if (UpCost < DiagCost && UpCost < LeftCost && (UpIndex != INDEX_NONE ? FastDTWSlopeJ[UpIndex] : 0) < maxSlope)
 			{
-				LookupTable[icol + j] = GetGestureDistance(seq1.Samples[i - 1] * Scaler, seq2.Samples[j - 1], bMirrorGesture) + LookupTable[icolneg + j];
-				SlopeI[icol + j] = 0;
-				SlopeJ[icol + j] = SlopeJ[icolneg + j] + 1;
+				FastDTWLookup[CellIndex] = CellDistance + UpCost;
+				FastDTWSlopeI[CellIndex] = 0;
+				FastDTWSlopeJ[CellIndex] = (UpIndex != INDEX_NONE ? FastDTWSlopeJ[UpIndex] : 0) + 1;
+				FastDTWSteps[CellIndex] = Step_Input;
 			}
 			else
 			{
-				LookupTable[icol + j] = GetGestureDistance(seq1.Samples[i - 1] * Scaler, seq2.Samples[j - 1], bMirrorGesture) + LookupTable[icolneg + j - 1];
-				SlopeI[icol + j] = 0;
-				SlopeJ[icol + j] = 0;
+				FastDTWLookup[CellIndex] = CellDistance + DiagCost;
+				FastDTWSlopeI[CellIndex] = 0;
+				FastDTWSlopeJ[CellIndex] = 0;
+				FastDTWSteps[CellIndex] = Step_Diagonal;
 			}
 		}
-	}
 
-	// Find best between seq2 and an ending (postfix) of seq1.
-	float bestMatch = FLT_MAX;
+		// Find best between the example and an ending (postfix) of the input.
+		if (FastDTWRowHi[i] == ColumnCount && FastDTWRowLo[i] <= ColumnCount)
+		{
+			float EndCost = FastDTWLookup[FastDTWRowOffset[i] + (ColumnCount - FastDTWRowLo[i])];
+			if (EndCost < BestMatch)
+			{
+				BestMatch = EndCost;
+				BestRow = i;
+			}
+		}
+	}
 
-	for (int i = 1; i < seq1.Samples.Num() + 1/* - seq2.Minimum_Gesture_Length*/; i++)
+	if (bBuildPath)
 	{
-		if (LookupTable[(i*ColumnCount) + seq2.Samples.Num()] < bestMatch)
-		bestMatch = LookupTable[(i*ColumnCount) + seq2.Samples.Num()];
+		FastDTWPath.Reset();
+
+		if (BestRow != INDEX_NONE && BestMatch < MAX_FLT)
+		{
+			int i = BestRow;
+			int j = ColumnCount;
+			int CellIndex = GetCellIndex(i, j);
+
+			while (CellIndex != INDEX_NONE)
+			{
+				FastDTWPath.Add(FIntPoint(i, j));
+
+				switch (FastDTWSteps[CellIndex])
+				{
+				case Step_Example: j--; break;
+				case Step_Input: i--; break;
+				case Step_Diagonal:
+				default: i--; j--; break;
+				}
+
+				CellIndex = GetCellIndex(i, j);
+			}
+		}
 	}
 
-	return bestMatch;
+	return BestMatch;
 }
 
 void UVRGestureComponent::DrawDebugGesture(UObject* WorldContextObject, FTransform &StartTransform, FVRGesture GestureToDraw, FColor const& Color, bool bPersistentLines, uint8 DepthPriority, float LifeTime, float Thickness)
@@ -4,6 +4,23 @@
 #include "UObject/ObjectMacros.h"
 #include "UObject/Interface.h"
  
+TMap<TWeakObjectPtr<UClass>, bool> FVRGripInterfaceClassCache::ClassTable;
+
+bool FVRGripInterfaceClassCache::ImplementsGripInterface(UClass * Class)
+{
+	if (!Class)
+		return false;
+
+	check(IsInGameThread());
+
+	if (const bool * bImplements = ClassTable.Find(Class))
+		return *bImplements;
+
+	bool bImplements = Class->ImplementsInterface(UVRGripInterface::StaticClass());
+	ClassTable.Add(Class, bImplements);
+	return bImplements;
+}
+
 UVRGripInterface::UVRGripInterface(const class FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -298,6 +298,7 @@ UVRRootComponent::UVRRootComponent(const FObjectInitializer& ObjectInitializer)
 	bAllowSimulatingCollision = false;
 	bUseWalkingCollisionOverride = false;
 	WalkingCollisionOverride = ECollisionChannel::ECC_Pawn;
+	bDeferRelativeMovementSweep = false;
 
 	bCalledUpdateTransform = false;
 
@@ -513,18 +514,27 @@ void UVRRootComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
 						bAllowWalkingCollision = true;
 				}
 
-				if (bAllowWalkingCollision)
-					bBlockingHit = GetWorld()->SweepSingleByChannel(OutHit, LastPosition, OffsetComponentToWorld.GetLocation(), FQuat::Identity, WalkingCollisionOverride, GetCollisionShape(), Params, ResponseParam);
-
-				if (bBlockingHit && OutHit.Component.IsValid())
+				if (bAllowWalkingCollision && bDeferRelativeMovementSweep && CharMove->MovementMode == EMovementMode::MOVE_Walking && CharMove->IsA(UVRCharacterMovementComponent::StaticClass()) && CharMove->IsComponentTickEnabled() && CharMove->IsActive())
 				{
-					if (CharMove != nullptr && CharMove->bIgnoreSimulatingComponentsInFloorCheck && OutHit.Component->IsSimulatingPhysics())
-						bHadRelativeMovement = false;
-					else
-						bHadRelativeMovement = true;
+					// Pass the full delta on, the movement component sweeps it along with its own move
+					// and clears bHadRelativeMovement if it didn't collide with anything on the override channel.
+					bHadRelativeMovement = true;
 				}
 				else
-					bHadRelativeMovement = false;
+				{
+					if (bAllowWalkingCollision)
+						bBlockingHit = GetWorld()->SweepSingleByChannel(OutHit, LastPosition, OffsetComponentToWorld.GetLocation(), FQuat::Identity, WalkingCollisionOverride, GetCollisionShape(), Params, ResponseParam);
+
+					if (bBlockingHit && OutHit.Component.IsValid())
+					{
+						if (CharMove != nullptr && CharMove->bIgnoreSimulatingComponentsInFloorCheck && OutHit.Component->IsSimulatingPhysics())
+							bHadRelativeMovement = false;
+						else
+							bHadRelativeMovement = true;
+					}
+					else
+						bHadRelativeMovement = false;
+				}
 			}
 			else
 				bHadRelativeMovement = true;
@@ -14,6 +14,7 @@
 #include "VRGripInterface.h"
 #include "VRGlobalSettings.h"
 #include "XRMotionControllerBase.h" // for GetHandEnumForSourceName()
+#include "WorldCollision.h" // for FTraceHandle
 #include "GripMotionControllerComponent.generated.h"
 
 class AVRBaseCharacter;
@@ -26,6 +27,34 @@ DECLARE_LOG_CATEGORY_EXTERN(LogVRMotionController, Log, All);
 //For UE4 Profiler ~ Stat Group
 DECLARE_STATS_GROUP(TEXT("TICKGrip"), STATGROUP_TickGrip, STATCAT_Advanced);
 
+// Per grip state for async sweeps, the sweep is queued during TickGrip, submitted with the world batch once all actors have ticked
+// and its result is read back on the next TickGrip.
+struct FGripAsyncSweep
+{
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	FTraceHandle Handle;
+	bool bQueued;
+	FVector Start;
+	FVector End;
+	FQuat Rotation;
+
+	// Last completed result
+	bool bHasResult;
+	bool bBlockingHit;
+	FHitResult BlockingHit;
+	uint64 ResultFrame;
+
+	FGripAsyncSweep() :
+		bQueued(false),
+		Start(FVector::ZeroVector),
+		End(FVector::ZeroVector),
+		Rotation(FQuat::Identity),
+		bHasResult(false),
+		bBlockingHit(false),
+		ResultFrame(0)
+	{}
+};
+
 /** Delegate for notification when the controller grips a new object. */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FVRGripControllerOnGripSignature, const FBPActorGripInformation &, GripInformation);
 
@@ -74,20 +103,52 @@ public:
 		FPrimitiveSceneInfo*	SceneInfo;
 	};
 
-	/** A utility method that calls CacheSceneInfo on ParentComponent and all of its descendants */
-	void GatherLateUpdatePrimitives(USceneComponent* ParentComponent);
-	void ProcessGripArrayLateUpdatePrimitives(UGripMotionControllerComponent* MotionController, TArray<FBPActorGripInformation> & GripArray);
+	/** Primitive in a cached hierarchy, Info.SceneInfo is null while it has no scene proxy */
+	struct FLateUpdateCachedPrimitive
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		LateUpdatePrimitiveInfo Info;
+	};
+
+	/*
+	*  Everything under a late update root (the controller, an additional late update component or a gripped root), walked once and then
+	*  revalidated every frame without walking the hierarchy again. Attaching or detaching anywhere in it changes one of the cached child lists,
+	*  and a recreated or removed scene proxy changes a primitives scene info, either one has the hierarchy gathered again.
+	*/
+	struct FLateUpdateHierarchy
+	{
+		TArray<TWeakObjectPtr<USceneComponent>> Components;
+		// Attach children of each entry in Components, back to back. Only compared against, anything destroyed is caught by Components.
+		TArray<int32> ChildCounts;
+		TArray<USceneComponent*> Children;
+		TArray<FLateUpdateCachedPrimitive> Primitives;
+	};
+
+	/** Immutable list of primitives handed to the render thread, shared between frames for as long as nothing changes */
+	typedef TSharedPtr<const TArray<LateUpdatePrimitiveInfo>, ESPMode::ThreadSafe> FLateUpdateSnapshot;
 
-	/** Generates a LateUpdatePrimitiveInfo for the given component if it has a SceneProxy and appends it to the current LateUpdatePrimitives array */
-	void CacheSceneInfo(USceneComponent* Component);
+	/** Adds the late update roots of the grips in GripArray that should late update this frame to FrameRoots */
+	void ProcessGripArrayLateUpdatePrimitives(UGripMotionControllerComponent* MotionController, const TArray<FBPActorGripInformation> & GripArray);
+
+	/** Walks ParentComponent and all of its descendants into a hierarchy cache */
+	void GatherLateUpdateHierarchy(USceneComponent* ParentComponent, FLateUpdateHierarchy & Hierarchy);
+
+	/** Returns false if anything was attached, detached, destroyed or had its scene proxy recreated since the hierarchy was gathered */
+	bool IsLateUpdateHierarchyValid(const FLateUpdateHierarchy & Hierarchy) const;
 
 	/** Parent world transform used to reconstruct new world transforms for late update scene proxies */
 	FTransform LateUpdateParentToWorld[2];
 	/** Primitives that need late update before rendering */
-	TArray<LateUpdatePrimitiveInfo> LateUpdatePrimitives[2];
+	FLateUpdateSnapshot LateUpdatePrimitives[2];
 	/** Late Update Info Stale, if this is found true do not late update */
 	bool SkipLateUpdate[2];
 
+	/** Game thread only, the roots this frame, the roots the current snapshot was built from and the cached hierarchy of each root */
+	TArray<USceneComponent*> FrameRoots;
+	TArray<USceneComponent*> SnapshotRoots;
+	TMap<USceneComponent*, FLateUpdateHierarchy> CachedHierarchies;
+	FLateUpdateSnapshot CurrentSnapshot;
+
 	int32 LateUpdateGameWriteIndex;
 	int32 LateUpdateRenderReadIndex;
 
@@ -214,6 +275,23 @@ public:
 	UPROPERTY(BlueprintReadOnly, Replicated, Category = "GripMotionController", ReplicatedUsing = OnRep_LocallyGrippedObjects)
 	TArray<FBPActorGripInformation> LocallyGrippedObjects;
 
+	// Replicate the grip arrays through fast array mirrors instead of the TArrays, only grips that changed get sent and clients
+	// handle them one at a time instead of OnRep_GrippedObjects / OnRep_LocallyGrippedObjects re-walking every grip.
+	// The grip arrays keep the same API, but clients no longer keep the servers grip order in them.
+	// Has to match on server and clients, so it is a defaults only setting.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "GripMotionController|Networking")
+	bool bUseFastArrayGripReplication;
+
+	// Fast array mirrors of the grip arrays, only replicated when bUseFastArrayGripReplication is on
+	UPROPERTY(Replicated)
+	FBPActorGripArray FastGrippedObjects;
+
+	UPROPERTY(Replicated)
+	FBPActorGripArray FastLocallyGrippedObjects;
+
+	// Server side, brings a mirror up to date with its grip array and marks the grips that changed dirty
+	void SyncFastGripArray(const TArray<FBPActorGripInformation> & SourceArray, FBPActorGripArray & FastArray);
+
 	// Locally Gripped Array functions
 
 	// Notify a client that their local grip was bad
@@ -247,6 +325,15 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GripMotionController")
 	bool bAlwaysSendTickGrip;
 
+	// If true InteractiveCollisionWithSweep and SweepWithPhysics grips use the async trace api instead of a blocking sweep every frame.
+	// Sweeps from every controller in the world are submitted together after actors tick and consumed on the next frame, so collision lags by one frame
+	// and is tested against the collision shape of the root component (sphere / capsule / bounds box) instead of its full geometry.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GripMotionController|Advanced")
+	bool bUseAsyncGripSweeps;
+
+	// Called by the world batch to submit this controllers queued async sweeps
+	void SubmitAsyncGripSweeps();
+
 	// Clean up a grip that is "bad", object is being destroyed or was a bad destructible mesh
 	void CleanUpBadGrip(TArray<FBPActorGripInformation> &GrippedObjectsArray, int GripIndex, bool bReplicatedArray);
 	void CleanUpBadPhysicsHandles();
@@ -260,6 +347,7 @@ public:
 		{
 			DestroyPhysicsHandle(PhysicsGrips[HandleIndex].SceneIndex, &PhysicsGrips[HandleIndex].HandleData, &PhysicsGrips[HandleIndex].KinActorData);
 			PhysicsGrips.RemoveAt(HandleIndex);
+			MarkPhysicsGripIndexDirty();
 		}
 
 		// Grip Type or replication was changed
@@ -273,6 +361,8 @@ public:
 		// Check for removed gripped actors
 		// This might actually be better left as an RPC multicast
 
+		MarkGripIndexDirty();
+
 		for (FBPActorGripInformation & Grip : GrippedObjects)
 		{
 			HandleGripReplication(Grip);
@@ -282,12 +372,41 @@ public:
 	UFUNCTION()
 	virtual void OnRep_LocallyGrippedObjects()
 	{
+		MarkGripIndexDirty();
+
 		for (FBPActorGripInformation & Grip : LocallyGrippedObjects)
 		{
 			HandleGripReplication(Grip);
 		}
 	}
 
+	// Client side per grip callbacks from the fast array mirrors, applied to the matching grip array by GripID
+	virtual void OnFastGripReplicated(const FBPActorGripArray & FastArray, const FBPActorGripInformation & RepGrip)
+	{
+		TArray<FBPActorGripInformation> & GripArray = (&FastArray == &FastGrippedObjects) ? GrippedObjects : LocallyGrippedObjects;
+
+		FBPActorGripInformation * Grip = GripArray.FindByKey(RepGrip);
+		if (!Grip)
+		{
+			Grip = &GripArray[GripArray.AddDefaulted()];
+		}
+
+		// Keeps the non replicated values so that HandleGripReplication can diff against them
+		Grip->RepCopy(RepGrip);
+
+		MarkGripIndexDirty();
+		HandleGripReplication(*Grip);
+	}
+
+	virtual void OnFastGripReplicatedRemove(const FBPActorGripArray & FastArray, const FBPActorGripInformation & RepGrip)
+	{
+		TArray<FBPActorGripInformation> & GripArray = (&FastArray == &FastGrippedObjects) ? GrippedObjects : LocallyGrippedObjects;
+
+		// Drops are still handled by the NotifyDrop multicast, this only catches grips that are already gone there
+		if (GripArray.Remove(RepGrip) > 0)
+			MarkGripIndexDirty();
+	}
+
 	inline bool HandleGripReplication(FBPActorGripInformation & Grip)
 	{
 		if (Grip.ValueCache.bWasInitiallyRepped && Grip.GripID != Grip.ValueCache.CachedGripID)
@@ -306,6 +425,7 @@ public:
 
 			// null ptr so this doesn't block grip operations
 			Grip.GrippedObject = nullptr;
+			MarkGripIndexDirty();
 			
 			// Set to paused so iteration skips it
 			Grip.bIsPaused = true;
@@ -418,6 +538,13 @@ public:
 	bool bLerpingPosition;
 	bool bReppedOnce;
 
+	// Remote side buffer of timestamped updates, used instead of the lerp when smoothing replicated motion
+	FVRReplicatedPoseBuffer RemotePoseBuffer;
+
+	// Lerp timing for remotes getting updates without timestamps, see FBPVRAdaptiveNetUpdateRate::GetRemoteLerpDuration
+	double LastRemoteUpdateTime;
+	float RemoteLerpDuration;
+
 	UFUNCTION()
 	virtual void OnRep_ReplicatedControllerTransform()
 	{
@@ -425,8 +552,22 @@ public:
 
 		if (bSmoothReplicatedMotion)
 		{
+			if (ReplicatedControllerTransform.bHasTimeStamp)
+			{
+				// Timestamped updates are played back out of the jitter buffer in tick
+				RemotePoseBuffer.AddSample(ReplicatedControllerTransform, FPlatformTime::Seconds());
+				bLerpingPosition = false;
+				bReppedOnce = true;
+				return;
+			}
+
+			RemotePoseBuffer.Reset();
+
+			const double CurrentTime = FPlatformTime::Seconds();
+
 			if (bReppedOnce)
 			{
+				RemoteLerpDuration = AdaptiveNetUpdateRate.GetRemoteLerpDuration((float)(CurrentTime - LastRemoteUpdateTime), ControllerNetUpdateRate);
 				bLerpingPosition = true;
 				ControllerNetUpdateCount = 0.0f;
 				LastUpdatesRelativePosition = this->RelativeLocation;
@@ -437,6 +578,8 @@ public:
 				SetRelativeLocationAndRotation(ReplicatedControllerTransform.Position, ReplicatedControllerTransform.Rotation);
 				bReppedOnce = true;
 			}
+
+			LastRemoteUpdateTime = CurrentTime;
 		}
 		else
 			SetRelativeLocationAndRotation(ReplicatedControllerTransform.Position, ReplicatedControllerTransform.Rotation);
@@ -449,6 +592,10 @@ public:
 	// Used in Tick() to accumulate before sending updates, didn't want to use a timer in this case, also used for remotes to lerp position
 	float ControllerNetUpdateCount;
 
+	// Scales the send rate by how much the controller is moving, ControllerNetUpdateRate is the rate while moving
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "GripMotionController|Networking")
+	FBPVRAdaptiveNetUpdateRate AdaptiveNetUpdateRate;
+
 	// Whether to smooth (lerp) between ticks for the replicated motion, DOES NOTHING if update rate is larger than FPS!
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "GripMotionController|Networking")
 		bool bSmoothReplicatedMotion;
@@ -461,6 +608,9 @@ public:
 	UFUNCTION(Unreliable, Server, WithValidation)
 	void Server_SendControllerTransform(FBPVRComponentPosRep NewTransform);
 
+	// Keyframe state for DeltaSmallestThree, sender side on the owning client and receiver side on the server
+	FVRPosRepDeltaState PosRepDeltaState;
+
 	// Pointer to an override to call from the owning character - this saves 7 bits a rep avoiding component IDs on the RPC
 	typedef void (AVRBaseCharacter::*VRBaseCharTransformRPC_Pointer)(FBPVRComponentPosRep NewTransform);
 	VRBaseCharTransformRPC_Pointer OverrideSendTransform;
@@ -757,6 +907,10 @@ public:
 	// Splitting logic into separate function
 	void HandleGripArray(TArray<FBPActorGripInformation> &GrippedObjectsArray, const FTransform & ParentTransform, float DeltaTime, bool bReplicatedArray = false);
 
+	// Gets the root / actor of a grip and whether they implement the grip interface out of the grips TargetCache, rebuilding it if it is stale.
+	// Returns false if the grip doesn't currently have a valid root and actor.
+	bool GetCachedGripTargets(FBPActorGripInformation &Grip, UPrimitiveComponent *& root, AActor *& actor, bool & bRootHasInterface, bool & bActorHasInterface);
+
 	// Gets the world transform of a grip, modified by secondary grips and interaction settings
 	void GetGripWorldTransform(float DeltaTime,FTransform & WorldTransform, const FTransform &ParentTransform, FBPActorGripInformation &Grip, AActor * actor, UPrimitiveComponent * root, bool bRootHasInterface, bool bActorHasInterface/*, bool & bRescalePhysicsGrips*/);
 
@@ -785,7 +939,7 @@ public:
 		if (!ObjectToCheck)
 			return false;
 
-		return (GrippedObjects.FindByKey(ObjectToCheck) || LocallyGrippedObjects.FindByKey(ObjectToCheck));
+		return FindGripByObject(ObjectToCheck) != nullptr;
 	}
 
 	// Gets if the given actor is held by this controller
@@ -795,7 +949,7 @@ public:
 		if (!ActorToCheck)
 			return false;
 
-		return (GrippedObjects.FindByKey(ActorToCheck) || LocallyGrippedObjects.FindByKey(ActorToCheck));
+		return FindGripByObject(ActorToCheck) != nullptr;
 	}
 
 	// Gets if the given component is held by this controller
@@ -805,9 +959,7 @@ public:
 		if (!ComponentToCheck)
 			return false;
 
-		return (GrippedObjects.FindByKey(ComponentToCheck) || LocallyGrippedObjects.FindByKey(ComponentToCheck));
-
-		return false;
+		return FindGripByObject(ComponentToCheck) != nullptr;
 	}
 
 	// Gets if the given Component is a secondary attach point to a gripped actor
@@ -898,6 +1050,16 @@ public:
 	bool bUseWithoutTracking;
 
 	bool CheckComponentWithSweep(UPrimitiveComponent * ComponentToCheck, FVector Move, FRotator newOrientation, bool bSkipSimulatingComponents/*, bool & bHadBlockingHitOut*/);
+
+	// Async sweep state keyed by GripID
+	TMap<uint8, FGripAsyncSweep> AsyncGripSweeps;
+
+	// Returns the async sweep state for a grip, resetting it if the grip ID was reused for a different component
+	FGripAsyncSweep & GetAsyncGripSweep(const FBPActorGripInformation & Grip, UPrimitiveComponent * root);
+
+	// Queues a sweep of root from its current location to the target for the world batch
+	void QueueAsyncGripSweep(FGripAsyncSweep & Sweep, UPrimitiveComponent * root, const FVector & Target, const FQuat & Rotation);
+	void OnAsyncGripSweepComplete(const FTraceHandle & Handle, FTraceDatum & Datum);
 	
 	// For physics handle operations
 	bool SetUpPhysicsHandle(const FBPActorGripInformation &NewGrip);
@@ -907,6 +1069,28 @@ public:
 	bool GetPhysicsJointLength(const FBPActorGripInformation &GrippedActor, UPrimitiveComponent * rootComp, FVector & LocOut);
 
 	TArray<FBPActorPhysicsHandleInformation> PhysicsGrips;
+
+	// Side index for grip lookups, GripID / gripped object -> slot in GrippedObjects (>= 0) or LocallyGrippedObjects (~Index) and GripID -> slot in PhysicsGrips.
+	// The arrays stay the source of truth: anything that adds, removes or replaces grips marks the index dirty and the next lookup rebuilds it,
+	// and every hit is checked against the array before it is returned. A miss or a stale hit falls back to searching the arrays.
+	TMap<uint8, int32> GripIDIndex;
+	TMap<const UObject *, int32> GrippedObjectIndex;
+	TMap<uint8, int32> PhysicsGripIDIndex;
+	bool bGripIndexDirty;
+	bool bPhysicsGripIndexDirty;
+	int32 IndexedGripCount;
+	int32 IndexedLocalGripCount;
+	int32 IndexedPhysicsGripCount;
+
+	inline void MarkGripIndexDirty() { bGripIndexDirty = true; }
+	inline void MarkPhysicsGripIndexDirty() { bPhysicsGripIndexDirty = true; }
+	void RebuildGripIndex();
+	void RebuildPhysicsGripIndex();
+
+	// O(1) grip lookups, these return the first match in GrippedObjects and then LocallyGrippedObjects the same as FindByKey on both would
+	FBPActorGripInformation * FindGripByID(uint8 GripID);
+	FBPActorGripInformation * FindGripByObject(const UObject * Object);
+
 	FBPActorPhysicsHandleInformation * GetPhysicsGrip(const FBPActorGripInformation & GripInfo);
 	bool GetPhysicsGripIndex(const FBPActorGripInformation & GripInfo, int & index);
 	FBPActorPhysicsHandleInformation * CreatePhysicsGrip(const FBPActorGripInformation & GripInfo);
@@ -53,6 +53,13 @@ public:
 	bool bLerpingPosition;
 	bool bReppedOnce;
 
+	// Remote side buffer of timestamped updates, used instead of the lerp when smoothing replicated motion
+	FVRReplicatedPoseBuffer RemotePoseBuffer;
+
+	// Lerp timing for remotes getting updates without timestamps, see FBPVRAdaptiveNetUpdateRate::GetRemoteLerpDuration
+	double LastRemoteUpdateTime;
+	float RemoteLerpDuration;
+
 	// Whether to smooth (lerp) between ticks for the replicated motion, DOES NOTHING if update rate is larger than FPS!
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "ReplicatedCamera|Networking")
 		bool bSmoothReplicatedMotion;
@@ -62,8 +69,22 @@ public:
 	{
 		if (bSmoothReplicatedMotion)
 		{
+			if (ReplicatedCameraTransform.bHasTimeStamp)
+			{
+				// Timestamped updates are played back out of the jitter buffer in tick
+				RemotePoseBuffer.AddSample(ReplicatedCameraTransform, FPlatformTime::Seconds());
+				bLerpingPosition = false;
+				bReppedOnce = true;
+				return;
+			}
+
+			RemotePoseBuffer.Reset();
+
+			const double CurrentTime = FPlatformTime::Seconds();
+
 			if (bReppedOnce)
 			{
+				RemoteLerpDuration = AdaptiveNetUpdateRate.GetRemoteLerpDuration((float)(CurrentTime - LastRemoteUpdateTime), NetUpdateRate);
 				bLerpingPosition = true;
 				NetUpdateCount = 0.0f;
 				LastUpdatesRelativePosition = this->RelativeLocation;
@@ -74,6 +95,8 @@ public:
 				SetRelativeLocationAndRotation(ReplicatedCameraTransform.Position, ReplicatedCameraTransform.Rotation);
 				bReppedOnce = true;
 			}
+
+			LastRemoteUpdateTime = CurrentTime;
 		}
 		else
 			SetRelativeLocationAndRotation(ReplicatedCameraTransform.Position, ReplicatedCameraTransform.Rotation);
@@ -86,10 +109,17 @@ public:
 	// Used in Tick() to accumulate before sending updates, didn't want to use a timer in this case.
 	float NetUpdateCount;
 
+	// Scales the send rate by how much the camera is moving, NetUpdateRate is the rate while moving
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ReplicatedCamera|Networking")
+	FBPVRAdaptiveNetUpdateRate AdaptiveNetUpdateRate;
+
 	// I'm sending it unreliable because it is being resent pretty often
 	UFUNCTION(Unreliable, Server, WithValidation)
 	void Server_SendCameraTransform(FBPVRComponentPosRep NewTransform);
 
+	// Keyframe state for DeltaSmallestThree, sender side on the owning client and receiver side on the server
+	FVRPosRepDeltaState PosRepDeltaState;
+
 	// Pointer to an override to call from the owning character - this saves 7 bits a rep avoiding component IDs on the RPC
 	typedef void (AVRBaseCharacter::*VRBaseCharTransformRPC_Pointer)(FBPVRComponentPosRep NewTransform);
 	VRBaseCharTransformRPC_Pointer OverrideSendTransform;
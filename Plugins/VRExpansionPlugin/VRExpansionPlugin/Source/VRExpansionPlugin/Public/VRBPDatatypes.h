@@ -3,6 +3,7 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "EngineMinimal.h"
+#include "Engine/NetSerialization.h"
 
 #include "PhysicsPublic.h"
 #if WITH_PHYSX
@@ -302,7 +303,25 @@ enum class EVRVectorQuantization : uint8
 	/** Each vector component will be rounded, preserving one decimal place. */
 	RoundOneDecimal = 0,
 	/** Each vector component will be rounded, preserving two decimal places. */
-	RoundTwoDecimals = 1
+	RoundTwoDecimals = 1,
+	/** Two decimal places sent as an adaptive width delta from the last keyframe, rotation sent as a smallest three quaternion. */
+	DeltaSmallestThree = 2
+};
+
+// Keyframe tracking for delta encoded FBPVRComponentPosRep, the sender and the receiver of a device each keep one
+struct VREXPANSIONPLUGIN_API FVRPosRepDeltaState
+{
+	FVector KeyframePosition;
+	uint8 KeyframeID;
+	bool bHasKeyframe;
+	int32 UpdatesSinceKeyframe;
+
+	FVRPosRepDeltaState() :
+		KeyframePosition(FVector::ZeroVector),
+		KeyframeID(0),
+		bHasKeyframe(false),
+		UpdatesSinceKeyframe(0)
+	{}
 };
 
 USTRUCT()
@@ -319,12 +338,45 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category = Replication, AdvancedDisplay)
 		EVRVectorQuantization QuantizationLevel;
 
+	// Delta encoding state for DeltaSmallestThree, senders call PrepareDeltaSend() right before sending and receivers call ResolveDelta() on what
+	// they get. Anything that wasn't prepared (property replication from the server) goes out as a keyframe.
+	uint8 KeyframeID;
+	bool bIsDelta;
+	// Sender side only, not serialized
+	FVector DeltaBaseline;
+
+	// Keyframes go out at least this often so a lost one only costs this many updates
+	static const int32 DefaultKeyframeInterval = 30;
+
+	// Senders real time in milliseconds, wraps every ~65 seconds. Only sent when the device smooths its replicated motion, remotes use it to
+	// place the update in their jitter buffer.
+	bool bHasTimeStamp;
+	uint16 TimeStamp;
+
 	FBPVRComponentPosRep():
-		QuantizationLevel(EVRVectorQuantization::RoundTwoDecimals)
+		QuantizationLevel(EVRVectorQuantization::RoundTwoDecimals),
+		KeyframeID(0),
+		bIsDelta(false),
+		DeltaBaseline(FVector::ZeroVector),
+		bHasTimeStamp(false),
+		TimeStamp(0)
 	{
 		//QuantizationLevel = EVRVectorQuantization::RoundTwoDecimals;
 	}
 
+	// Picks keyframe or delta for this send and advances the senders state, does nothing for the other quantization levels
+	void PrepareDeltaSend(FVRPosRepDeltaState & State, int32 KeyframeInterval = DefaultKeyframeInterval);
+
+	// Turns a received delta back into an absolute position, returns false if the keyframe it was based on never arrived and it should be dropped
+	bool ResolveDelta(FVRPosRepDeltaState & State);
+
+	// Stamps with the low 16 bits of the senders clock in milliseconds, pass FPlatformTime::Seconds() so the stamp keeps millisecond precision in long sessions
+	inline void SetTimeStamp(bool bSendTimeStamp, double SenderTimeSeconds)
+	{
+		bHasTimeStamp = bSendTimeStamp;
+		TimeStamp = bSendTimeStamp ? (uint16)(((uint64)(SenderTimeSeconds * 1000.0)) & 0xFFFF) : 0;
+	}
+
 	/** Network serialization */
 	// Doing a custom NetSerialize here because this is sent via RPCs and should change on every update
 	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
@@ -333,7 +385,14 @@ public:
 
 		// Defines the level of Quantization
 		//uint8 Flags = (uint8)QuantizationLevel;
-		Ar.SerializeBits(&QuantizationLevel, 1); // Only two values 0:1
+		Ar.SerializeBits(&QuantizationLevel, 2); // Three values 0:2
+
+		Ar.SerializeBits(&bHasTimeStamp, 1);
+		if (bHasTimeStamp)
+			Ar << TimeStamp;
+
+		if (QuantizationLevel == EVRVectorQuantization::DeltaSmallestThree)
+			return NetSerializeDeltaSmallestThree(Ar, Map, bOutSuccess);
 
 		// No longer using their built in rotation rep, as controllers will rarely if ever be at 0 rot on an axis and 
 		// so the 1 bit overhead per axis is just that, overhead
@@ -367,6 +426,7 @@ public:
 			{
 			case EVRVectorQuantization::RoundTwoDecimals: bOutSuccess &= SerializePackedVector<100, 30>(Position, Ar); break;
 			case EVRVectorQuantization::RoundOneDecimal: bOutSuccess &= SerializePackedVector<10, 24>(Position, Ar); break;
+			default: bOutSuccess = false; break;
 			}
 
 			Ar << ShortPitch;
@@ -381,6 +441,7 @@ public:
 		return bOutSuccess;
 	}
 
+	bool NetSerializeDeltaSmallestThree(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
 };
 
 template<>
@@ -392,6 +453,124 @@ struct TStructOpsTypeTraits< FBPVRComponentPosRep > : public TStructOpsTypeTrait
 	};
 };
 
+// Owning client send rate that follows how much a tracked device is moving, a still hand drops to MinNetUpdateRate and anything moving
+// at or above the full rate velocities sends at the devices normal rate.
+USTRUCT(BlueprintType, Category = "VRExpansionLibrary")
+struct VREXPANSIONPLUGIN_API FBPVRAdaptiveNetUpdateRate
+{
+	GENERATED_BODY()
+public:
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking")
+		bool bUseAdaptiveNetUpdateRate;
+
+	// Rate to fall back to when the device is still, keeps remotes from drifting too far if a packet is lost
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0.1", UIMin = "0.1"))
+		float MinNetUpdateRate;
+
+	// Linear speed (cm/s) at which the full rate is used
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0.1", UIMin = "0.1"))
+		float FullRateVelocity;
+
+	// Angular speed (deg/s) at which the full rate is used
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0.1", UIMin = "0.1"))
+		float FullRateAngularVelocity;
+
+	FBPVRAdaptiveNetUpdateRate() :
+		bUseAdaptiveNetUpdateRate(false),
+		MinNetUpdateRate(5.0f),
+		FullRateVelocity(30.0f),
+		FullRateAngularVelocity(90.0f)
+	{}
+
+	// Rate for a device that is now at Position / Rotation, ElapsedTime after the last update that went out
+	inline float GetNetUpdateRate(const FBPVRComponentPosRep & LastSent, const FVector & Position, const FRotator & Rotation, float ElapsedTime, float MaxRate) const
+	{
+		if (!bUseAdaptiveNetUpdateRate || ElapsedTime <= 0.0f)
+			return MaxRate;
+
+		const float Velocity = FVector::Dist(Position, LastSent.Position) / ElapsedTime;
+		const float AngularVelocity = FMath::RadiansToDegrees(FMath::Abs(FMath::UnwindRadians((Rotation.Quaternion() * LastSent.Rotation.Quaternion().Inverse()).GetNormalized().GetAngle()))) / ElapsedTime;
+
+		const float MotionAlpha = FMath::Clamp(FMath::Max(Velocity / FullRateVelocity, AngularVelocity / FullRateAngularVelocity), 0.0f, 1.0f);
+		return FMath::Lerp(FMath::Min(MinNetUpdateRate, MaxRate), MaxRate, MotionAlpha);
+	}
+
+	// How long a remote without the pose buffer should lerp to a new update over. With the adaptive rate on updates can come in
+	// anywhere between MaxRate and MinNetUpdateRate, so the measured interval since the last one is used instead of the nominal one.
+	inline float GetRemoteLerpDuration(float MeasuredInterval, float MaxRate) const
+	{
+		const float NominalInterval = MaxRate > 0.0f ? 1.0f / MaxRate : 0.0f;
+
+		if (!bUseAdaptiveNetUpdateRate || MeasuredInterval <= 0.0f || MaxRate <= 0.0f)
+			return NominalInterval;
+
+		return FMath::Clamp(MeasuredInterval, NominalInterval, 1.0f / FMath::Min(MinNetUpdateRate, MaxRate));
+	}
+};
+
+// Timestamped jitter buffer for replicated device poses on remotes. Playback runs behind the newest update by an adaptive delay
+// (send interval plus measured jitter), position is cubic hermite interpolated between buffered updates and rotation slerped, and if
+// updates stop arriving it extrapolates for a bounded time before holding.
+struct VREXPANSIONPLUGIN_API FVRReplicatedPoseBuffer
+{
+	struct FPoseSample
+	{
+		double SenderTime;
+		FVector Position;
+		FQuat Rotation;
+	};
+
+	TArray<FPoseSample> Samples;
+
+	// Local time minus sender time at the lowest latency seen so far
+	double ClockOffset;
+	double LastArrivalTime;
+	int64 LastTimeStampMS;
+	float SendInterval;
+	float Jitter;
+	float PlaybackDelay;
+	int32 RejectedSamples;
+	bool bHasClock;
+
+	static const int32 MaxSamples = 16;
+	static const float MaxExtrapolationTime;
+	static const float MaxPlaybackDelay;
+
+	// The stamp only unwraps correctly inside +-32.7 seconds, past either of these the buffer resyncs
+	static const double MaxArrivalGap;
+	static const int32 MaxRejectedSamples = 8;
+
+	FVRReplicatedPoseBuffer()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		Samples.Reset();
+		ClockOffset = 0.0;
+		LastArrivalTime = 0.0;
+		LastTimeStampMS = 0;
+		SendInterval = 0.01f;
+		Jitter = 0.0f;
+		PlaybackDelay = 0.0f;
+		RejectedSamples = 0;
+		bHasClock = false;
+	}
+
+	inline bool HasSamples() const
+	{
+		return Samples.Num() > 0;
+	}
+
+	// LocalTime is FPlatformTime::Seconds(), the world times are floats and lose precision in long sessions
+	void AddSample(const FBPVRComponentPosRep & PosRep, double LocalTime);
+
+	// Returns false if there is nothing buffered yet
+	bool Sample(double LocalTime, FVector & OutPosition, FRotator & OutRotation);
+};
+
 UENUM(Blueprintable)
 enum class EGripCollisionType : uint8
 {
@@ -1011,7 +1190,7 @@ public:
 };*/
 
 USTRUCT(BlueprintType, Category = "VRExpansionLibrary")
-struct VREXPANSIONPLUGIN_API FBPActorGripInformation
+struct VREXPANSIONPLUGIN_API FBPActorGripInformation : public FFastArraySerializerItem
 {
 	GENERATED_BODY()
 public:
@@ -1111,9 +1290,35 @@ public:
 
 	}ValueCache;
 
+	// Resolved root / actor of the grip and whether their classes implement the grip interface, so ticking grips doesn't have to
+	// cast and walk interface lists every frame. Filled in by the controller, checked against the live objects each use and rebuilt
+	// if the gripped object, the actors root component or either class has changed since. Never replicated.
+	struct FGripTargetCache
+	{
+		UObject * CachedGrippedObject;
+		UPrimitiveComponent * Root;
+		AActor * Actor;
+		UClass * RootClass;
+		UClass * ActorClass;
+		bool bRootHasInterface;
+		bool bActorHasInterface;
+
+		FGripTargetCache() :
+			CachedGrippedObject(nullptr),
+			Root(nullptr),
+			Actor(nullptr),
+			RootClass(nullptr),
+			ActorClass(nullptr),
+			bRootHasInterface(false),
+			bActorHasInterface(false)
+		{}
+
+	}TargetCache;
+
 	void ClearNonReppingItems()
 	{
 		ValueCache = FGripValueCache();
+		TargetCache = FGripTargetCache();
 		bColliding = false;
 		bIsLocked = false;
 		LastLockedRotation = FQuat::Identity;
@@ -1151,6 +1356,11 @@ public:
 	}
 
 
+	// Per item callbacks from FBPActorGripArray on clients when fast array grip replication is on, forwarded to the owning controller
+	void PreReplicatedRemove(const struct FBPActorGripArray & InArraySerializer);
+	void PostReplicatedAdd(const struct FBPActorGripArray & InArraySerializer);
+	void PostReplicatedChange(const struct FBPActorGripArray & InArraySerializer);
+
 	FORCEINLINE AActor * GetGrippedActor() const
 	{
 		return Cast<AActor>(GrippedObject);
@@ -1231,6 +1441,40 @@ public:
 
 };
 
+// Opt in fast array mirror of a controllers grip array (bUseFastArrayGripReplication), only grips that changed get serialized
+// and clients get per grip add / change / remove callbacks instead of re-walking the whole array on every rep.
+// The controller keeps gripping through its TArrays and syncs this from them on the server, so nothing else writes to it.
+USTRUCT()
+struct VREXPANSIONPLUGIN_API FBPActorGripArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+public:
+
+	UPROPERTY()
+		TArray<FBPActorGripInformation> Items;
+
+	// Controller that owns this array, set in its constructor and used by the item callbacks
+	UGripMotionControllerComponent * OwningController;
+
+	FBPActorGripArray() :
+		OwningController(nullptr)
+	{}
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo & DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FBPActorGripInformation, FBPActorGripArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits< FBPActorGripArray > : public TStructOpsTypeTraitsBase2<FBPActorGripArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
+
 USTRUCT(BlueprintType, Category = "VRExpansionLibrary")
 struct VREXPANSIONPLUGIN_API FBPInterfaceProperties
 {
@@ -160,6 +160,132 @@ struct TStructOpsTypeTraits< FVRReplicatedCapsuleHeight > : public TStructOpsTyp
 	};
 };
 
+// All of a characters tracked devices in one packet, sampled on the same frame.
+// Slots are the order of the server assigned AVRBaseCharacter::BundledTrackedDevices, devices that haven't changed only cost their bit in the dirty mask.
+// LayoutKey is the revision of that slot list the sender used, so that the server can tell when the client hasn't gotten its latest one yet.
+USTRUCT()
+struct VREXPANSIONPLUGIN_API FBPVRTrackedDevicesRep
+{
+	GENERATED_USTRUCT_BODY()
+public:
+
+	static const int32 MaxDevices = 16;
+
+	// Bit per slot, only the dirty slots in Devices are valid
+	uint16 DirtyMask;
+
+	// Revision of the senders slot layout
+	uint16 LayoutKey;
+
+	UPROPERTY(Transient)
+		TArray<FBPVRComponentPosRep> Devices;
+
+	FBPVRTrackedDevicesRep() :
+		DirtyMask(0),
+		LayoutKey(0)
+	{}
+
+	inline bool IsDeviceDirty(int32 Slot) const
+	{
+		return (DirtyMask & (1 << Slot)) != 0;
+	}
+
+	/** Network serialization */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		bOutSuccess = true;
+
+		uint32 NumDevices = Devices.Num();
+		Ar.SerializeInt(NumDevices, MaxDevices + 1);
+		Ar << LayoutKey;
+
+		if (Ar.IsLoading())
+		{
+			DirtyMask = 0;
+			Devices.SetNum(FMath::Min<int32>(NumDevices, MaxDevices));
+		}
+
+		Ar.SerializeBits(&DirtyMask, Devices.Num());
+
+		for (int32 i = 0; i < Devices.Num(); ++i)
+		{
+			if (IsDeviceDirty(i))
+				Devices[i].NetSerialize(Ar, Map, bOutSuccess);
+		}
+
+		return bOutSuccess;
+	}
+};
+template<>
+struct TStructOpsTypeTraits< FBPVRTrackedDevicesRep > : public TStructOpsTypeTraitsBase2<FBPVRTrackedDevicesRep>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+// Per viewer net priority for a character and the tracked devices that replicate with it. The engine already sends actors with a higher
+// priority first and accumulates priority for ones it skipped, so scaling it down for far away or out of view characters means each viewer
+// gets their updates less often once bandwidth is tight instead of every viewer getting every character at full rate.
+USTRUCT(BlueprintType, Category = "VRExpansionLibrary")
+struct VREXPANSIONPLUGIN_API FBPVRNetPriorityPolicy
+{
+	GENERATED_BODY()
+public:
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking")
+		bool bUseNetPriorityPolicy;
+
+	// Characters closer than this to the viewer keep their full priority
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0", UIMin = "0"))
+		float FullPriorityDistance;
+
+	// Distance at which priority bottoms out at MinPriorityScale
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0", UIMin = "0"))
+		float MinPriorityDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0.01", UIMin = "0.01", ClampMax = "1.0", UIMax = "1.0"))
+		float MinPriorityScale;
+
+	// Extra scale for characters outside of the viewers view cone (past FullPriorityDistance)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0.01", UIMin = "0.01", ClampMax = "1.0", UIMax = "1.0"))
+		float OutOfViewScale;
+
+	// Half angle of the view cone in degrees
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Networking", meta = (ClampMin = "0", UIMin = "0", ClampMax = "180", UIMax = "180"))
+		float ViewConeHalfAngle;
+
+	FBPVRNetPriorityPolicy() :
+		bUseNetPriorityPolicy(false),
+		FullPriorityDistance(500.0f),
+		MinPriorityDistance(4000.0f),
+		MinPriorityScale(0.1f),
+		OutOfViewScale(0.25f),
+		ViewConeHalfAngle(60.0f)
+	{}
+
+	float GetPriorityScale(const FVector & ViewPos, const FVector & ViewDir, const FVector & Location, bool bLowBandwidth) const
+	{
+		const FVector Dir = Location - ViewPos;
+		const float Dist = Dir.Size();
+
+		if (Dist <= FullPriorityDistance)
+			return 1.0f;
+
+		float Scale = FMath::GetMappedRangeValueClamped(FVector2D(FullPriorityDistance, FMath::Max(MinPriorityDistance, FullPriorityDistance + 1.0f)), FVector2D(1.0f, MinPriorityScale), Dist);
+
+		if ((ViewDir | Dir) < Dist * FMath::Cos(FMath::DegreesToRadians(ViewConeHalfAngle)))
+			Scale *= OutOfViewScale;
+
+		// Low bandwidth connections fall off harder
+		if (bLowBandwidth)
+			Scale *= Scale;
+
+		return Scale;
+	}
+};
+
 UCLASS()
 class VREXPANSIONPLUGIN_API AVRBaseCharacter : public ACharacter
 {
@@ -186,8 +312,39 @@ public:
 	UFUNCTION(Unreliable, Server, WithValidation)
 		void Server_SendTransformRightController(FBPVRComponentPosRep NewTransform);
 
+	// If true the camera, both controllers and any other grip motion controllers on the character are sent together in one rpc per net update
+	// instead of each device running its own rate and rpc. The devices replicated update rates are set to TrackedDeviceNetUpdateRate on the server
+	// so that remote smoothing still lerps over the send interval. Off by default. The server assigns the slots, devices added at runtime
+	// use their own rpcs until they have one.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VRBaseCharacter|Networking")
+		bool bBundleTrackedDeviceReplication;
+
+	// Rate to send the bundled tracked devices to the server at
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VRBaseCharacter|Networking", meta = (ClampMin = "0", UIMin = "0"))
+		float TrackedDeviceNetUpdateRate;
+
+	UFUNCTION(Unreliable, Server, WithValidation)
+		void Server_SendTrackedDevices(const FBPVRTrackedDevicesRep & TrackedDevices);
+
+	// Called by the camera and controllers every tick on the owning client when bundling, the bundle is sent once every device has reported for the frame
+	void ReportTrackedDevice(USceneComponent * Device, const FBPVRComponentPosRep & NewTransform);
+
+	// True if the server has given the device a bundle slot, devices without one keep using their own rpcs
+	inline bool IsTrackedDeviceBundled(USceneComponent * Device) const
+	{
+		return bBundleTrackedDeviceReplication && BundledTrackedDevices.Contains(Device);
+	}
+
+	virtual void BeginPlay() override;
+
 	virtual void PreReplication(IRepChangedPropertyTracker & ChangedPropertyTracker) override;
 
+	// Scales how often each viewer gets this character (and so its tracked device poses) by distance and view direction
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VRBaseCharacter|Networking")
+		FBPVRNetPriorityPolicy NetPriorityPolicy;
+
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, class AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
 	// If true will replicate the capsule height on to clients, allows for dynamic capsule height changes in multiplayer
 	UPROPERTY(EditAnywhere, Replicated, BlueprintReadWrite, Category = "VRBaseCharacter")
 		bool VRReplicateCapsuleHeight;
@@ -721,4 +878,39 @@ public:
 			bool bUsePathfinding = true, bool bProjectDestinationToNavigation = true, bool bCanStrafe = false,
 			TSubclassOf<UNavigationQueryFilter> FilterClass = NULL, bool bAllowPartialPath = true);
 
+private:
+
+	// Slot order for the bundled tracked devices: camera, left, right, then any other grip controllers.
+	// Assigned by the server and replicated to the owner so both ends agree on it no matter how the devices were named or spawned.
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_BundledTrackedDevices)
+		TArray<USceneComponent *> BundledTrackedDevices;
+
+	// Bumped by the server every time the slot list changes, sent back with each bundle
+	UPROPERTY(Transient, Replicated)
+		uint16 BundledTrackedDeviceLayoutKey;
+
+	UFUNCTION()
+		void OnRep_BundledTrackedDevices();
+
+	// Server only, rebuilds the slot list if the devices changed
+	void GatherBundledTrackedDevices();
+	void ResetBundledTrackedDeviceSamples();
+	void SendBundledTrackedDevices();
+	bool HasStaleBundledTrackedDevice() const;
+
+	// Server side layout checks
+	float LastTrackedDeviceGatherTime;
+	bool bLoggedTrackedDeviceLayoutMismatch;
+
+	// Slots the owning client expects a report for, devices that haven't resolved on it yet are left out
+	uint32 ExpectedTrackedDeviceMask;
+
+	// Owning client bundle state
+	TArray<FBPVRComponentPosRep> SampledTrackedDevices;
+	TArray<FBPVRComponentPosRep> LastSentTrackedDevices;
+	TArray<float> LastSentTrackedDeviceTimes;
+	uint32 ReportedTrackedDeviceMask;
+	uint32 SentTrackedDeviceMask;
+	uint64 TrackedDeviceReportFrame;
+	float LastTrackedDeviceSendTime;
 };
\ No newline at end of file
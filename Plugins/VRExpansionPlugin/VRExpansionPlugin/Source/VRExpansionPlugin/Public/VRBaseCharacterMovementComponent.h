@@ -396,6 +396,92 @@ struct TStructOpsTypeTraits< FVRConditionalMoveRep2 > : public TStructOpsTypeTra
 	};
 };
 
+// A single saved move inside of a FVRServerMoveBatch, same values that ServerMoveVR takes
+struct VREXPANSIONPLUGIN_API FVRServerMoveBatchEntry
+{
+	float TimeStamp;
+	FVector Accel;
+	FVector CapsuleLoc;
+	FVRConditionalMoveRep ConditionalReps;
+	FVector LFDiff;
+	uint16 CapsuleYaw;
+	uint8 CompressedFlags;
+	uint16 ClientYaw;
+	uint16 ClientPitch;
+	uint8 ClientRoll;
+
+	FVRServerMoveBatchEntry()
+	{
+		TimeStamp = 0.0f;
+		Accel = FVector::ZeroVector;
+		CapsuleLoc = FVector::ZeroVector;
+		LFDiff = FVector::ZeroVector;
+		CapsuleYaw = 0;
+		CompressedFlags = 0;
+		ClientYaw = 0;
+		ClientPitch = 0;
+		ClientRoll = 0;
+	}
+};
+
+/**
+* Variable length batch of client moves sent in one RPC.
+* The first move is sent in full, every move after it is delta encoded against the first one.
+* Location, movement base and movement mode are only sent once as they are only checked for the last move.
+*/
+USTRUCT()
+struct VREXPANSIONPLUGIN_API FVRServerMoveBatch
+{
+	GENERATED_USTRUCT_BODY()
+public:
+
+	enum { MaxMoves = 16 };
+
+	TArray<FVRServerMoveBatchEntry> Moves;
+
+	// Location (absolute or base relative) of the last move, the only one that is error checked
+	UPROPERTY(Transient)
+		FVector ClientLoc;
+
+	UPROPERTY(Transient)
+		UPrimitiveComponent* ClientMovementBase;
+	UPROPERTY(Transient)
+		FName ClientBaseBoneName;
+
+	UPROPERTY(Transient)
+		uint8 ClientMovementMode;
+
+	FVRServerMoveBatch()
+	{
+		ClientLoc = FVector::ZeroVector;
+		ClientMovementBase = nullptr;
+		ClientBaseBoneName = NAME_None;
+		ClientMovementMode = 0;
+	}
+
+	// Fills out the per move view rotation and the batches base into a move rep for ServerMoveVR
+	void GetMoveReps(const FVRServerMoveBatchEntry& Move, FVRConditionalMoveRep2& OutMoveReps) const
+	{
+		OutMoveReps.ClientMovementBase = ClientMovementBase;
+		OutMoveReps.ClientBaseBoneName = ClientBaseBoneName;
+		OutMoveReps.ClientYaw = Move.ClientYaw;
+		OutMoveReps.ClientPitch = Move.ClientPitch;
+		OutMoveReps.ClientRoll = Move.ClientRoll;
+	}
+
+	/** Network serialization */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits< FVRServerMoveBatch > : public TStructOpsTypeTraitsBase2<FVRServerMoveBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
 /**
 * Helper to change mesh bone updates within a scope.
 * Example usage:
@@ -433,6 +519,58 @@ private:
 	EKinematicBonesUpdateToPhysics::Type SavedUpdateSetting;
 };
 
+/**
+* Last walkable floor result and the state it was computed in.
+* Roomscale players spend most of their time standing in place with only the HMD moving, this lets
+* ComputeFloorDist hand back the same floor while the capsule stays close to where it was found. A base that only translated
+* (lifts, moving platforms) carries the cached floor along with it, anything else about the base changing throws it out.
+*/
+struct VREXPANSIONPLUGIN_API FVRFloorCache
+{
+	FFindFloorResult FloorResult;
+	TWeakObjectPtr<UPrimitiveComponent> BaseComponent;
+	FTransform BaseTransform;
+	FVector CapsuleLocation;
+	float CapsuleHalfHeight;
+	float LineDistance;
+	float SweepDistance;
+	float SweepRadius;
+	float LastValidatedTime;
+	bool bIsValid;
+
+	FVRFloorCache()
+	{
+		Invalidate();
+	}
+
+	void Invalidate()
+	{
+		FloorResult.Clear();
+		BaseComponent.Reset();
+		BaseTransform = FTransform::Identity;
+		CapsuleLocation = FVector::ZeroVector;
+		CapsuleHalfHeight = 0.0f;
+		LineDistance = 0.0f;
+		SweepDistance = 0.0f;
+		SweepRadius = 0.0f;
+		LastValidatedTime = 0.0f;
+		bIsValid = false;
+	}
+
+	// Stores a walkable floor result, anything else clears the cache
+	void Store(const FFindFloorResult& NewFloor, const FVector& InCapsuleLocation, float InCapsuleHalfHeight, float InLineDistance, float InSweepDistance, float InSweepRadius, float CurrentTime);
+
+	// Moves the cached floor along with its base if the base translated since it was stored, bOutBaseMoved is set if it did.
+	// Returns false if the base is gone, stopped blocking queries or rotated / scaled, the cache can't be used then.
+	bool FollowBase(bool& bOutBaseMoved);
+
+	// Returns true if the cached floor was found with the same query setup and near this location
+	bool CanReuse(const FVector& InCapsuleLocation, float InCapsuleHalfHeight, float InLineDistance, float InSweepDistance, float InSweepRadius, float Tolerance) const;
+
+	// Returns the cached floor with its distances measured from the cached floor plane at the new capsule location
+	void GetFloorResult(const FVector& InCapsuleLocation, FFindFloorResult& OutFloorResult) const;
+};
+
 
 class VREXPANSIONPLUGIN_API FSavedMove_VRBaseCharacter : public FSavedMove_Character
 {
@@ -539,6 +677,93 @@ public:
 	virtual void PostUpdate(ACharacter* C, EPostUpdateMode PostUpdateMode) override;
 };
 
+// A single client move as it was performed on the owning client, recorded from its saved move so that it can be replayed later
+struct VREXPANSIONPLUGIN_API FVRRecordedMove
+{
+	float TimeStamp;
+	float DeltaTime;
+	FVector Acceleration;
+	uint8 CompressedFlags;
+	FRotator ControlRotation;
+
+	FVector VRCapsuleLocation;
+	FRotator VRCapsuleRotation;
+	FVector LFDiff;
+	FVRConditionalMoveRep ConditionalValues;
+
+	// Jump state at the start of the move, PrepMoveFor restores these onto the character
+	float JumpKeyHoldTime;
+	float JumpForceTimeRemaining;
+	int32 JumpMaxCount;
+	int32 JumpCurrentCount;
+	bool bForceMaxAccel;
+
+	// Where the client ended up after the move, the replay diffs against this
+	FVector EndLocation;
+
+	FVRRecordedMove();
+
+	void InitFromSavedMove(const FSavedMove_VRBaseCharacter& Move);
+	void CopyToSavedMove(FSavedMove_VRBaseCharacter& Move) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FVRRecordedMove& Move);
+};
+
+// A stream of recorded client moves and the state that the character started them in.
+// Recorded with vre.StartMovementRecording / vre.StopMovementRecording and played back with vre.ReplayMovementRecording.
+struct VREXPANSIONPLUGIN_API FVRMovementRecording
+{
+	FString MovementComponentClass;
+	FVector StartLocation;
+	FRotator StartRotation;
+	FVector StartVelocity;
+	uint8 StartMovementMode;
+	uint8 StartCustomMovementMode;
+	TArray<FVRRecordedMove> Moves;
+
+	FVRMovementRecording();
+
+	// Adds a move that was just performed, the first move also sets the start state
+	void AddMove(const FSavedMove_VRBaseCharacter& Move);
+
+	// The last recorded move was combined into the next one, which will be recorded in its place
+	void RemoveLastMove()
+	{
+		if (Moves.Num() > 0)
+		{
+			Moves.Pop(false);
+		}
+	}
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+
+	friend FArchive& operator<<(FArchive& Ar, FVRMovementRecording& Recording);
+};
+
+// What a replay of a recording measured
+struct VREXPANSIONPLUGIN_API FVRMovementReplayResult
+{
+	int32 NumMoves;
+	int32 Iterations;
+	double NanosecondsPerMove;
+	float SceneQueriesPerMove;
+
+	// Distance from where the client ended up, at the end of the last pass and the worst single move
+	float FinalPositionError;
+	float MaxPositionError;
+
+	FVRMovementReplayResult()
+	{
+		NumMoves = 0;
+		Iterations = 0;
+		NanosecondsPerMove = 0.0;
+		SceneQueriesPerMove = 0.0f;
+		FinalPositionError = 0.0f;
+		MaxPositionError = 0.0f;
+	}
+};
+
 // Using this fixes the problem where the character capsule isn't reset after a scoped movement update revert (pretty much just in StepUp operations)
 class VREXPANSIONPLUGIN_API FVRCharacterScopedMovementUpdate : public FScopedMovementUpdate
 {
@@ -695,6 +920,9 @@ public:
 	virtual void PhysCustom_LowGrav(float deltaTime, int32 Iterations);
 
 
+	// Throws out the floor cache before the corrected moves are replayed
+	virtual void ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+
 	// Skip updates with rotational differences
 	virtual void SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation) override;
 
@@ -737,6 +965,59 @@ public:
 
 	virtual void ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult = NULL) const override;
 
+	// The full floor sweep / line trace, ComputeFloorDist calls into this when the floor cache can't be used
+	void ComputeFloorDist_Uncached(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult = NULL) const;
+
+	// If true will reuse the last walkable floor while the capsule stays within FloorCacheTolerance of where it was found
+	// and the floors component hasn't moved. Cuts the per tick floor queries for players standing in place (client and server).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRMovement|FloorCache")
+		bool bUseFloorCache;
+
+	// Distance the capsule can drift from the cached location (HMD wobble) before a full floor check is run again
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRMovement|FloorCache", meta = (ClampMin = "0.0", UIMin = "0.0"))
+		float FloorCacheTolerance;
+
+	// Seconds the cached floor is trusted without any query, after that it is revalidated with a single line trace.
+	// Defaults to 0, revalidating every check, which still skips the capsule sweeps. Anything higher trusts the floor blind
+	// for that long, only a moved, destroyed or no longer blocking floor component or a net correction throws it out sooner.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRMovement|FloorCache", meta = (ClampMin = "0.0", UIMin = "0.0"))
+		float FloorCacheRevalidationInterval;
+
+	mutable FVRFloorCache FloorCache;
+
+	// Throws out the cached floor, the next floor check will be a full one
+	UFUNCTION(BlueprintCallable, Category = "VRMovement|FloorCache")
+	void InvalidateFloorCache()
+	{
+		FloorCache.Invalidate();
+	}
+
+	// Line traces down to confirm that the cached floor is still under the capsule
+	bool RevalidateFloorCache(const FVector& CapsuleLocation, float CapsuleHalfHeight) const;
+
+	// Moves from this character are added to this while it is valid, see StartMovementRecording
+	TSharedPtr<FVRMovementRecording> MovementRecording;
+
+	// Starts recording the moves that this (locally controlled) character performs
+	void StartMovementRecording();
+
+	// Stops recording and returns what was recorded, if anything
+	TSharedPtr<FVRMovementRecording> StopMovementRecording();
+
+	// Plays a recording back against this character through the same PrepMoveFor / MoveAutonomous path that client replays use.
+	// Runs synchronously from the recorded start state, meant for standalone games (-nullrhi benchmark maps), not networked sessions.
+	virtual bool ReplayMovementRecording(const FVRMovementRecording& Recording, int32 Iterations, FVRMovementReplayResult& OutResult);
+
+	// Scene queries issued by this components VR movement code (floor checks, sweeping moves and the plugins own traces).
+	// Per component so that other characters moving in the same frame don't show up in it, the replay samples it around each move.
+	mutable uint32 SceneQueryCounter;
+
+	FORCEINLINE bool CountSceneQuery(bool bResult) const
+	{
+		SceneQueryCounter++;
+		return bResult;
+	}
+
 	// Need to use actual capsule location for step up
 	virtual bool VRClimbStepUp(const FVector& GravDir, const FVector& Delta, const FHitResult &InHit, FStepDownResult* OutStepDownResult = nullptr);
 
@@ -839,5 +1120,10 @@ public:
 
 		Super::ClientVeryShortAdjustPosition_Implementation(TimeStamp, NewLoc, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
 	}
+
+protected:
+
+	// Counts sweeping moves for SceneQueryCounter
+	virtual bool MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit = NULL, ETeleportType Teleport = ETeleportType::None) override;
 };
 
@@ -45,6 +45,93 @@ DECLARE_LOG_CATEGORY_EXTERN(LogVRCharacterMovement, Log, All);
 
 //DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FAIMoveCompletedSignature, FAIRequestID, RequestID, EPathFollowingResult::Type, Result);
 
+// Why the server decided that a client needed a correction
+enum class EVRMovementCorrectionReason : uint8
+{
+	None,			// An override of ServerCheckClientErrorVR returned true without giving a reason
+	LocationError,	// ExceedsAllowablePositionError
+	ForcedPercent,	// p.NetForceClientAdjustmentPercent
+	MovementMode,	// Client and server movement mode disagreed
+	YawRollback,	// Client yaw was rolled back (bUseClientControlRotation off)
+	ForcedUpdate,	// ServerData->bForceClientUpdate
+	Count
+};
+
+// Correction counters for a single character, only gathered while vre.MovementCorrectionTelemetry is on.
+// The server side counts checks and corrections, the owning client side counts received adjustments and the moves it replayed for them.
+struct VREXPANSIONPLUGIN_API FVRMovementCorrectionTelemetry
+{
+	// Location error buckets, each upper bound is double the last starting at 1cm, the last bucket is everything past 64cm
+	static const int32 NumErrorBuckets = 8;
+
+	uint32 ServerMovesChecked;
+	uint32 Corrections[(uint8)EVRMovementCorrectionReason::Count];
+	uint32 ErrorHistogram[NumErrorBuckets];
+	float MaxError;
+	double TotalError;
+
+	// Corrections that SendClientAdjustment actually sent vs dropped to the time between adjustments limits
+	uint32 AdjustmentsSent;
+	uint32 AdjustmentsThrottled;
+
+	uint32 AdjustmentsReceived;
+	uint32 ReplayedMoves;
+	uint32 MaxReplayedMoves;
+
+	double StartTime;
+
+	FVRMovementCorrectionTelemetry()
+	{
+		Reset(0.0);
+	}
+
+	void Reset(double CurrentTime)
+	{
+		FMemory::Memzero(this, sizeof(FVRMovementCorrectionTelemetry));
+		StartTime = CurrentTime;
+	}
+
+	static int32 GetErrorBucket(float Error)
+	{
+		int32 Bucket = 0;
+		for (float UpperBound = 1.0f; Bucket < NumErrorBuckets - 1 && Error > UpperBound; UpperBound *= 2.0f)
+		{
+			Bucket++;
+		}
+
+		return Bucket;
+	}
+
+	uint32 GetTotalCorrections() const
+	{
+		uint32 Total = 0;
+		for (uint8 i = 0; i < (uint8)EVRMovementCorrectionReason::Count; i++)
+		{
+			Total += Corrections[i];
+		}
+
+		return Total;
+	}
+
+	void RecordCorrection(EVRMovementCorrectionReason Reason, float Error)
+	{
+		Corrections[(uint8)Reason]++;
+		ErrorHistogram[GetErrorBucket(Error)]++;
+		MaxError = FMath::Max(MaxError, Error);
+		TotalError += Error;
+	}
+
+	void RecordReplay(int32 NumMoves)
+	{
+		AdjustmentsReceived++;
+		ReplayedMoves += NumMoves;
+		MaxReplayedMoves = FMath::Max(MaxReplayedMoves, (uint32)NumMoves);
+	}
+
+	// Single block summary for the log, SessionTime is how long the counters have been running
+	FString ToString(double SessionTime) const;
+};
+
 UCLASS()
 class VREXPANSIONPLUGIN_API UVRCharacterMovementComponent : public UVRBaseCharacterMovementComponent
 {
@@ -146,6 +233,18 @@ public:
 	*/
 	virtual bool ServerCheckClientErrorVR(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, float ClientYaw, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode);
 
+	// Set by ServerCheckClientErrorVR so that the caller can tell why it wanted a correction and how far off the client was
+	EVRMovementCorrectionReason LastCorrectionReason;
+	float LastClientLocationError;
+
+	// Correction counters for this character, see vre.MovementCorrectionTelemetry
+	FVRMovementCorrectionTelemetry CorrectionTelemetry;
+
+	// Logs the telemetry summary for this character
+	void DumpCorrectionTelemetry() const;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Replicate position correction to client, associated with a timestamped servermove.  Client will replay subsequent moves after applying adjustment.  */
 	virtual void ClientAdjustPositionVR(float TimeStamp, FVector NewLoc, uint16 NewYaw, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode);
 	virtual void ClientAdjustPositionVR_Implementation(float TimeStamp, FVector NewLoc, uint16 NewYaw, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode);
@@ -208,6 +307,31 @@ public:
 	virtual void ServerMoveVRDualHybridRootMotion_Implementation(float TimeStamp0, FVector_NetQuantize10 InAccel0, uint8 PendingFlags, uint32 View0, FVector_NetQuantize100 OldCapsuleLoc, FVRConditionalMoveRep OldConditionalReps, FVector_NetQuantize100 OldLFDiff, uint16 OldCapsuleYaw, float TimeStamp, FVector_NetQuantize10 InAccel, FVector_NetQuantize100 ClientLoc, FVector_NetQuantize100 CapsuleLoc, FVRConditionalMoveRep ConditionalReps, FVector_NetQuantize100 LFDiff, uint16 CapsuleYaw, uint8 NewFlags, FVRConditionalMoveRep2 MoveReps, uint8 ClientMovementMode);
 	virtual bool ServerMoveVRDualHybridRootMotion_Validate(float TimeStamp0, FVector_NetQuantize10 InAccel0, uint8 PendingFlags, uint32 View0, FVector_NetQuantize100 OldCapsuleLoc, FVRConditionalMoveRep OldConditionalReps, FVector_NetQuantize100 OldLFDiff, uint16 OldCapsuleYaw, float TimeStamp, FVector_NetQuantize10 InAccel, FVector_NetQuantize100 ClientLoc, FVector_NetQuantize100 CapsuleLoc, FVRConditionalMoveRep ConditionalReps, FVector_NetQuantize100 LFDiff, uint16 CapsuleYaw, uint8 NewFlags, FVRConditionalMoveRep2 MoveReps, uint8 ClientMovementMode);
 
+	/** Replicated function sent by client to server - contains a variable length batch of moves, only the last one is error checked. */
+	//UFUNCTION(unreliable, server, WithValidation)
+	virtual void ServerMoveVRBatch(const FVRServerMoveBatch& MoveBatch);
+	virtual void ServerMoveVRBatch_Implementation(const FVRServerMoveBatch& MoveBatch);
+	virtual bool ServerMoveVRBatch_Validate(const FVRServerMoveBatch& MoveBatch);
+
+	// If true the client holds its moves and sends them to the server in batches (ServerMoveVRBatch) instead of one or two per RPC.
+	// Cuts RPC count at high frame rates, the server applies the whole batch and only error checks the last move.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRCharacterMovementComponent|Networking")
+	bool bUseServerMoveBatching;
+
+	// Most moves to hold in a batch before sending it regardless of the send interval
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRCharacterMovementComponent|Networking", meta = (ClampMin = "2", UIMin = "2", ClampMax = "16", UIMax = "16"))
+	int32 MaxServerMoveBatchSize;
+
+	// Seconds to hold moves for before sending a batch, 0 uses the normal net move send rate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRCharacterMovementComponent|Networking", meta = (ClampMin = "0.0", UIMin = "0.0", ClampMax = "0.2", UIMax = "0.2"))
+	float ServerMoveBatchInterval;
+
+	// Client side moves waiting to go out in the next batch
+	TArray<FSavedMovePtr> PendingBatchMoves;
+
+	// Sends everything in PendingBatchMoves as a single ServerMoveVRBatch
+	void CallServerMoveBatch(const class FSavedMove_Character* OldMove);
+
 	FNetworkPredictionData_Client* GetPredictionData_Client() const override;
 	FNetworkPredictionData_Server* GetPredictionData_Server() const override;
 
@@ -243,6 +367,13 @@ public:
 	// This is here to force it to call the correct SafeMoveUpdatedComponent functions for floor movement
 	virtual void MoveAlongFloor(const FVector& InVelocity, float DeltaSeconds, FStepDownResult* OutStepDownResult) override;
 
+	// True while the root components HMD movement sweep is waiting to be resolved by the first walking move sweep
+	bool bResolveDeferredVRRelativeMovement;
+
+	// Uses the walking move sweep (which already contains the HMD delta) in place of the root components relative movement sweep.
+	// Returns true if the HMD portion was let through unswept, in which case it is removed from InOutDelta.
+	bool ResolveDeferredVRRelativeMovement(const FHitResult& MoveHit, FVector& InOutDelta);
+
 	// Modify for correct location
 	virtual void ApplyRepulsionForce(float DeltaSeconds) override;
 
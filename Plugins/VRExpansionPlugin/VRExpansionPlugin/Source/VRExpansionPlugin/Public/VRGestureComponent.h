@@ -14,6 +14,7 @@
 #include "Engine/EngineTypes.h"
 #include "VRGestureComponent.generated.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogVRGesture, Log, All);
 DECLARE_STATS_GROUP(TEXT("TICKGesture"), STATGROUP_TickGesture, STATCAT_Advanced);
 
 
@@ -62,6 +63,15 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRGesture|Advanced")
 		bool bEnabled;
 
+	// If enabled this gesture is matched with FastDTW (solve at a coarser resolution, then refine around the projected warp path)
+	// Much cheaper for long gestures, but it can miss the best warp that the full table would find
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRGesture|Advanced")
+		bool bUseFastDTW;
+
+	// How many samples around the projected warp path FastDTW refines in, larger is more accurate but slower
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRGesture|Advanced", meta = (ClampMin = "0", EditCondition = "bUseFastDTW"))
+		int FastDTWRadius;
+
 	FVRGestureSettings()
 	{
 		Minimum_Gesture_Length = 1;
@@ -69,6 +79,8 @@ public:
 		FullThreshold = 20.0f;
 		MirrorMode = EVRGestureMirrorMode::GES_NoMirror;
 		bEnabled = true;
+		bUseFastDTW = false;
+		FastDTWRadius = 4;
 	}
 };
 
@@ -130,6 +142,246 @@ public:
 	}
 };
 
+// Compact network form of a detected gestures samples, sent to the server so that it can verify the detection itself.
+// Samples are quantized to 0.01 and sent as deltas from the sample before them with SerializePackedVector, which only spends the bits
+// each delta needs. The quantization error never accumulates as the sender builds each delta from the already quantized previous sample.
+USTRUCT()
+struct VREXPANSIONPLUGIN_API FVRGestureSampleRep
+{
+	GENERATED_BODY()
+public:
+
+	// Samples newest first, same as the gesture log
+	UPROPERTY(Transient)
+	TArray<FVector> Samples;
+
+	// Bounds the client scaled the samples with, the log keeps the bounds of samples that have already been popped off
+	UPROPERTY(Transient)
+	FBox GestureSize;
+
+	// Servers throw out anything longer than this, well past the sample buffer sizes detection is run with.
+	// Detections with a longer log aren't sent for verification at all.
+	static const int MaxSamples = 256;
+
+	// Largest error the quantization can put on a sample, half a step on each axis
+	static const float MaxQuantizationError;
+
+	FVRGestureSampleRep()
+	{
+		GestureSize.Init();
+	}
+
+	// Fills in from a gesture log, quantizing the samples the same way NetSerialize will
+	void SetFromGesture(const FVRGesture & Gesture);
+
+	// Fills a gesture from the received samples, returns false if the data can't have come from a real gesture log
+	bool ToGesture(FVRGesture & OutGesture) const;
+
+	/** Network serialization */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits< FVRGestureSampleRep > : public TStructOpsTypeTraitsBase2<FVRGestureSampleRep>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+// Structure of arrays copy of a gestures samples, padded with zeros out to the vector register width
+// so that a full row of the DTW distance matrix can be computed in one pass.
+struct VREXPANSIONPLUGIN_API FVRGestureSampleSoA
+{
+	TArray<float, TAlignedHeapAllocator<16>> X;
+	TArray<float, TAlignedHeapAllocator<16>> Y;
+	TArray<float, TAlignedHeapAllocator<16>> Z;
+
+	// Actual sample count, the arrays are padded up to a multiple of 4
+	int SampleCount;
+
+	// HashSamples of the samples this was built from, catches in place edits that keep the sample count
+	uint32 SampleHash;
+
+	FVRGestureSampleSoA()
+	{
+		SampleCount = 0;
+		SampleHash = 0;
+	}
+
+	static int GetPaddedCount(int Count)
+	{
+		return Align(Count, 4);
+	}
+
+	static uint32 HashSamples(const TArray<FVector> & Samples)
+	{
+		return FCrc::MemCrc32(Samples.GetData(), Samples.Num() * sizeof(FVector));
+	}
+
+	inline bool IsBuiltFrom(const TArray<FVector> & Samples) const
+	{
+		return SampleCount == Samples.Num() && SampleHash == HashSamples(Samples);
+	}
+
+	void Build(const TArray<FVector> & Samples);
+
+	// Writes FVector::DistSquared(Sample, Samples[j]) for every sample into OutDistances (16 byte aligned, GetPaddedCount(SampleCount) long).
+	// Mirroring the gesture on Y is the same as mirroring the input sample on Y, so callers flip Sample.Y instead of keeping a mirrored copy.
+	void GetRowDistances(const FVector & Sample, float * OutDistances) const;
+};
+
+// The DTW matching logic and its scratch buffers, kept out of the component so that it can be run off of the game thread.
+// Not thread safe, each thread matching at the same time needs its own matcher.
+struct VREXPANSIONPLUGIN_API FVRGestureMatcher
+{
+	// Maximum vertical or horizontal steps in a row in the lookup table before throwing out a gesture
+	int maxSlope;
+
+	// If a gesture is set to match this value then detection will mirror the gesture
+	EVRGestureMirrorMode MirroringHand;
+
+	// Score the candidates that pass the first sample check across task graph workers instead of one after another
+	bool bParallelScoring;
+
+	// Added to every gestures first and full thresholds (in scaled units) before squaring them.
+	// Server verification sets it to the error bound of the network quantization so the client's own match still passes.
+	float ThresholdSlack;
+
+	FVRGestureMatcher()
+	{
+		maxSlope = 3;
+		MirroringHand = EVRGestureMirrorMode::GES_NoMirror;
+		bParallelScoring = false;
+		ThresholdSlack = 0.f;
+		DTWEnvelopeInputCount = 0;
+	}
+
+	inline float GetFirstThresholdSq(const FVRGesture & exampleGesture) const
+	{
+		return FMath::Square(exampleGesture.GestureSettings.firstThreshold + ThresholdSlack);
+	}
+
+	inline float GetFullThresholdSq(const FVRGesture & exampleGesture) const
+	{
+		return FMath::Square(exampleGesture.GestureSettings.FullThreshold + ThresholdSlack);
+	}
+
+	static inline float GetGestureDistance(const FVector & Seq1, const FVector & Seq2, bool bMirrorGesture = false)
+	{
+		if (bMirrorGesture)
+		{
+			return FVector::DistSquared(Seq1, FVector(Seq2.X, -Seq2.Y, Seq2.Z));
+		}
+
+		return FVector::DistSquared(Seq1, Seq2);
+	}
+
+	// Distance from a gesture sample to the closest point of an envelope box, never larger than GetGestureDistance to any point inside of it
+	static inline float GetEnvelopeDistance(const FVector & EnvelopeMin, const FVector & EnvelopeMax, FVector Sample, bool bMirrorGesture = false)
+	{
+		if (bMirrorGesture)
+			Sample.Y = -Sample.Y;
+
+		FVector Clamped(
+			FMath::Clamp(Sample.X, EnvelopeMin.X, EnvelopeMax.X),
+			FMath::Clamp(Sample.Y, EnvelopeMin.Y, EnvelopeMax.Y),
+			FMath::Clamp(Sample.Z, EnvelopeMin.Z, EnvelopeMax.Z)
+		);
+
+		return FVector::DistSquared(Clamped, Sample);
+	}
+
+	// Finds the best matching gesture for the input, returns INDEX_NONE if none pass their thresholds.
+	// SampleCache is optional, any entry that doesn't line up with its gesture falls back to scalar distances.
+	int FindBestMatch(const FVRGesture & inputGesture, const TArray<FVRGesture> & Gestures, float TargetGestureScale, const TArray<FVRGestureSampleSoA> * SampleCache = nullptr);
+
+	// Compute the min DTW distance between seq2 and all possible endings of seq1.
+	// If AbandonAbove is set, stops early once every remaining ending is guaranteed to be >= AbandonAbove after dividing by seq2's sample count.
+	// If Seq2SoA is passed in (must match seq2's samples) the rows of distances come from the vectorized kernel instead of per cell.
+	float dtw(const FVRGesture & seq1, const FVRGesture & seq2, bool bMirrorGesture = false, float Scaler = 1.f, float AbandonAbove = MAX_FLT, const FVRGestureSampleSoA * Seq2SoA = nullptr);
+
+	// Approximates dtw() with FastDTW, the sequences are halved until one is within Radius + 2 samples, solved there and then each
+	// finer level only evaluates the cells within Radius of the warp path projected up from the level below it.
+	float fastdtw(const FVRGesture & seq1, const FVRGesture & seq2, bool bMirrorGesture = false, float Scaler = 1.f, int Radius = 4);
+
+	// Builds the envelope of the scaled input that RejectByLowerBound checks against
+	void BuildInputEnvelope(const FVRGesture & inputGesture, float Scaler);
+
+	// Starts an empty envelope for an input of InputSampleCount samples, ExtendInputEnvelope then fills it in as far as it is needed
+	void ResetInputEnvelope(int InputSampleCount);
+
+	// Extends the envelope of the scaled input to its first RowCount samples, does nothing if it already covers them.
+	// A gesture only ever bounds against GetDTWBandRowCount(its sample count, input count) rows so short gestures need only a prefix.
+	void ExtendInputEnvelope(const FVRGesture & inputGesture, float Scaler, int RowCount);
+
+	// Runs the lower bound cascade (last point, then envelope) for a gesture against the envelope built for the current input.
+	// Returns true if its dtw() cost divided by its sample count is guaranteed to be >= Limit, so the full dtw can be skipped.
+	bool RejectByLowerBound(const FVRGesture & exampleGesture, bool bMirrorGesture, float Limit);
+
+private:
+
+	// Parallel version of FindBestMatch's loop, candidates are scored with per batch matchers and reduced in gesture order so
+	// ties pick the same index as the serial loop. Each batch matcher builds only the envelope prefix its own candidates need.
+	int FindBestMatchParallel(const FVRGesture & inputGesture, const TArray<FVRGesture> & Gestures, float Scaler, const TArray<FVRGestureSampleSoA> * SampleCache);
+
+	// Runs dtw or fastdtw depending on the gestures settings
+	float GetMatchCost(const FVRGesture & inputGesture, const FVRGesture & exampleGesture, bool bMirrorGesture, float Scaler, float Limit, const FVRGestureSampleSoA * ExampleSoA);
+
+	// Solves the DTW recurrence for Input against Example (1 based rows / columns) inside the window in FastDTWRowLo / FastDTWRowHi.
+	// If bBuildPath is set the best warp path is backtracked into FastDTWPath.
+	float SolveWindowedDTW(const TArray<FVector> & Input, const TArray<FVector> & Example, bool bBuildPath);
+
+	// Projects FastDTWPath up one resolution level and widens it by Radius into the window for the next SolveWindowedDTW
+	void ProjectFastDTWWindow(int RowCount, int ColumnCount, int Radius);
+
+	// Number of input samples (from the newest) that the warp path can reach by the given example column, derived from maxSlope.
+	// Vertical runs are capped at maxSlope so a column can only advance maxSlope + 1 rows past the last one.
+	int GetDTWBandRowCount(int Column, int InputSampleCount) const
+	{
+		int64 Reach = (int64)Column * ((int64)FMath::Max(maxSlope, 0) + 1);
+		return (int)FMath::Min<int64>(Reach, InputSampleCount);
+	}
+
+	// Running min / max of the scaled input samples from the newest one back, reset once per recognition pass.
+	// Index N is the envelope of the first N + 1 samples, only the rows that a gesture has needed so far are filled in.
+	TArray<FVector> DTWEnvelopeMin;
+	TArray<FVector> DTWEnvelopeMax;
+
+	// Sample count of the input the envelope is for
+	int DTWEnvelopeInputCount;
+
+	// Rolling rows of the DTW lookup / slope tables, kept between calls so that detection doesn't hit the heap every tick.
+	// Each holds two rows (previous and current) of (seq2.Samples.Num() + 1) entries and only ever grows.
+	TArray<float> DTWLookupRows;
+	TArray<int> DTWSlopeIRows;
+	TArray<int> DTWSlopeJRows;
+
+	// Distances from the current input sample to every example sample
+	TArray<float, TAlignedHeapAllocator<16>> DTWRowDistances;
+
+	// FastDTW scratch, sequences per resolution level (finest first) and the packed window being solved
+	TArray<TArray<FVector>> FastDTWInputLevels;
+	TArray<TArray<FVector>> FastDTWExampleLevels;
+	TArray<int> FastDTWRowLo;
+	TArray<int> FastDTWRowHi;
+	TArray<int> FastDTWRowOffset;
+	TArray<int> FastDTWWidenLo;
+	TArray<int> FastDTWWidenHi;
+	TArray<float> FastDTWLookup;
+	TArray<int> FastDTWSlopeI;
+	TArray<int> FastDTWSlopeJ;
+	TArray<uint8> FastDTWSteps;
+	TArray<FIntPoint> FastDTWPath;
+
+	// Parallel scoring scratch, the candidate gesture indices (negative for mirrored as ~Index), their costs and one matcher per batch
+	TArray<int> ParallelCandidates;
+	TArray<float> ParallelCosts;
+	TArray<bool> ParallelRejected;
+	TArray<FVRGestureMatcher> ParallelMatchers;
+};
+
 /**
 * Items Database DataAsset, here we can save all of our game items
 */
@@ -149,8 +401,62 @@ public:
 	UGesturesDatabase()
 	{
 		TargetGestureScale = 100.0f;
+		GestureRevision = 0;
+		SampleCacheRevision = -1;
 	}
 
+	// SoA copies of each gestures samples for the distance kernel, rebuilt on load, edit and RecalculateGestures.
+	// If you change Gestures at runtime call MarkGesturesDirty (or RecalculateGestures) afterwards, sample edits that weren't
+	// marked are still caught by a hash check before each match but changes to the order or types are not.
+	TArray<FVRGestureSampleSoA> SampleCache;
+
+	// Bumped by MarkGesturesDirty, the sample cache is rebuilt when it was built against an older revision
+	int32 GestureRevision;
+	int32 SampleCacheRevision;
+
+	// Call after editing Gestures directly (samples, order or types) so that the sample cache and type index are rebuilt before the next match
+	UFUNCTION(BlueprintCallable, Category = "VRGestures")
+	void MarkGesturesDirty()
+	{
+		++GestureRevision;
+	}
+
+	// Returns the SoA copies of the gestures, rebuilding them if the gestures were marked dirty or are clearly out of date
+	const TArray<FVRGestureSampleSoA> & EnsureSampleCache();
+
+	void RebuildSampleCache();
+
+	// Gesture indices grouped by GestureType, rebuilt along with the sample cache
+	TMap<uint8, TArray<int>> GestureTypeIndex;
+
+	// Gets the indices of every gesture in the database with the given GestureType
+	UFUNCTION(BlueprintCallable, Category = "VRGestures")
+	void GetGesturesOfType(uint8 GestureType, TArray<int> & OutGestureIndices);
+
+	// Writes the database to a cooked binary file: samples pre-normalized to TargetGestureScale and stored as 16 byte aligned
+	// SoA blocks, per gesture bounds and settings, and an index of the gestures by GestureType.
+	UFUNCTION(BlueprintCallable, Category = "VRGestures")
+	bool SaveCookedGestures(const FString & FilePath);
+
+	// Loads a cooked binary file from SaveCookedGestures into a new transient database owned by Outer, returns null on failure.
+	// The file is pulled in with a single read and the sample cache is filled straight from it, no rescaling is done.
+	// Never writes into an existing database so a shared asset can't be dirtied at runtime.
+	UFUNCTION(BlueprintCallable, Category = "VRGestures")
+	static UGesturesDatabase * LoadCookedGestures(UObject * Outer, const FString & FilePath);
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+
+	// Fills this database from a cooked file, only called on the fresh transient database from LoadCookedGestures
+	bool ReadCookedGestures(const FString & FilePath);
+
+public:
+
 	// Recalculate size of gestures and re-scale them to the TargetGestureScale
 	UFUNCTION(BlueprintCallable, Category = "VRGestures")
 	void RecalculateGestures()
@@ -159,6 +465,8 @@ public:
 		{
 			Gestures[i].CalculateSizeOfGesture(true, TargetGestureScale);
 		}
+
+		RebuildSampleCache();
 	}
 
 	// Fills a spline component with a gesture, optionally also generates spline mesh components for it (uses ones already attached if possible)
@@ -256,6 +564,7 @@ public:
 
 		NewGesture.CalculateSizeOfGesture(true, this->TargetGestureScale);
 		Gestures.Add(NewGesture);
+		MarkGesturesDirty();
 		return true;
 	}
 };
@@ -267,45 +576,55 @@ struct VREXPANSIONPLUGIN_API FVRGestureSplineDraw
 	GENERATED_BODY()
 public:
 
-	UPROPERTY()
-	USplineComponent* SplineComponent;
-
+	// Pool of registered spline meshes used as a ring buffer, one segment per drawn sample.
+	// Filled in by Init and only grows if a later recording asks for a larger buffer.
 	UPROPERTY()
 	TArray<USplineMeshComponent*> SplineMeshes;
 
-	int LastIndexSet;
-	int NextIndexCleared;
+	// Ring slot of the oldest drawn sample and the number of samples drawn, the newest is at (HeadIndex + DrawnCount - 1) % RingSize.
+	// RingSize is the buffer size of the current recording, the pool can hold more meshes than that from an earlier one.
+	int HeadIndex;
+	int DrawnCount;
+	int RingSize;
+
+	// Newest drawn sample, the next sample finishes its segment
+	FVector LastPoint;
 
-	// Marches through the array and clears the last point
+	// Makes sure that the pool holds Capacity registered meshes, hides any drawn segments and sets them all up for a new recording.
+	// This is the only place that creates or registers components, drawing samples afterwards only updates existing ones.
+	void Init(USceneComponent * Owner, int Capacity, UStaticMesh * Mesh, UMaterialInterface * Material, USceneComponent * AttachParent, const FTransform & MeshTransform);
+
+	// Draws a new sample, dropping the oldest one if the ring is full. Returns the mesh it was drawn with or nullptr if there is no pool.
+	USplineMeshComponent * AddPoint(const FVector & NewPoint, bool bCurved);
+
+	// Hides the oldest drawn segment
 	void ClearLastPoint()
 	{
-		SplineComponent->RemoveSplinePoint(0, false);
+		if (DrawnCount < 1 || RingSize < 1)
+			return;
 
-		if (SplineMeshes.Num() < NextIndexCleared + 1)
-			NextIndexCleared = 0;
+		if (SplineMeshes[HeadIndex] != nullptr)
+			SplineMeshes[HeadIndex]->SetVisibility(false);
 
-		SplineMeshes[NextIndexCleared]->SetVisibility(false);
-		NextIndexCleared++;
+		HeadIndex = (HeadIndex + 1) % RingSize;
+		DrawnCount--;
 	}
 
-	// Hides all spline meshes and re-inits the spline component
+	// Hides the drawn segments, the pool is kept
 	void Reset()
 	{
-		if(SplineComponent != nullptr)
-			SplineComponent->ClearSplinePoints(true);
-
-		for (int i = SplineMeshes.Num() - 1; i >= 0; --i)
+		for (int i = 0; i < DrawnCount && RingSize > 0; ++i)
 		{
-			if (SplineMeshes[i] != nullptr)
-				SplineMeshes[i]->SetVisibility(false);
-			else
-				SplineMeshes.RemoveAt(i);
+			USplineMeshComponent * MeshComp = SplineMeshes[(HeadIndex + i) % RingSize];
+			if (MeshComp != nullptr)
+				MeshComp->SetVisibility(false);
 		}
 
-		LastIndexSet = 0;
-		NextIndexCleared = 0;
+		HeadIndex = 0;
+		DrawnCount = 0;
 	}
 
+	// Destroys the pool
 	void Clear()
 	{
 		for (int i = 0; i < SplineMeshes.Num(); ++i)
@@ -318,21 +637,17 @@ public:
 		}
 		SplineMeshes.Empty();
 
-		if (SplineComponent != nullptr)
-		{
-			SplineComponent->DestroyComponent();
-			SplineComponent = nullptr;
-		}
-
-		LastIndexSet = 0;
-		NextIndexCleared = 0;
+		HeadIndex = 0;
+		DrawnCount = 0;
+		RingSize = 0;
 	}
 
 	FVRGestureSplineDraw()
 	{
-		SplineComponent = nullptr;
-		NextIndexCleared = 0;
-		LastIndexSet = 0;
+		HeadIndex = 0;
+		DrawnCount = 0;
+		RingSize = 0;
+		LastPoint = FVector::ZeroVector;
 	}
 
 	~FVRGestureSplineDraw()
@@ -341,9 +656,14 @@ public:
 	}
 };
 
+class FVRGestureAsyncDetector;
+
 /** Delegate for notification when the lever state changes. */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FVRGestureDetectedSignature, uint8, GestureType, FString, DetectedGestureName, int, DetectedGestureIndex, UGesturesDatabase *, GestureDataBase);
 
+/** Delegate for notification when the server has checked a detected gesture. */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FiveParams(FVRGestureVerifiedSignature, bool, bVerified, uint8, GestureType, FString, DetectedGestureName, int, DetectedGestureIndex, UGesturesDatabase *, GestureDataBase);
+
 /**
 * A scene component that can sample its positions to record / track VR gestures
 * Core code is from https://social.msdn.microsoft.com/Forums/en-US/4a428391-82df-445a-a867-557f284bd4b1/dynamic-time-warping-to-recognize-gestures?forum=kinectsdk
@@ -359,6 +679,8 @@ class VREXPANSIONPLUGIN_API UVRGestureComponent : public USceneComponent
 public:
 	UVRGestureComponent(const FObjectInitializer& ObjectInitializer);
 
+	virtual void OnRegister() override;
+
 
 	// Size of obeservations vectors.
 	//int dim; // Not needed, this is just dimensionality
@@ -425,6 +747,45 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRGestures")
 	int maxSlope;
 
+	// If true detection runs on a task graph worker, captured samples are queued to it and detections are broadcast back on the game thread.
+	// The worker matches against a copy of GesturesDB taken in BeginRecording, changes to the database apply on the next BeginRecording.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRGestures")
+	bool bDetectGesturesAsync;
+
+	// If true the gestures that pass the first sample check are scored in parallel across task graph workers.
+	// Worth it for large databases, the detected gesture is the same as with serial scoring.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRGestures")
+	bool bScoreGesturesInParallel;
+
+	// If true, detections on a client are sent up to the server along with their samples and the server re-runs the match against its own
+	// GesturesDB (with its own maxSlope and MirroringHand). OnGestureVerified_Bind fires on the server and on the owning client with the result.
+	// The component is set to replicate on register when this is on so that it can send the RPCs, it only sends data when a detection fires.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "VRGestures|Replication")
+	bool bVerifyGesturesOnServer;
+
+	// Called with the servers verdict on a detected gesture, on the server and on the owning client
+	UPROPERTY(BlueprintAssignable, Category = "VRGestures|Replication")
+	FVRGestureVerifiedSignature OnGestureVerified_Bind;
+
+	// Size in bits of the last verification request that this client sent
+	UPROPERTY(BlueprintReadOnly, Category = "VRGestures|Replication")
+	int LastVerificationBits;
+
+	// Total bits and count of the verification requests this client has sent, for averaging
+	UPROPERTY(BlueprintReadOnly, Category = "VRGestures|Replication")
+	int TotalVerificationBits;
+
+	UPROPERTY(BlueprintReadOnly, Category = "VRGestures|Replication")
+	int VerificationCount;
+
+	// Sends a detected gesture to the server for verification, anything over FVRGestureSampleRep::MaxSamples fails validation
+	UFUNCTION(Reliable, Server, WithValidation)
+	void Server_VerifyGesture(int GestureIndex, const FVRGestureSampleRep & GestureSamples);
+
+	// Returns the servers verdict to the owning client
+	UFUNCTION(Reliable, Client)
+	void Client_GestureVerified(int GestureIndex, bool bVerified);
+
 	UPROPERTY(BlueprintReadOnly, Category = "VRGestures")
 	EVRGestureState CurrentState;
 
@@ -434,12 +795,7 @@ public:
 
 	inline float GetGestureDistance(FVector Seq1, FVector Seq2, bool bMirrorGesture = false)
 	{
-		if (bMirrorGesture)
-		{
-			return FVector::DistSquared(Seq1, FVector(Seq2.X, -Seq2.Y, Seq2.Z));
-		}
-
-		return FVector::DistSquared(Seq1, Seq2);
+		return FVRGestureMatcher::GetGestureDistance(Seq1, Seq2, bMirrorGesture);
 	}
 
 	void BeginDestroy() override
@@ -462,6 +818,21 @@ public:
 			InputGesture.CalculateSizeOfGesture(false);
 	}
 
+	// Loads a cooked gesture file into a transient database owned by this component and switches GesturesDB over to it,
+	// the previously assigned database is left untouched.
+	UFUNCTION(BlueprintCallable, Category = "VRGestures")
+	bool LoadCookedGestures(const FString & FilePath)
+	{
+		UGesturesDatabase * CookedDB = UGesturesDatabase::LoadCookedGestures(this, FilePath);
+		if (CookedDB == nullptr)
+			return false;
+
+		// Any detection still in flight was started against the old database
+		AsyncDetector.Reset();
+		GesturesDB = CookedDB;
+		return true;
+	}
+
 	// Draw a gesture with a debug line batch
 	UFUNCTION(BlueprintCallable, Category = "VRGestures", meta = (WorldContext = "WorldContextObject"))
 		void DrawDebugGesture(UObject* WorldContextObject, UPARAM(ref)FTransform& StartTransform, FVRGesture GestureToDraw, FColor const& Color, bool bPersistentLines = false, uint8 DepthPriority = 0, float LifeTime = -1.f, float Thickness = 0.f);
@@ -495,6 +866,9 @@ public:
 		this->SetComponentTickEnabled(false);
 		CurrentState = EVRGestureState::GES_None;
 
+		// Any detection still in flight finishes against its own copy and is thrown away
+		AsyncDetector.Reset();
+
 		// Reset the recording gesture
 		RecordingGestureDraw.Reset();
 
@@ -503,10 +877,7 @@ public:
 
 	// Clears the current recording
 	UFUNCTION(BlueprintCallable, Category = "VRGestures")
-	void ClearRecording()
-	{
-		GestureLog.Samples.Reset(RecordingBufferSize);
-	}
+	void ClearRecording();
 
 	// Saves a VRGesture to the database
 	UFUNCTION(BlueprintCallable, Category = "VRGestures")
@@ -517,6 +888,7 @@ public:
 			Recording.CalculateSizeOfGesture(true, GesturesDB->TargetGestureScale);
 			Recording.Name = RecordingName;
 			GesturesDB->Gestures.Add(Recording);
+			GesturesDB->MarkGesturesDirty();
 		}
 	}
 
@@ -529,11 +901,35 @@ public:
 	// Recognize gesture in the given sequence.
 	// It will always assume that the gesture ends on the last observation of that sequence.
 	// If the distance between the last observations of each sequence is too great, or if the overall DTW distance between the two sequences is too great, no gesture will be recognized.
-	void RecognizeGesture(FVRGesture inputGesture);
+	void RecognizeGesture(const FVRGesture & inputGesture);
 
 
 	// Compute the min DTW distance between seq2 and all possible endings of seq1.
-	float dtw(FVRGesture seq1, FVRGesture seq2, bool bMirrorGesture = false, float Scaler = 1.f);
+	float dtw(const FVRGesture & seq1, const FVRGesture & seq2, bool bMirrorGesture = false, float Scaler = 1.f);
+
+private:
+
+	// Matcher used for detection on the game thread
+	FVRGestureMatcher GestureMatcher;
+
+	// Set while detecting with bDetectGesturesAsync
+	TSharedPtr<FVRGestureAsyncDetector, ESPMode::ThreadSafe> AsyncDetector;
+
+	// Broadcasts a detection on the game thread and clears the recording, DetectedLog is the log the detection was made on.
+	// bClearAsyncDetector is false for detections from the async detector, it already cleared its own log when it made the detection.
+	void BroadcastGestureDetected(int GestureIndex, const FVRGesture & DetectedLog, bool bClearAsyncDetector = true);
+
+	// Packs the detected log and sends it to the server if bVerifyGesturesOnServer is set and this is an owning client
+	void SendGestureForVerification(int GestureIndex, const FVRGesture & DetectedLog);
+
+	// Runs the match on the servers database, returns true if the claimed gesture is the one that it finds
+	bool VerifyGesture(int GestureIndex, const FVRGestureSampleRep & GestureSamples);
+
+	// Broadcasts a verification result
+	void BroadcastGestureVerified(int GestureIndex, bool bVerified);
+
+	// Queues the newest sample to the async detector, kicks off a worker if one isn't running and broadcasts any finished detections
+	void TickAsyncDetection();
 
 };
 
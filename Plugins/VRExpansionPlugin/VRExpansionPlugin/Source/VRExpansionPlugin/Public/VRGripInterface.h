@@ -10,6 +10,17 @@
 #include "VRGripInterface.generated.h"
 
 
+// Per class cache of which classes implement the grip interface, saves walking the interface list of a class every time a grip is ticked.
+// Game thread only.
+struct VREXPANSIONPLUGIN_API FVRGripInterfaceClassCache
+{
+	static bool ImplementsGripInterface(UClass * Class);
+
+private:
+	// Weak keys so that a class that gets unloaded or reinstanced never hands its entry to a new class at the same address
+	static TMap<TWeakObjectPtr<UClass>, bool> ClassTable;
+};
+
 UINTERFACE(Blueprintable)
 class VREXPANSIONPLUGIN_API UVRGripInterface: public UInterface
 {
@@ -121,6 +121,19 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRExpansionLibrary")
 	TEnumAsByte<ECollisionChannel> WalkingCollisionOverride;
 
+	// If true (and using the walking collision override) the HMD movement sweep is skipped here while walking.
+	// The VR movement component resolves it off of its own move sweep instead, saving a scene query per frame.
+	// DifferenceFromLastFrame (and the replicated LFDiff) is then non zero every frame the HMD moves, the movement
+	// component keeps it out of Velocity. Frames split into several walking iterations fall back to sweeping it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "VRExpansionLibrary")
+	bool bDeferRelativeMovementSweep;
+
+	// Returns true if the HMD relative movement is being handed to the movement component to resolve
+	inline bool IsDeferringRelativeMovementSweep() const
+	{
+		return bUseWalkingCollisionOverride && bDeferRelativeMovementSweep;
+	}
+
 	/*ECollisionChannel GetVRCollisionObjectType()
 	{
 		if (bUseWalkingCollisionOverride)